@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <cmath>
+
+#include "DustFreeBitMask.h"
+#include "DustFreeParallel.h"
+
+namespace pcl
+{
+
+namespace
+{
+
+// Row bands of about 64K pixels per task.
+int RowGrain(int width)
+{
+    return std::max(1, 65536 / std::max(1, width));
+}
+
+// out |= in shifted by s pixels towards +x (s > 0) or -x (s < 0).
+void ShiftOr(const uint64_t* in, uint64_t* out, int words, int s)
+{
+    if (s == 0) {
+        for (int k = 0; k < words; k++)
+            out[k] |= in[k];
+        return;
+    }
+    const int n = std::abs(s);
+    const int ws = n >> 6;
+    const int bs = n & 63;
+    if (s > 0) {
+        for (int k = words - 1; k >= ws; k--) {
+            uint64_t v = in[k - ws] << bs;
+            if ((bs != 0) && (k - ws > 0))
+                v |= in[k - ws - 1] >> (64 - bs);
+            out[k] |= v;
+        }
+    } else {
+        for (int k = 0; k + ws < words; k++) {
+            uint64_t v = in[k + ws] >> bs;
+            if ((bs != 0) && (k + ws + 1 < words))
+                v |= in[k + ws + 1] << (64 - bs);
+            out[k] |= v;
+        }
+    }
+}
+
+// Horizontal dilation of a row by [-h, h], by doubling smears: log2(h) passes
+// in each direction. tmp must hold words words.
+void DilateRow(const uint64_t* in, uint64_t* out, uint64_t* tmp, int words, int h)
+{
+    std::copy(in, in + words, out);
+    for (int dir = -1; dir <= 1; dir += 2) {
+        std::copy(in, in + words, tmp);
+        for (int done = 0, step = 1; done < h; step *= 2) {
+            const int s = std::min(step, h - done);
+            ShiftOr(tmp, tmp, words, dir * s);
+            done += s;
+        }
+        for (int k = 0; k < words; k++)
+            out[k] |= tmp[k];
+    }
+}
+
+}	// namespace
+
+void DFBitMask::Allocate(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    m_wordsPerRow = (width + 63) >> 6;
+    m_words.assign(size_t(m_wordsPerRow) * height, 0);
+}
+
+template <typename T>
+void DFBitMask::Binarize(const T* plane, int width, int height, T threshold)
+{
+    Allocate(width, height);
+    DFParallelFor(height, [&](int y0, int y1) {
+        for (int y = y0; y < y1; y++) {
+            const T* p = plane + size_t(y) * width;
+            uint64_t* row = Row(y);
+            for (int k = 0; k < m_wordsPerRow; k++) {
+                const int n = std::min(64, width - 64 * k);
+                uint64_t word = 0;
+                for (int i = 0; i < n; i++)
+                    word |= uint64_t(p[i] >= threshold) << i;
+                row[k] = word;
+                p += n;
+            }
+        }
+    }, RowGrain(width));
+}
+
+void DFBitMask::Invert()
+{
+    const uint64_t tail = TailMask();
+    DFParallelFor(m_height, [&](int y0, int y1) {
+        for (int y = y0; y < y1; y++) {
+            uint64_t* row = Row(y);
+            for (int k = 0; k < m_wordsPerRow; k++)
+                row[k] = ~row[k];
+            row[m_wordsPerRow - 1] &= tail;
+        }
+    }, RowGrain(m_width));
+}
+
+void DFBitMask::Dilate(int diameter)
+{
+    const int r = diameter >> 1;
+    if ((r <= 0) || (m_width <= 0) || (m_height <= 0))
+        return;
+    if (r > DistanceDilationRadius) {
+        DilateByDistance(r);
+        return;
+    }
+
+    // Half width of the disc at each row offset, and one horizontally dilated
+    // copy of the mask per distinct half width.
+    std::vector<int> halfWidth(r + 1);
+    for (int dy = 0; dy <= r; dy++)
+        halfWidth[dy] = int(std::sqrt(double(r * (r + 1) - dy * dy)));
+
+    std::vector<int> levels(halfWidth);
+    std::sort(levels.begin(), levels.end());
+    levels.erase(std::unique(levels.begin(), levels.end()), levels.end());
+
+    const int words = m_wordsPerRow;
+    const size_t planeWords = m_words.size();
+    std::vector<uint64_t> dilated(levels.size() * planeWords);
+    DFParallelFor(m_height, [&](int y0, int y1) {
+        std::vector<uint64_t> tmp(words);
+        for (int y = y0; y < y1; y++)
+            for (size_t l = 0; l < levels.size(); l++) {
+                uint64_t* out = dilated.data() + l * planeWords + size_t(y) * words;
+                // Each level grows the one below it by the difference of half
+                // widths, as long as the shifted copies still overlap.
+                const int gap = (l > 0) ? levels[l] - levels[l - 1] : 0;
+                if ((l == 0) || (gap > 2 * levels[l - 1] + 1)) {
+                    DilateRow(Row(y), out, tmp.data(), words, levels[l]);
+                    continue;
+                }
+                const uint64_t* below = out - planeWords;
+                std::copy(below, below + words, out);
+                ShiftOr(below, out, words, gap);
+                ShiftOr(below, out, words, -gap);
+            }
+    }, RowGrain(m_width));
+
+    std::vector<const uint64_t*> source(r + 1);
+    for (int dy = 0; dy <= r; dy++)
+        source[dy] = dilated.data() + (std::lower_bound(levels.begin(), levels.end(), halfWidth[dy]) - levels.begin()) * planeWords;
+
+    const uint64_t tail = TailMask();
+    DFParallelFor(m_height, [&](int y0, int y1) {
+        for (int y = y0; y < y1; y++) {
+            uint64_t* row = Row(y);
+            std::fill(row, row + words, uint64_t(0));
+            for (int dy = -r; dy <= r; dy++) {
+                const int sy = y + dy;
+                if ((sy < 0) || (sy >= m_height))
+                    continue;
+                const uint64_t* s = source[std::abs(dy)] + size_t(sy) * words;
+                for (int k = 0; k < words; k++)
+                    row[k] |= s[k];
+            }
+            row[words - 1] &= tail;
+        }
+    }, RowGrain(m_width));
+}
+
+void DFBitMask::Median3x3()
+{
+    if ((m_width <= 0) || (m_height <= 0))
+        return;
+
+    const int words = m_wordsPerRow;
+    const int last = m_width - 1;
+    const uint64_t tail = TailMask();
+    DFBitMask out(m_width, m_height);
+    DFParallelFor(m_height, [&](int y0, int y1) {
+        for (int y = y0; y < y1; y++) {
+            const uint64_t* rows[3] = { Row((y > 0) ? y - 1 : std::min(1, m_height - 1)), Row(y),
+                                        Row((y < m_height - 1) ? y + 1 : std::max(m_height - 2, 0)) };
+            uint64_t* o = out.Row(y);
+            for (int k = 0; k < words; k++) {
+                uint64_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+                auto add = [&](uint64_t b) {
+                    uint64_t carry = c0 & b;
+                    c0 ^= b;
+                    uint64_t t = c1 & carry;
+                    c1 ^= carry;
+                    carry = t;
+                    t = c2 & carry;
+                    c2 ^= carry;
+                    c3 |= t;
+                };
+                for (const uint64_t* r : rows) {
+                    const uint64_t w = r[k];
+                    // Left and right neighbours of every bit, mirrored at the
+                    // ends of the row.
+                    uint64_t left = (w << 1) | ((k > 0) ? r[k - 1] >> 63 : (w >> std::min(last, 1)) & 1);
+                    uint64_t right = (w >> 1) | ((k + 1 < words) ? r[k + 1] << 63 : 0);
+                    if (k == (last >> 6)) {
+                        const int b = last & 63;
+                        const int m = std::max(last - 1, 0);
+                        const uint64_t mirror = (r[m >> 6] >> (m & 63)) & 1;
+                        right = (right & ~(uint64_t(1) << b)) | (mirror << b);
+                    }
+                    add(left);
+                    add(w);
+                    add(right);
+                }
+                // At least 5 of 9.
+                o[k] = c3 | (c2 & (c1 | c0));
+            }
+            o[words - 1] &= tail;
+        }
+    }, RowGrain(m_width));
+
+    m_words.swap(out.m_words);
+}
+
+void DFBitMask::DilateByDistance(int r)
+{
+    // Thresholded distance transform, separable like the exact one: for every
+    // row, the vertical distance to the nearest set pixel of each column is
+    // tracked, and a column at distance g <= r sets the horizontal run of half
+    // width sqrt(r*(r + 1) - g^2) around it. Pixels above and below are taken in
+    // two sweeps. Nothing depends on r but the length of the runs.
+    const int64_t r2 = int64_t(r) * (r + 1);
+    std::vector<int> halfWidth(r + 1);
+    for (int g = 0; g <= r; g++)
+        halfWidth[g] = int(std::sqrt(double(r2 - int64_t(g) * g)));
+
+    DFBitMask out(m_width, m_height);
+    const uint16_t none = uint16_t(r + 1);
+    DFParallelFor(m_height, [&](int y0, int y1) {
+        std::vector<uint16_t> distance(m_width);
+        auto advance = [&](int y) {
+            const uint64_t* row = Row(y);
+            for (int x = 0; x < m_width; x++)
+                distance[x] = ((row[x >> 6] >> (x & 63)) & 1) ? 0 : std::min<uint16_t>(distance[x] + 1, none);
+        };
+        auto emit = [&](int y) {
+            uint64_t* row = out.Row(y);
+            int ra = 0, rb = -2;
+            auto flush = [&]() {
+                for (int x = ra; x <= rb;) {
+                    const int k = x >> 6;
+                    const int n = std::min(rb - x + 1, 64 - (x & 63));
+                    row[k] |= ((n == 64) ? ~uint64_t(0) : ((uint64_t(1) << n) - 1)) << (x & 63);
+                    x += n;
+                }
+            };
+            for (int x = 0; x < m_width; x++) {
+                const int g = distance[x];
+                if (g > r)
+                    continue;
+                const int h = halfWidth[g];
+                const int a = std::max(x - h, 0);
+                const int b = std::min(x + h, m_width - 1);
+                if (a > rb + 1) {
+                    flush();
+                    ra = a;
+                    rb = b;
+                } else {
+                    ra = std::min(ra, a);
+                    rb = std::max(rb, b);
+                }
+            }
+            flush();
+        };
+
+        std::fill(distance.begin(), distance.end(), none);
+        for (int y = std::max(y0 - r, 0); y < y0; y++)
+            advance(y);
+        for (int y = y0; y < y1; y++) {
+            advance(y);
+            emit(y);
+        }
+
+        std::fill(distance.begin(), distance.end(), none);
+        for (int y = std::min(y1 + r, m_height) - 1; y >= y1; y--)
+            advance(y);
+        for (int y = y1 - 1; y >= y0; y--) {
+            advance(y);
+            emit(y);
+        }
+    }, std::max(RowGrain(m_width), 4 * r));
+
+    m_words.swap(out.m_words);
+}
+
+template <typename T>
+void DFBitMask::Select(T* plane) const
+{
+    DFParallelFor(m_height, [&](int y0, int y1) {
+        for (int y = y0; y < y1; y++) {
+            T* p = plane + size_t(y) * m_width;
+            const uint64_t* row = Row(y);
+            for (int k = 0; k < m_wordsPerRow; k++) {
+                const int n = std::min(64, m_width - 64 * k);
+                const uint64_t word = row[k];
+                const uint64_t full = (n == 64) ? ~uint64_t(0) : (uint64_t(1) << n) - 1;
+                if (word == 0)
+                    std::fill(p, p + n, T(0));
+                else if (word != full)
+                    for (int i = 0; i < n; i++)
+                        if (((word >> i) & 1) == 0)
+                            p[i] = T(0);
+                p += n;
+            }
+        }
+    }, RowGrain(m_width));
+}
+
+template void DFBitMask::Binarize<float>(const float*, int, int, float);
+template void DFBitMask::Binarize<double>(const double*, int, int, double);
+template void DFBitMask::Binarize<uint8_t>(const uint8_t*, int, int, uint8_t);
+template void DFBitMask::Binarize<uint16_t>(const uint16_t*, int, int, uint16_t);
+template void DFBitMask::Binarize<uint32_t>(const uint32_t*, int, int, uint32_t);
+template void DFBitMask::Select<float>(float*) const;
+template void DFBitMask::Select<double>(double*) const;
+
+}	// namespace pcl
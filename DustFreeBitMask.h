@@ -0,0 +1,106 @@
+#ifndef __DustFreeBitMask_h
+#define __DustFreeBitMask_h
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pcl
+{
+
+// Binary mask packed 64 pixels per word. Each row starts on a word boundary;
+// bit i of word k of a row is pixel 64*k + i, and the bits past the end of a
+// row are kept clear. Mask operations run a word at a time, on row bands
+// spread over the module thread pool.
+class DFBitMask
+{
+public:
+    DFBitMask() = default;
+
+    DFBitMask(int width, int height)
+    {
+        Allocate(width, height);
+    }
+
+    // Clears all pixels.
+    void Allocate(int width, int height);
+
+    int Width() const
+    {
+        return m_width;
+    }
+
+    int Height() const
+    {
+        return m_height;
+    }
+
+    int WordsPerRow() const
+    {
+        return m_wordsPerRow;
+    }
+
+    uint64_t* Row(int y)
+    {
+        return m_words.data() + size_t(y) * m_wordsPerRow;
+    }
+
+    const uint64_t* Row(int y) const
+    {
+        return m_words.data() + size_t(y) * m_wordsPerRow;
+    }
+
+    bool Get(int x, int y) const
+    {
+        return ((Row(y)[x >> 6] >> (x & 63)) & 1) != 0;
+    }
+
+    // Sets the pixels whose sample is greater than or equal to threshold, and
+    // clears the rest; the mask takes the geometry of the plane.
+    template <typename T>
+    void Binarize(const T* plane, int width, int height, T threshold);
+
+    void Invert();
+
+    // Morphological dilation by a disc of the given diameter: a pixel is set if
+    // any set pixel lies within dx^2 + dy^2 <= r*(r + 1), r = diameter/2.
+    // Small discs OR together shifted rows, at a cost proportional to r; larger
+    // ones threshold the Euclidean distance transform of the mask, at a cost
+    // that does not depend on r. Both give the same mask.
+    void Dilate(int diameter);
+
+    // 3x3 median filter. On a binary mask the median is the majority of the
+    // nine neighbours, which is counted a word at a time with bit-sliced
+    // adders. Borders are mirrored.
+    void Median3x3();
+
+    // Multiply-as-select: zeroes the samples of plane, which has the geometry
+    // of the mask, where the mask is clear.
+    template <typename T>
+    void Select(T* plane) const;
+
+    size_t MemorySize() const
+    {
+        return m_words.size() * sizeof(uint64_t);
+    }
+
+private:
+    // Disc radius above which Dilate() goes through the distance transform.
+    static constexpr int DistanceDilationRadius = 32;
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_wordsPerRow = 0;
+    std::vector<uint64_t> m_words;
+
+    void DilateByDistance(int r);
+
+    uint64_t TailMask() const
+    {
+        return ((m_width & 63) != 0) ? (uint64_t(1) << (m_width & 63)) - 1 : ~uint64_t(0);
+    }
+};
+
+}	// namespace pcl
+
+#endif	// __DustFreeBitMask_h
@@ -0,0 +1,105 @@
+#ifndef __DustFreeCache_h
+#define __DustFreeCache_h
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace pcl
+{
+
+// Results of pipeline stages, keyed by a hash of everything they depend on,
+// and bounded by their total size in bytes. When a new result does not fit,
+// the least recently used ones are evicted; results larger than the whole
+// capacity are not kept. Not thread safe.
+template <class Value>
+class DFStageCache
+{
+public:
+    // Sets the capacity, evicting results as needed. Zero disables the cache.
+    void SetCapacity(size_t bytes)
+    {
+        m_capacity = bytes;
+        Evict(0);
+    }
+
+    // The result stored under key, or nullptr. A hit makes it the most
+    // recently used.
+    const Value* Find(uint64_t key)
+    {
+        auto i = m_index.find(key);
+        if (i == m_index.end())
+            return nullptr;
+        m_entries.splice(m_entries.begin(), m_entries, i->second);
+        return &i->second->value;
+    }
+
+    void Insert(uint64_t key, Value value, size_t bytes)
+    {
+        Erase(key);
+        if (bytes > m_capacity)
+            return;
+        Evict(bytes);
+        m_entries.push_front(Entry{ key, std::move(value), bytes });
+        m_index[key] = m_entries.begin();
+        m_size += bytes;
+    }
+
+    void Erase(uint64_t key)
+    {
+        auto i = m_index.find(key);
+        if (i != m_index.end()) {
+            m_size -= i->second->bytes;
+            m_entries.erase(i->second);
+            m_index.erase(i);
+        }
+    }
+
+    void Clear()
+    {
+        m_entries.clear();
+        m_index.clear();
+        m_size = 0;
+    }
+
+    size_t Size() const
+    {
+        return m_size;
+    }
+
+    size_t Length() const
+    {
+        return m_entries.size();
+    }
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        Value value;
+        size_t bytes;
+    };
+
+    std::list<Entry> m_entries;
+    std::unordered_map<uint64_t, typename std::list<Entry>::iterator> m_index;
+    size_t m_capacity = 0;
+    size_t m_size = 0;
+
+    // Evicts least recently used results until bytes more fit.
+    void Evict(size_t bytes)
+    {
+        while (!m_entries.empty() && (m_size + bytes > m_capacity)) {
+            const Entry& last = m_entries.back();
+            m_size -= last.bytes;
+            m_index.erase(last.key);
+            m_entries.pop_back();
+        }
+    }
+};
+
+}	// namespace pcl
+
+#endif	// __DustFreeCache_h
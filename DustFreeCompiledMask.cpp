@@ -0,0 +1,137 @@
+#include <cstring>
+
+#include "DustFreeCompiledMask.h"
+
+namespace pcl
+{
+
+namespace
+{
+
+const char Magic[8] = { 'D', 'F', 'M', 'A', 'S', 'K', '0', '1' };
+
+class Writer
+{
+public:
+    std::vector<uint8_t> bytes;
+
+    void Put(const void* data, size_t size)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        bytes.insert(bytes.end(), p, p + size);
+    }
+
+    template <typename T>
+    void Put(T value)
+    {
+        Put(&value, sizeof(value));
+    }
+};
+
+class Reader
+{
+public:
+    Reader(const uint8_t* data, size_t size) : m_data(data), m_end(data + size)
+    {
+    }
+
+    bool Get(void* data, size_t size)
+    {
+        if (size_t(m_end - m_data) < size)
+            return false;
+        std::memcpy(data, m_data, size);
+        m_data += size;
+        return true;
+    }
+
+    template <typename T>
+    bool Get(T& value)
+    {
+        return Get(&value, sizeof(value));
+    }
+
+    size_t Remaining() const
+    {
+        return size_t(m_end - m_data);
+    }
+
+private:
+    const uint8_t* m_data;
+    const uint8_t* m_end;
+};
+
+}	// namespace
+
+std::vector<uint8_t> DFCompiledMask::Serialize() const
+{
+    Writer w;
+    w.Put(Magic, sizeof(Magic));
+    w.Put(source);
+    w.Put(int32_t(width));
+    w.Put(int32_t(height));
+    w.Put(int32_t(hasComponents ? components.size() : -1));
+    if (hasComponents)
+        for (const DFRect& r : components) {
+            w.Put(int32_t(r.x0));
+            w.Put(int32_t(r.y0));
+            w.Put(int32_t(r.x1));
+            w.Put(int32_t(r.y1));
+        }
+    w.Put(int32_t(levels.size()));
+    for (const auto& level : levels) {
+        w.Put(int32_t(level.first));
+        w.Put(int32_t(level.second.size()));
+        for (const DFBitMask& m : level.second) {
+            w.Put(int32_t(m.Width()));
+            w.Put(int32_t(m.Height()));
+            for (int y = 0; y < m.Height(); y++)
+                w.Put(m.Row(y), m.WordsPerRow() * sizeof(uint64_t));
+        }
+    }
+    return w.bytes;
+}
+
+bool DFCompiledMask::Deserialize(const uint8_t* data, size_t size)
+{
+    *this = DFCompiledMask();
+    Reader r(data, size);
+    char magic[sizeof(Magic)];
+    int32_t w = 0, h = 0, count = 0;
+    if (!r.Get(magic, sizeof(magic)) || (std::memcmp(magic, Magic, sizeof(Magic)) != 0) ||
+        !r.Get(source) || !r.Get(w) || !r.Get(h) || !r.Get(count))
+        return false;
+    width = w;
+    height = h;
+
+    bool ok = true;
+    hasComponents = count >= 0;
+    for (int32_t i = 0; ok && (i < count); i++) {
+        int32_t x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+        ok = r.Get(x0) && r.Get(y0) && r.Get(x1) && r.Get(y1);
+        components.push_back(DFRect{ x0, y0, x1, y1 });
+    }
+
+    int32_t levelCount = 0;
+    ok = ok && r.Get(levelCount);
+    for (int32_t i = 0; ok && (i < levelCount); i++) {
+        int32_t factor = 0, channels = 0;
+        ok = r.Get(factor) && r.Get(channels) && (channels > 0);
+        std::vector<DFBitMask>& masks = levels[factor];
+        for (int32_t c = 0; ok && (c < channels); c++) {
+            int32_t mw = 0, mh = 0;
+            ok = r.Get(mw) && r.Get(mh) && (mw >= 0) && (mh >= 0) &&
+                 (size_t((mw + 63) >> 6) * mh * sizeof(uint64_t) <= r.Remaining());
+            if (ok) {
+                masks.emplace_back(mw, mh);
+                DFBitMask& m = masks.back();
+                for (int y = 0; ok && (y < mh); y++)
+                    ok = r.Get(m.Row(y), m.WordsPerRow() * sizeof(uint64_t));
+            }
+        }
+    }
+    if (!ok)
+        *this = DFCompiledMask();
+    return ok;
+}
+
+}	// namespace pcl
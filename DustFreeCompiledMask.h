@@ -0,0 +1,38 @@
+#ifndef __DustFreeCompiledMask_h
+#define __DustFreeCompiledMask_h
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "DustFreeBitMask.h"
+#include "DustFreeRegions.h"
+
+namespace pcl
+{
+
+// Everything the pipeline derives from a dust mask alone, for a given image
+// geometry: the dust-free bit masks, one per channel of the mask, at each
+// downsampling level used so far, and the bounding boxes of the connected
+// components of the mask at full resolution. It is compiled once and stored,
+// so that later runs with the same mask skip resampling, binarization and
+// labelling.
+struct DFCompiledMask
+{
+    uint64_t source = 0;    // revision of the mask it was compiled from
+    int width = 0;          // size of the images it applies to
+    int height = 0;
+    bool hasComponents = false;
+    std::vector<DFRect> components;
+    std::map<int, std::vector<DFBitMask>> levels;   // by downsampling factor
+
+    // Flat little-endian byte stream. Deserialize() returns false, leaving the
+    // object empty, if the data is not a compiled mask or is truncated.
+    std::vector<uint8_t> Serialize() const;
+    bool Deserialize(const uint8_t* data, size_t size);
+};
+
+}	// namespace pcl
+
+#endif	// __DustFreeCompiledMask_h
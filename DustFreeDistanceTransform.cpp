@@ -0,0 +1,59 @@
+#include <limits>
+#include <vector>
+
+#include "DustFreeDistanceTransform.h"
+
+namespace pcl
+{
+
+template <typename Index>
+void DFFeatureTransformRows(int width, int height, Index* sites)
+{
+    DFParallelFor(height, [&](int begin, int end) {
+        const double infinity = std::numeric_limits<double>::infinity();
+        std::vector<Index> g(width);
+        std::vector<int32_t> v(width);
+        std::vector<double> z(size_t(width) + 1);
+        for (int y = begin; y < end; y++) {
+            Index* row = sites + size_t(y) * width;
+            std::copy(row, row + width, g.begin());
+            auto f = [&](int q) {
+                double d = double(g[q] - y);
+                return d * d + double(q) * q;
+            };
+
+            int k = -1;
+            for (int q = 0; q < width; q++) {
+                if (g[q] < 0)
+                    continue;
+                double fq = f(q);
+                double s = -infinity;
+                while (k >= 0) {
+                    s = (fq - f(v[k])) / (2.0 * (q - v[k]));
+                    if (s <= z[k])
+                        k--;
+                    else
+                        break;
+                }
+                v[++k] = q;
+                z[k] = (k == 0) ? -infinity : s;
+            }
+
+            if (k < 0) {
+                std::fill(row, row + width, -1);
+                continue;
+            }
+            z[k + 1] = infinity;
+            for (int x = 0, j = 0; x < width; x++) {
+                while (z[j + 1] < x)
+                    j++;
+                row[x] = g[v[j]] * Index(width) + v[j];
+            }
+        }
+    }, 8);
+}
+
+template void DFFeatureTransformRows<int32_t>(int, int, int32_t*);
+template void DFFeatureTransformRows<int64_t>(int, int, int64_t*);
+
+}	// namespace pcl
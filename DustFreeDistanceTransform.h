@@ -0,0 +1,77 @@
+#ifndef __DustFreeDistanceTransform_h
+#define __DustFreeDistanceTransform_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "DustFreeParallel.h"
+
+namespace pcl
+{
+
+// Site indices are linear pixel indices: 32 bits address images of up to
+// 2^31 - 1 pixels, larger ones need 64-bit sites.
+template <typename Index>
+inline bool DFSiteIndexFits(int width, int height)
+{
+    return uint64_t(width) * uint64_t(height) <= uint64_t(std::numeric_limits<Index>::max());
+}
+
+// First pass of the feature transform: for every pixel, rows[] receives the row
+// index of the nearest valid pixel in the same column, or -1 if the column has
+// no valid pixels. Columns are processed in strips so that both sweeps walk the
+// image row by row.
+template <typename Index, class IsValid>
+void DFNearestValidRows(int width, int height, const IsValid& isValid, Index* rows)
+{
+    const int strip = 64;
+    DFParallelFor((width + strip - 1) / strip, [&](int begin, int end) {
+        Index next[strip];
+        for (int s = begin; s < end; s++) {
+            const int x0 = s * strip;
+            const int n = std::min(strip, width - x0);
+            for (int i = 0; i < n; i++)
+                rows[x0 + i] = isValid(x0 + i, 0) ? 0 : -1;
+            for (int y = 1; y < height; y++) {
+                Index* r = rows + size_t(y) * width + x0;
+                const Index* up = r - width;
+                for (int i = 0; i < n; i++)
+                    r[i] = isValid(x0 + i, y) ? y : up[i];
+            }
+            for (int i = 0; i < n; i++)
+                next[i] = -1;
+            for (int y = height - 1; y >= 0; y--) {
+                Index* r = rows + size_t(y) * width + x0;
+                for (int i = 0; i < n; i++)
+                    if (r[i] == y)
+                        next[i] = y;
+                    else if ((next[i] >= 0) && ((r[i] < 0) || (next[i] - y < y - r[i])))
+                        r[i] = next[i];
+            }
+        }
+    });
+}
+
+// Second pass of the feature transform: converts the per-column nearest rows
+// produced by DFNearestValidRows, in place, into linear indices y*width + x of
+// the nearest valid pixel (lower envelope of parabolas, one row at a time).
+// Index is int32_t or int64_t; see DFSiteIndexFits.
+template <typename Index>
+void DFFeatureTransformRows(int width, int height, Index* sites);
+
+// Exact Euclidean feature transform (Felzenszwalb & Huttenlocher). For every
+// pixel, sites[] receives the linear index of the nearest pixel for which
+// isValid(x, y) is true, or -1 if there is no valid pixel at all. The cost is
+// linear in the number of pixels. isValid is called concurrently.
+template <typename Index, class IsValid>
+void DFFeatureTransform(int width, int height, const IsValid& isValid, Index* sites)
+{
+    DFNearestValidRows(width, height, isValid, sites);
+    DFFeatureTransformRows(width, height, sites);
+}
+
+}	// namespace pcl
+
+#endif	// __DustFreeDistanceTransform_h
@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "DustFreeDistanceTransform.h"
+#include "DustFreeInpaint.h"
+#include "DustFreeParallel.h"
+#include "DustFreeProfile.h"
+
+namespace pcl
+{
+
+namespace
+{
+
+inline double Clamp(double x, double a, double b)
+{
+    return (x < a) ? a : ((x > b) ? b : x);
+}
+
+struct DFProbeDirections
+{
+    static const int count = 16;
+    float dx[count];
+    float dy[count];
+
+    DFProbeDirections()
+    {
+        for (int i = 0; i < count; i++) {
+            double a = 6.283185307179586 * i / count;
+            dx[i] = float(std::cos(a));
+            dy[i] = float(std::sin(a));
+        }
+    }
+};
+
+template <typename T>
+struct DFPyramidLevel
+{
+    int width;
+    int height;
+    std::vector<T> value;
+    std::vector<float> weight;
+
+    DFPyramidLevel(int w, int h)
+        : width(w)
+        , height(h)
+        , value(size_t(w) * h)
+        , weight(size_t(w) * h)
+    {
+    }
+
+    // Bilinear interpolation at the position of pixel (x, y) of the level below.
+    double Upsample(int x, int y) const
+    {
+        double fx = Clamp(0.5 * x - 0.25, 0.0, double(width - 1));
+        double fy = Clamp(0.5 * y - 0.25, 0.0, double(height - 1));
+        int x0 = int(fx);
+        int y0 = int(fy);
+        int x1 = std::min(x0 + 1, width - 1);
+        int y1 = std::min(y0 + 1, height - 1);
+        double ax = fx - x0;
+        double ay = fy - y0;
+        const T* r0 = value.data() + size_t(y0) * width;
+        const T* r1 = value.data() + size_t(y1) * width;
+        return (1 - ay) * ((1 - ax) * r0[x0] + ax * r0[x1]) + ay * ((1 - ax) * r1[x0] + ax * r1[x1]);
+    }
+};
+
+}	// namespace
+
+template <typename T>
+void DFHoleSpans::Build(const T* const* input, int channels, int w, int h)
+{
+    width = w;
+    height = h;
+
+    // Rows are scanned in bands, each into its own span list, and the lists are
+    // concatenated in order.
+    const int bandCount = std::max(1, std::min(height, 4 * DFParallelThreadCount()));
+    std::vector<std::vector<Span>> bandSpans(bandCount);
+    std::vector<size_t> rowCount(size_t(height) + 1, 0);
+    DFParallelFor(bandCount, [&](int begin, int end) {
+        for (int b = begin; b < end; b++) {
+            const int y0 = int(int64_t(height) * b / bandCount);
+            const int y1 = int(int64_t(height) * (b + 1) / bandCount);
+            std::vector<Span>& list = bandSpans[b];
+            for (int y = y0; y < y1; y++) {
+                const size_t row = size_t(y) * width;
+                auto isHole = [&](int x) {
+                    for (int c = 0; c < channels; c++)
+                        if (!(input[c][row + x] > 0))
+                            return true;
+                    return false;
+                };
+                const size_t first = list.size();
+                for (int x = 0; x < width;) {
+                    if (!isHole(x)) {
+                        x++;
+                        continue;
+                    }
+                    Span s;
+                    s.x0 = x;
+                    while ((x < width) && isHole(x))
+                        x++;
+                    s.x1 = x;
+                    list.push_back(s);
+                }
+                rowCount[size_t(y) + 1] = list.size() - first;
+            }
+        }
+    });
+
+    rowStart.resize(size_t(height) + 1);
+    rowStart[0] = 0;
+    for (int y = 0; y < height; y++)
+        rowStart[y + 1] = rowStart[y] + rowCount[size_t(y) + 1];
+    spans.clear();
+    spans.reserve(rowStart[height]);
+    holes = 0;
+    for (const std::vector<Span>& list : bandSpans)
+        for (const Span& s : list) {
+            spans.push_back(s);
+            holes += size_t(s.x1 - s.x0);
+        }
+}
+
+namespace
+{
+
+template <typename T, typename Index>
+void InpaintNearestSample(const T* input, T* output, int width, int height, DFInpaintCounter* counter)
+{
+    std::vector<Index> sites(size_t(width) * height);
+    DFFeatureTransform(width, height, [input, width](int x, int y) {
+        return input[size_t(y) * width + x] > 0;
+    }, sites.data());
+
+    static const DFProbeDirections directions;
+    DFParallelFor(height, [&](int begin, int end) {
+        DFInpaintCounts counts;
+        for (int y = begin; y < end; y++) {
+            const T* in = input + size_t(y) * width;
+            const Index* site = sites.data() + size_t(y) * width;
+            T* out = output + size_t(y) * width;
+            for (int x = 0; x < width; x++) {
+                if (in[x] > 0) {
+                    out[x] = in[x];
+                    continue;
+                }
+                counts.holePixels++;
+                if (site[x] < 0) {
+                    out[x] = 0;
+                    continue;
+                }
+
+                double p = 0;
+                double w0 = 0;
+                auto accumulate = [&](Index s) {
+                    int dx = int(s % width) - x;
+                    int dy = int(s / width) - y;
+                    double w = 1.0 / std::sqrt(double(dx) * dx + double(dy) * dy);
+                    p += input[s] * w;
+                    w0 += w;
+                };
+
+                accumulate(site[x]);
+                int dx = int(site[x] % width) - x;
+                int dy = int(site[x] / width) - y;
+                float d = std::sqrt(float(dx) * dx + float(dy) * dy);
+                for (int r = 1; r <= 2; r++)
+                    for (int i = 0; i < directions.count; i++) {
+                        int px = int(std::floor(x + r * d * directions.dx[i] + 0.5f));
+                        int py = int(std::floor(y + r * d * directions.dy[i] + 0.5f));
+                        px = std::min(std::max(px, 0), width - 1);
+                        py = std::min(std::max(py, 0), height - 1);
+                        accumulate(sites[size_t(py) * width + px]);
+                    }
+                out[x] = T(p / w0);
+            }
+        }
+        if (counter != nullptr)
+            counter->Add(counts);
+    }, 8);
+}
+
+}	// namespace
+
+template <typename T>
+void DFInpaintNearestSample(const T* input, T* output, int width, int height, DFInpaintCounter* counter)
+{
+    // 32-bit sites halve the memory of the transform up to 2^31 pixels.
+    if (DFSiteIndexFits<int32_t>(width, height))
+        InpaintNearestSample<T, int32_t>(input, output, width, height, counter);
+    else
+        InpaintNearestSample<T, int64_t>(input, output, width, height, counter);
+}
+
+template <typename T>
+void DFInpaintPushPull(const T* input, T* output, int width, int height, DFInpaintCounter* counter)
+{
+    std::vector<DFPyramidLevel<T>> levels;
+    for (int w = width, h = height; (w > 1) || (h > 1);) {
+        w = (w + 1) >> 1;
+        h = (h + 1) >> 1;
+        levels.emplace_back(w, h);
+    }
+
+    // Push: coverage-weighted 2x2 averages, coverage clamped to one.
+    for (size_t l = 0; l < levels.size(); l++) {
+        DFPyramidLevel<T>& coarse = levels[l];
+        const DFPyramidLevel<T>* fine = (l > 0) ? &levels[l - 1] : nullptr;
+        const int fineWidth = (fine != nullptr) ? fine->width : width;
+        const int fineHeight = (fine != nullptr) ? fine->height : height;
+        DFParallelFor(coarse.height, [&](int begin, int end) {
+            for (int y = begin; y < end; y++)
+                for (int x = 0; x < coarse.width; x++) {
+                    double v = 0;
+                    double w = 0;
+                    for (int sy = 2 * y; sy < std::min(2 * y + 2, fineHeight); sy++)
+                        for (int sx = 2 * x; sx < std::min(2 * x + 2, fineWidth); sx++) {
+                            size_t i = size_t(sy) * fineWidth + sx;
+                            if (fine == nullptr) {
+                                if (input[i] > 0) {
+                                    v += input[i];
+                                    w += 1;
+                                }
+                            } else {
+                                v += fine->weight[i] * double(fine->value[i]);
+                                w += fine->weight[i];
+                            }
+                        }
+                    size_t i = size_t(y) * coarse.width + x;
+                    coarse.value[i] = T((w > 0) ? v / w : 0.0);
+                    coarse.weight[i] = float(std::min(w, 1.0));
+                }
+        }, 16);
+    }
+
+    // Pull: fill incomplete coverage from the level above, coarse to fine.
+    for (size_t l = levels.size(); l-- > 1;) {
+        const DFPyramidLevel<T>& coarse = levels[l];
+        DFPyramidLevel<T>& fine = levels[l - 1];
+        DFParallelFor(fine.height, [&](int begin, int end) {
+            for (int y = begin; y < end; y++)
+                for (int x = 0; x < fine.width; x++) {
+                    size_t i = size_t(y) * fine.width + x;
+                    float w = fine.weight[i];
+                    if (w < 1)
+                        fine.value[i] = T(w * double(fine.value[i]) + (1 - w) * coarse.Upsample(x, y));
+                }
+        }, 16);
+    }
+
+    DFParallelFor(height, [&](int begin, int end) {
+        DFInpaintCounts counts;
+        for (int y = begin; y < end; y++) {
+            const T* in = input + size_t(y) * width;
+            T* out = output + size_t(y) * width;
+            for (int x = 0; x < width; x++)
+                if (in[x] > 0)
+                    out[x] = in[x];
+                else {
+                    out[x] = levels.empty() ? T(0) : T(levels.front().Upsample(x, y));
+                    counts.holePixels++;
+                }
+        }
+        if (counter != nullptr)
+            counter->Add(counts);
+    }, 8);
+}
+
+template void DFHoleSpans::Build<float>(const float* const*, int, int, int);
+template void DFHoleSpans::Build<double>(const double* const*, int, int, int);
+template void DFInpaintNearestSample<float>(const float*, float*, int, int, DFInpaintCounter*);
+template void DFInpaintNearestSample<double>(const double*, double*, int, int, DFInpaintCounter*);
+template void DFInpaintPushPull<float>(const float*, float*, int, int, DFInpaintCounter*);
+template void DFInpaintPushPull<double>(const double*, double*, int, int, DFInpaintCounter*);
+
+}	// namespace pcl
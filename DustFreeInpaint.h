@@ -0,0 +1,107 @@
+#ifndef __DustFreeInpaint_h
+#define __DustFreeInpaint_h
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pcl
+{
+
+class DFInpaintCounter;
+
+// Run-length index of the holes of a plane: the spans of row y are
+// spans[rowStart[y]] .. spans[rowStart[y+1]-1], sorted by x.
+struct DFHoleSpans
+{
+    struct Span
+    {
+        int32_t x0;    // first hole
+        int32_t x1;    // one past the last hole
+    };
+
+    int width = 0;
+    int height = 0;
+    size_t holes = 0;
+    std::vector<size_t> rowStart;
+    std::vector<Span> spans;
+
+    // A pixel is a hole if any of the channels is.
+    template <typename T>
+    void Build(const T* const* input, int channels, int width, int height);
+
+    template <typename T>
+    void Build(const T* input, int width, int height)
+    {
+        Build(&input, 1, width, height);
+    }
+
+    const Span* RowBegin(int y) const
+    {
+        return spans.data() + rowStart[y];
+    }
+
+    const Span* RowEnd(int y) const
+    {
+        return spans.data() + rowStart[y + 1];
+    }
+};
+
+// Inpainting engines. All of them work on a single channel plane of width x
+// height samples: samples greater than zero are copied to the output unchanged,
+// the rest (holes) are filled from the valid samples around them. When a
+// counter is given, the engines add their inpainting counts to it.
+
+// Reference ray march: 32 rays are cast from each hole, walking unit steps up
+// to 16 pixels and a 1.1 geometric progression beyond; the first valid sample
+// met by each ray is averaged with a 1/distance weight. Ray geometry is
+// tabulated once per image, as displacements rounded from the ray offsets
+// alone: past 8192 columns the original march, which rounds x plus the offset
+// in single precision, can land a probe on the next pixel. Float planes are marched 8 (AVX2) or 16
+// (AVX-512) adjacent pixels at a time when the processor supports them.
+// Valid samples are copied in bulk; only the spans of a DFHoleSpans index are
+// marched, with work distributed by hole count rather than by rows.
+// With tiled = true the plane is traversed in 128x128 tiles, each marched against
+// a cache-resident copy of the tile and a halo sized from the longest hole run;
+// only rays leaving the halo read the full plane. Both traversals give the same
+// result up to the rounding of the last bit.
+template <typename T>
+void DFInpaintRayMarch(const T* input, T* output, int width, int height, bool tiled = true,
+    DFInpaintCounter* counter = nullptr);
+
+// Instruction set of the batched ray march, detected once from the processor.
+// DFLimitRayMarchSimd caps it, so that tests and benchmarks can run the
+// narrower paths on any machine.
+enum class DFSimd { Scalar, AVX2, AVX512 };
+
+DFSimd DFRayMarchSimd();
+void DFLimitRayMarchSimd(DFSimd limit);
+
+// Channel-fused ray march over channels planes of the same geometry. Each ray is
+// walked once for all channels, gathering every channel's sample at each step;
+// a channel leaves the walk at its own first valid sample, so channels whose
+// holes differ still get exactly their single-channel result. Hole spans are
+// the union of the channel holes.
+template <typename T>
+void DFInpaintRayMarch(const T* const* input, T* const* output, int channels, int width, int height, bool tiled = true,
+    DFInpaintCounter* counter = nullptr);
+
+// Fills each hole from the nearest valid samples found through an exact
+// Euclidean feature transform. Besides the nearest sample itself, the sites of
+// two rings of probes at one and two times the hole distance are blended with
+// 1/distance weights, which mimics the ray march without walking any ray. The
+// cost is linear in the number of pixels, whatever the size of the holes.
+template <typename T>
+void DFInpaintNearestSample(const T* input, T* output, int width, int height, DFInpaintCounter* counter = nullptr);
+
+// Push-pull (coarse-to-fine masked pyramid) inpainting. The push phase builds a
+// mip pyramid of coverage-weighted averages; the pull phase walks back down,
+// blending each level with the bilinear upsampling of the level above wherever
+// its coverage is incomplete. Each level costs a single pass, so the whole fill
+// is linear in the number of pixels and holes of any size are closed smoothly.
+template <typename T>
+void DFInpaintPushPull(const T* input, T* output, int width, int height, DFInpaintCounter* counter = nullptr);
+
+}	// namespace pcl
+
+#endif	// __DustFreeInpaint_h
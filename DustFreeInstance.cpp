@@ -1,384 +1,1499 @@
-#include <random>
-#include <pcl/AutoViewLock.h>
-#include <pcl/Console.h>
-#include <pcl/FFTConvolution.h>
-#include <pcl/IntegerResample.h>
-#include <pcl/MorphologicalTransformation.h>
-#include <pcl/MultiscaleLinearTransform.h>
-#include <pcl/PixelInterpolation.h>
-#include <pcl/Resample.h>
-#include <pcl/StandardStatus.h>
-#include <pcl/VariableShapeFilter.h>
-#include <pcl/View.h>
-
-#include "DustFreeInstance.h"
-#include "DustFreeParameters.h"
-
-namespace pcl
-{
-
-template <class P>
-class DustFreeThread : public Thread
-{
-public:
-    typedef void(*LineProcessFunc)(DustFreeInstance* superFlat, ReferenceArray<GenericImage<P>>&, GenericImage<P>&, int, int);
-
-    DustFreeThread(int id, LineProcessFunc lineProcessFunc, const AbstractImage::ThreadData& data, DustFreeInstance* superFlat,
-        ReferenceArray<GenericImage<P>>& srcImages, GenericImage<P>& dstImage,
-        int channel, int firstRow, int endRow)
-        : m_id(id)
-        , m_lineProcessFunc(lineProcessFunc)
-        , m_data(data)
-        , m_superFlat(superFlat)
-        , m_srcImages(srcImages)
-        , m_dstImage(dstImage)
-        , m_channel(channel)
-        , m_firstRow(firstRow)
-        , m_endRow(endRow)
-        , m_threadErrorMsg("")
-    {
-    }
-
-    void Run() override
-    {
-        INIT_THREAD_MONITOR();
-        try {
-            for (int y = m_firstRow; y < m_endRow; y++) {
-                m_lineProcessFunc(m_superFlat, m_srcImages, m_dstImage, y, m_channel);
-                UPDATE_THREAD_MONITOR(65536);
-            }
-        }
-        catch (...) {
-            volatile AutoLock lock(m_data.mutex);
-            try {
-                throw;
-            }
-            catch (Exception & x) {
-                m_threadErrorMsg = x.Message();
-            }
-            catch (std::bad_alloc&) {
-                m_threadErrorMsg = "Out of memory";
-            }
-            catch (...) {
-                m_threadErrorMsg = "Unknown error";
-            }
-        }
-    }
-
-    static void dispatch(LineProcessFunc lineProcessFunc, DustFreeInstance* superFlat,
-        ReferenceArray<GenericImage<P>>& srcImages, GenericImage<P>& dstImage, int channel)
-    {
-        Array<size_type> L = Thread::OptimalThreadLoads(dstImage.Height(), 1, PCL_MAX_PROCESSORS);
-        ReferenceArray<DustFreeThread> threads;
-        AbstractImage::ThreadData data(dstImage, dstImage.NumberOfPixels());
-        for (int i = 0, n = 0; i < int(L.Length()); n += int(L[i++]))
-            threads << new DustFreeThread(i, lineProcessFunc, data, superFlat, srcImages, dstImage, channel, n, n + int(L[i]));
-        AbstractImage::RunThreads(threads, data);
-        for (DustFreeThread& t : threads)
-            if (t.m_threadErrorMsg != "")
-                throw Error(t.m_threadErrorMsg);
-        threads.Destroy();
-        dstImage.Status() = data.status;
-    }
-
-private:
-    int m_id;
-    LineProcessFunc m_lineProcessFunc;
-    const AbstractImage::ThreadData& m_data;
-    DustFreeInstance* m_superFlat;
-    ReferenceArray<GenericImage<P>>& m_srcImages;
-    GenericImage<P>& m_dstImage;
-    int m_channel;
-    int m_firstRow;
-    int m_endRow;
-    String m_threadErrorMsg;
-};
-
-DustFreeInstance::DustFreeInstance(const MetaProcess* m)
-    : ProcessImplementation(m)
-    , starDetectionSensitivity(TheDFStarDetectionSensitivityParameter->DefaultValue())
-    , starDiffusionDistance(TheDFStarDiffusionDistanceParameter->DefaultValue())
-    , dustMaskViewId()
-    , smoothness(TheDFSmoothnessParameter->DefaultValue())
-    , downsample(TheDFDownsampleParameter->DefaultValue())
-    , testSkyDetection(TheDFTestSkyDetectionParameter->DefaultValue())
-{
-}
-
-DustFreeInstance::DustFreeInstance(const DustFreeInstance& x)
-    : ProcessImplementation(x)
-{
-    Assign(x);
-}
-
-void DustFreeInstance::Assign(const ProcessImplementation& p)
-{
-    const DustFreeInstance* x = dynamic_cast<const DustFreeInstance*>(&p);
-    if (x != nullptr) {
-        starDetectionSensitivity = x->starDetectionSensitivity;
-        starDiffusionDistance = x->starDiffusionDistance;
-        smoothness = x->smoothness;
-    }
-}
-
-bool DustFreeInstance::IsHistoryUpdater(const View& view) const
-{
-    return true;
-}
-
-UndoFlags DustFreeInstance::UndoMode(const View&) const
-{
-    return UndoFlag::PixelData;
-}
-
-bool DustFreeInstance::CanExecuteOn(const View& view, pcl::String& whyNot) const
-{
-    if (view.Image().IsComplexSample())
-    {
-        whyNot = "DustFree cannot be executed on complex images.";
-        return false;
-    } else if (!view.Image().IsFloatSample()) {
-        whyNot = "DustFree can only be executed on float images.";
-        return false;
-    }
-
-    return true;
-}
-
-bool DustFreeInstance::ExecuteOn(View& view)
-{
-    AutoViewLock lock(view);
-
-    StandardStatus status;
-    Console console;
-
-    console.EnableAbort();
-
-    ImageVariant image = view.Image();
-
-    if (image.IsComplexSample() || !view.Image().IsFloatSample())
-        return false;
-
-    View dustMaskView;
-    if (dustMaskViewId.IsEmpty()) {
-        throw Error("No dust mask selected");
-    } else {
-        dustMaskView = View::ViewById(dustMaskViewId);
-        if (dustMaskView.IsNull())
-            throw Error("No such view (dust mask): " + dustMaskViewId);
-    }
-
-    image.SetStatusCallback(&status);
-
-    // Downsample
-    ImageVariant downImage;
-    downImage.CopyImage(image);
-    downImage.EnsureUniqueImage();
-    downImage.SetStatusCallback(nullptr);
-    if (downsample > 1) {
-        IntegerResample ir(-downsample);
-        ir >> downImage;
-    }
-
-    // Star detection
-    ImageVariant starMask;
-    starMask.CopyImage(downImage);
-    starMask.EnsureUniqueImage();
-    starMask.SetStatusCallback(nullptr);
-    image.Status().Initialize("Performing star detection", 3);
-    MultiscaleLinearTransform mlt(4);
-    mlt << starMask;
-    mlt.DisableLayer(0);
-    mlt.DisableLayer(4);
-    mlt >> starMask;
-    starMask.Truncate(0.0f, 1.0f);
-    starMask.Normalize();
-    image.Status() += 1;
-
-    MorphologicalTransformation mf;
-    mf.SetStructure(BoxStructure(3));
-    mf.SetOperator(MedianFilter());
-    mf >> starMask;
-    starMask.Binarize(pcl::Pow10(-starDetectionSensitivity));
-    image.Status() += 1;
-
-    MorphologicalTransformation df;
-    df.SetStructure(CircularStructure(2 * starDiffusionDistance + 3));
-    df.SetOperator(DilationFilter());
-    df >> starMask;
-    image.Status() += 1;
-    starMask.Invert();
-
-    // Extract background
-    image.Status().Initialize("Extracting background", image.NumberOfChannels() + 5);
-    ImageVariant mask;
-    mask.CopyImage(starMask);
-    mask.EnsureUniqueImage();
-    mask.SetStatusCallback(nullptr);
-    ImageVariant bg;
-    bg.CopyImage(downImage);
-    bg.EnsureUniqueImage();
-    bg.SetStatusCallback(nullptr);
-    bg.Multiply(mask);
-    image.Status() += 1;
-
-    if (testSkyDetection) {
-        IsoString id = view.FullId() + "_bg";
-        ImageWindow OutputWindow = ImageWindow(bg.Width(), bg.Height(), bg.NumberOfChannels(), bg.BitsPerSample(), true, bg.IsColor(), true, id);
-        if (OutputWindow.IsNull())
-            throw Error("Unable to create image window: " + id);
-        OutputWindow.MainView().Lock();
-        OutputWindow.MainView().Image().CopyImage(bg);
-        OutputWindow.MainView().Unlock();
-        OutputWindow.Show();
-
-        return true;
-    }
-
-    // Inpaint
-    ImageVariant bg0;
-    bg0.CopyImage(bg);
-    bg0.EnsureUniqueImage();
-    bg0.SetStatusCallback(nullptr);
-    image.Status() += 1;
-    if (image.BitsPerSample() == 32) {
-        ReferenceArray<GenericImage<FloatPixelTraits>> input;
-        input << &static_cast<Image&>(*bg);
-        for (int c = 0; c < image.NumberOfChannels(); c++) {
-            DustFreeThread<FloatPixelTraits>::dispatch(inpaint<FloatPixelTraits>, this, input, static_cast<Image&>(*bg0), c);
-            image.Status() += 1;
-        }
-    } else if (image.BitsPerSample() == 64) {
-        ReferenceArray<GenericImage<DoublePixelTraits>> input;
-        input << &static_cast<DImage&>(*bg);
-        for (int c = 0; c < image.NumberOfChannels(); c++) {
-            DustFreeThread<DoublePixelTraits>::dispatch(inpaint<DoublePixelTraits>, this, input, static_cast<DImage&>(*bg0), c);
-            image.Status() += 1;
-        }
-    }
-
-    // Apply dust mask and inpaint
-    ImageVariant dustMask;
-    {
-        AutoViewLock viewLock(dustMaskView);
-        dustMask.CopyImage(dustMaskView.Image());
-        dustMask.EnsureUniqueImage();
-        dustMask.SetStatusCallback(nullptr);
-    }
-    if ((dustMask.Width() != mask.Width()) || (dustMask.Height() != mask.Height())) {
-        BicubicFilterPixelInterpolation bs(2, 2, CubicBSplineFilter());
-        Resample rs(bs, double(mask.Width()) / dustMask.Width(), double(mask.Height()) / dustMask.Height());
-        rs >> dustMask;
-    }
-    if ((dustMask.NumberOfChannels() != mask.NumberOfChannels()) && (dustMask.ColorSpace() == ColorSpace::Gray))
-        dustMask.SetColorSpace(mask.ColorSpace());
-
-    if (dustMask.NumberOfChannels() != mask.NumberOfChannels())
-        throw Error("Number of channels of non-sky mask mismatch with the image being processed.");
-
-    dustMask.Binarize(0.5);
-    bg.Multiply(dustMask.Invert());
-
-    ImageVariant bg1;
-    bg1.CopyImage(bg);
-    bg1.EnsureUniqueImage();
-    bg1.SetStatusCallback(nullptr);
-    image.Status() += 1;
-    if (image.BitsPerSample() == 32) {
-        ReferenceArray<GenericImage<FloatPixelTraits>> input;
-        input << &static_cast<Image&>(*bg);
-        for (int c = 0; c < image.NumberOfChannels(); c++) {
-            DustFreeThread<FloatPixelTraits>::dispatch(inpaint<FloatPixelTraits>, this, input, static_cast<Image&>(*bg1), c);
-            image.Status() += 1;
-        }
-    } else if (image.BitsPerSample() == 64) {
-        ReferenceArray<GenericImage<DoublePixelTraits>> input;
-        input << &static_cast<DImage&>(*bg);
-        for (int c = 0; c < image.NumberOfChannels(); c++) {
-            DustFreeThread<DoublePixelTraits>::dispatch(inpaint<DoublePixelTraits>, this, input, static_cast<DImage&>(*bg1), c);
-            image.Status() += 1;
-        }
-    }
-
-    // Blur
-    VariableShapeFilter H2(pcl::Pow(1.7f, smoothness), 5.0f, 0.01f, 1.0f, 0.0f);
-    FFTConvolution(H2) >> bg0;
-    FFTConvolution(H2) >> bg1;
-    if (downsample > 1) {
-        BicubicFilterPixelInterpolation bs(2, 2, CubicBSplineFilter());
-        Resample rs(bs, double(image.Width()) / bg.Width(), double(image.Height()) / bg.Height());
-        rs >> bg0;
-        rs >> bg1;
-    }
-    image.Status() += 1;
-    image.Status().Complete();
-
-    image.Subtract(bg0);
-    image.Add(bg1);
-
-    return true;
-}
-
-void* DustFreeInstance::LockParameter(const MetaParameter* p, size_type /*tableRow*/)
-{
-    return 0;
-}
-
-template <class P>
-void DustFreeInstance::inpaint(DustFreeInstance* superFlat, ReferenceArray<GenericImage<P>>& inputs, GenericImage<P>& output, int y, int channel)
-{
-    typename P::sample* pOut = output.ScanLine(y, channel);
-    GenericImage<P>& input = inputs[0];
-    const int n = 32;
-    const int distance = pcl::Max(output.Width(), output.Height());
-    std::minstd_rand rg(output.Height() * channel + y);
-    std::uniform_real_distribution<float> ud(-0.5f, 0.5f);
-
-    for (int x = 0; x < output.Width(); x++) {
-        typename P::sample in = input(x, y, channel);
-        if (in > 0.0) {
-            pOut[x] = in;
-            continue;
-        }
-        typename P::sample p = 0.0;
-        float w0 = 0.0f;
-        for (int i = 0; i < n; i++) {
-            float rad = pcl::Pi() * 2.0f * i / n;
-            float step_x = pcl::Cos(rad);
-            float step_y = pcl::Sin(rad);
-            for (int j = 1; j < distance; j = (j < 16) ? j + 1 : j * 1.1f) {
-                if ((j < 64) && (i % 2 != 0))
-                    continue;
-                float w = 1.0f / float(j);
-                if (w < w0 * 0.01f)
-                    continue;
-                float rx = ud(rg) * j * 6.0f / n;
-                float ry = ud(rg) * j * 6.0f / n;
-                rx = 0.0;
-                ry = 0.0;
-                int ix = int(x + step_x * j + rx + 0.5f);
-                int iy = int(y + step_y * j + ry + 0.5f);
-                if (ix < 0)
-                    ix = 0;
-                else if (ix >= input.Width())
-                    ix = input.Width() - 1;
-                if (iy < 0)
-                    iy = 0;
-                else if (iy >= input.Height())
-                    iy = input.Height() - 1;
-                typename P::sample in = input(ix, iy, channel);
-                if (in == 0.0)
-                    continue;
-                p += in * w;
-                w0 += w;
-                break;
-            }
-        }
-        if (w0 > 0.0f)
-            pOut[x] = p / w0;
-        else
-            pOut[x] = 0.0;
-    }
-}
-
-}	// namespace pcl
\ No newline at end of file
+#include <new>
+
+#include <pcl/AutoViewLock.h>
+#include <pcl/Console.h>
+#include <pcl/File.h>
+#include <pcl/FileFormat.h>
+#include <pcl/FileFormatInstance.h>
+#include <pcl/FFTConvolution.h>
+#include <pcl/IntegerResample.h>
+#include <pcl/MetaModule.h>
+#include <pcl/MorphologicalTransformation.h>
+#include <pcl/MultiscaleLinearTransform.h>
+#include <pcl/PixelInterpolation.h>
+#include <pcl/Resample.h>
+#include <pcl/StandardStatus.h>
+#include <pcl/Thread.h>
+#include <pcl/VariableShapeFilter.h>
+#include <pcl/View.h>
+
+#include "DustFreeBitMask.h"
+#include "DustFreeCache.h"
+#include "DustFreeCompiledMask.h"
+#include "DustFreeDistanceTransform.h"
+#include "DustFreeInpaint.h"
+#include "DustFreeInstance.h"
+#include "DustFreeParallel.h"
+#include "DustFreeParameters.h"
+#include "DustFreePipeline.h"
+#include "DustFreeRegions.h"
+#include "DustFreeStarDetection.h"
+#include "DustFreeResample.h"
+#include "DustFreeScratch.h"
+#include "DustFreeShapes.h"
+#include "DustFreeSmoothing.h"
+
+namespace pcl
+{
+
+// Packed binary masks of the channels of an image. Samples at or above
+// threshold, given in the normalized [0,1] range, are set.
+template <class P>
+static Array<DFBitMask> BinarizeChannels(const GenericImage<P>& image, double threshold)
+{
+    Array<DFBitMask> masks(image.NumberOfChannels());
+    for (int c = 0; c < image.NumberOfChannels(); c++)
+        masks[c].Binarize(image.PixelData(c), image.Width(), image.Height(), P::ToSample(threshold));
+    return masks;
+}
+
+static Array<DFBitMask> BinarizeChannels(const ImageVariant& image, double threshold)
+{
+    if (image.IsFloatSample())
+        switch (image.BitsPerSample()) {
+        case 32: return BinarizeChannels(static_cast<const Image&>(*image), threshold);
+        case 64: return BinarizeChannels(static_cast<const DImage&>(*image), threshold);
+        }
+    else
+        switch (image.BitsPerSample()) {
+        case 8: return BinarizeChannels(static_cast<const UInt8Image&>(*image), threshold);
+        case 16: return BinarizeChannels(static_cast<const UInt16Image&>(*image), threshold);
+        case 32: return BinarizeChannels(static_cast<const UInt32Image&>(*image), threshold);
+        }
+    throw Error("Unsupported mask sample type.");
+}
+
+// Band-pass star detection of all channels of an image. If range is given, it
+// replaces the range of the response measured on the image.
+template <class P>
+static Array<DFBitMask> DetectStars(const GenericImage<P>& image, double threshold, const double* range)
+{
+    Array<const typename P::sample*> planes;
+    for (int c = 0; c < image.NumberOfChannels(); c++)
+        planes << image.PixelData(c);
+    Array<DFBitMask> masks(image.NumberOfChannels());
+    DFDetectStars(planes.Begin(), image.NumberOfChannels(), image.Width(), image.Height(), threshold, masks.Begin(), range);
+    return masks;
+}
+
+// Range of the band-pass response of an image over a core rectangle.
+template <class P>
+static void StarResponseRange(const GenericImage<P>& image, const Rect& core, double& low, double& high)
+{
+    Array<const typename P::sample*> planes;
+    for (int c = 0; c < image.NumberOfChannels(); c++)
+        planes << image.PixelData(c);
+    DFStarResponseRange(planes.Begin(), image.NumberOfChannels(), image.Width(), image.Height(),
+        DFRect{ core.x0, core.y0, core.x1, core.y1 }, low, high);
+}
+
+static void StarResponseRange(const ImageVariant& image, const Rect& core, double& low, double& high)
+{
+    if (image.BitsPerSample() == 32)
+        StarResponseRange(static_cast<const Image&>(*image), core, low, high);
+    else if (image.BitsPerSample() == 64)
+        StarResponseRange(static_cast<const DImage&>(*image), core, low, high);
+}
+
+// Multiscale star response, in place: wavelet layers 1 to 3 clipped to [0,1].
+static void MultiscaleStarResponse(ImageVariant& image)
+{
+    MultiscaleLinearTransform mlt(4);
+    mlt << image;
+    mlt.DisableLayer(0);
+    mlt.DisableLayer(4);
+    mlt >> image;
+    image.Truncate(0.0f, 1.0f);
+}
+
+// Recursive Gaussian smoothing of all channels of an image, in place.
+template <class P>
+static void SmoothChannels(GenericImage<P>& image, double sigma)
+{
+    for (int c = 0; c < image.NumberOfChannels(); c++)
+        DFRecursiveGaussian(image.PixelData(c), image.Width(), image.Height(), sigma);
+}
+
+// Multiply-as-select: zeroes the samples where the mask of their channel is clear.
+template <class P>
+static void SelectChannels(GenericImage<P>& image, const Array<DFBitMask>& masks)
+{
+    for (int c = 0; c < image.NumberOfChannels(); c++)
+        masks[c].Select(image.PixelData(c));
+}
+
+static void SelectChannels(ImageVariant& image, const Array<DFBitMask>& masks)
+{
+    if (image.BitsPerSample() == 32)
+        SelectChannels(static_cast<Image&>(*image), masks);
+    else if (image.BitsPerSample() == 64)
+        SelectChannels(static_cast<DImage&>(*image), masks);
+}
+
+// The working image of the pipeline: an image at 1:downsample, in floating
+// point. 32-bit images are copied and averaged down, as are 64-bit ones when
+// the pipeline runs in double; integer images, and 64-bit ones otherwise, are
+// averaged straight into a 32-bit float image, integers normalized on the way,
+// so that they are never held as float at their full size.
+template <class P>
+static void DownsampleChannels(const GenericImage<P>& image, int downsample, Image& working)
+{
+    working.AllocateData(DFDownsampledSize(image.Width(), downsample), DFDownsampledSize(image.Height(), downsample),
+        image.NumberOfChannels(), image.ColorSpace());
+    for (int c = 0; c < image.NumberOfChannels(); c++)
+        DFDownsample(image.PixelData(c), image.Width(), image.Height(), downsample, working.PixelData(c));
+}
+
+static bool WorkingInFloat(const ImageVariant& image, bool floatIntermediates)
+{
+    return !image.IsFloatSample() || ((image.BitsPerSample() == 64) && floatIntermediates);
+}
+
+static void WorkingImage(const ImageVariant& image, int downsample, bool floatIntermediates, ImageVariant& working)
+{
+    if (!WorkingInFloat(image, floatIntermediates)) {
+        working.CopyImage(image);
+        working.EnsureUniqueImage();
+        working.SetStatusCallback(nullptr);
+        if (downsample > 1) {
+            IntegerResample ir(-downsample);
+            ir >> working;
+        }
+        return;
+    }
+    working.CreateFloatImage(32);
+    Image& target = static_cast<Image&>(*working);
+    if (image.IsFloatSample())
+        DownsampleChannels(static_cast<const DImage&>(*image), downsample, target);
+    else
+        switch (image.BitsPerSample()) {
+        case 8: DownsampleChannels(static_cast<const UInt8Image&>(*image), downsample, target); break;
+        case 16: DownsampleChannels(static_cast<const UInt16Image&>(*image), downsample, target); break;
+        case 32: DownsampleChannels(static_cast<const UInt32Image&>(*image), downsample, target); break;
+        }
+}
+
+// Adds the correction, upsampled, to every channel of an image. Integer
+// samples are rounded and clipped to their range.
+template <class P>
+static void ApplyCorrection(GenericImage<P>& image, const ImageVariant& correction)
+{
+    for (int c = 0; c < image.NumberOfChannels(); c++)
+        if (correction.BitsPerSample() == 32)
+            DFAddUpsampled(static_cast<const Image&>(*correction).PixelData(c), correction.Width(), correction.Height(),
+                image.PixelData(c), image.Width(), image.Height());
+        else
+            DFAddUpsampled(static_cast<const DImage&>(*correction).PixelData(c), correction.Width(), correction.Height(),
+                image.PixelData(c), image.Width(), image.Height());
+}
+
+static void ApplyCorrection(ImageVariant& image, const ImageVariant& correction)
+{
+    if (image.IsFloatSample())
+        switch (image.BitsPerSample()) {
+        case 32: ApplyCorrection(static_cast<Image&>(*image), correction); break;
+        case 64: ApplyCorrection(static_cast<DImage&>(*image), correction); break;
+        }
+    else
+        switch (image.BitsPerSample()) {
+        case 8: ApplyCorrection(static_cast<UInt8Image&>(*image), correction); break;
+        case 16: ApplyCorrection(static_cast<UInt16Image&>(*image), correction); break;
+        case 32: ApplyCorrection(static_cast<UInt32Image&>(*image), correction); break;
+        }
+}
+
+// Results of the star detection and of the inpainting, shared by all instances
+// so that later runs on the same view reuse them.
+struct StageResult
+{
+    Array<DFBitMask> stars;
+    ImageVariant difference;
+};
+
+static DFStageCache<StageResult> TheStageCache;
+
+// Stores a result in the cache, charging what the cache grows by to the
+// ledger, or releasing what its evictions free.
+static void CacheResult(uint64 key, StageResult& result, size_type bytes, DFMemoryLedger& memory)
+{
+    const size_type before = TheStageCache.Size();
+    TheStageCache.Insert(key, std::move(result), bytes);
+    const size_type after = TheStageCache.Size();
+    if (after > before)
+        memory.Acquire(after - before);
+    else
+        memory.Release(before - after);
+}
+
+static uint64 CombineKey(uint64 key, double value)
+{
+    return pcl::Hash64(&value, sizeof(value), key);
+}
+
+template <class P>
+static uint64 HashPixels(const GenericImage<P>& image, uint64 key)
+{
+    for (int c = 0; c < image.NumberOfChannels(); c++)
+        key = pcl::Hash64(image.PixelData(c), image.NumberOfPixels() * sizeof(typename P::sample), key);
+    return key;
+}
+
+// Revision of an image: a hash of its identifier, geometry and pixels, which
+// also recognizes an image restored by an undo.
+static uint64 ImageKey(const ImageVariant& image, const IsoString& id)
+{
+    uint64 key = pcl::Hash64(id.c_str(), id.Length());
+    key = CombineKey(key, image.Width());
+    key = CombineKey(key, image.Height());
+    key = CombineKey(key, image.NumberOfChannels());
+    key = CombineKey(key, image.BitsPerSample() * (image.IsFloatSample() ? -1 : 1));
+    if (image.IsFloatSample())
+        switch (image.BitsPerSample()) {
+        case 32: return HashPixels(static_cast<const Image&>(*image), key);
+        case 64: return HashPixels(static_cast<const DImage&>(*image), key);
+        }
+    else
+        switch (image.BitsPerSample()) {
+        case 8: return HashPixels(static_cast<const UInt8Image&>(*image), key);
+        case 16: return HashPixels(static_cast<const UInt16Image&>(*image), key);
+        case 32: return HashPixels(static_cast<const UInt32Image&>(*image), key);
+        }
+    return key;
+}
+
+// A frame of a batch, from its read to its write. A frame that cannot be read,
+// or whose output file exists already, carries the reason instead of pixels.
+struct BatchFrame
+{
+    ImageVariant image;
+    FITSKeywordArray keywords;
+    String outputPath;
+    String error;
+};
+
+static BatchFrame ReadFrame(const String& path, const String& outputPath, bool overwrite)
+{
+    BatchFrame frame;
+    frame.outputPath = outputPath;
+    try {
+        if (!overwrite && File::Exists(outputPath))
+            throw Error("The output file already exists: " + outputPath);
+        FileFormat format(File::ExtractExtension(path), true, false);
+        FileFormatInstance file(format);
+        ImageDescriptionArray images;
+        if (!file.Open(images, path))
+            throw Error("Unable to open file: " + path);
+        if (images.IsEmpty())
+            throw Error("Empty image file: " + path);
+        if (format.CanStoreKeywords())
+            file.ReadFITSKeywords(frame.keywords);
+        // Integer frames are read and written back as they are.
+        const ImageOptions& options = images[0].options;
+        if (options.ieeefpSampleFormat || (options.bitsPerSample == 64))
+            frame.image.CreateFloatImage((options.bitsPerSample == 64) ? 64 : 32);
+        else
+            frame.image.CreateUIntImage(options.bitsPerSample);
+        if (!file.ReadImage(frame.image))
+            throw Error("Unable to read file: " + path);
+        file.Close();
+    } catch (const Exception& x) {
+        frame.image.FreeImage();
+        frame.error = x.Message();
+    }
+    return frame;
+}
+
+// Writes a processed frame as an XISF file; returns the reason of a failure.
+static String WriteFrame(const BatchFrame& frame)
+{
+    try {
+        FileFormat format(".xisf", false, true);
+        FileFormatInstance file(format);
+        if (!file.Create(frame.outputPath))
+            throw Error("Unable to create file: " + frame.outputPath);
+        ImageOptions options;
+        options.bitsPerSample = frame.image.BitsPerSample();
+        options.ieeefpSampleFormat = frame.image.IsFloatSample();
+        file.SetOptions(options);
+        file.WriteFITSKeywords(frame.keywords);
+        if (!file.WriteImage(frame.image))
+            throw Error("Unable to write file: " + frame.outputPath);
+        file.Close();
+    } catch (const Exception& x) {
+        return x.Message();
+    }
+    return String();
+}
+
+// The stages of a frame as a member of the frames array of a trace.
+static std::string FrameTrace(const DFStageProfile& profile, const IsoString& id, const ImageVariant& image)
+{
+    const std::string members = "\"image\": " + DFJsonString(std::string(id.c_str())) +
+        IsoString().Format(", \"width\": %d, \"height\": %d, \"channels\": %d, \"bitsPerSample\": %d",
+            image.Width(), image.Height(), image.NumberOfChannels(), image.BitsPerSample()).c_str();
+    return profile.Json(members);
+}
+
+// Writes a trace of the given frames as a JSON file.
+static void WriteTrace(const String& path, const std::vector<std::string>& frames)
+{
+    std::string json = "{\"process\": \"DustFree\", \"threads\": " + std::to_string(DFParallelThreadCount()) +
+        ", \"frames\": [";
+    for (size_t i = 0; i < frames.size(); i++)
+        json += ((i > 0) ? ",\n  " : "\n  ") + frames[i];
+    json += "\n]}\n";
+    File::WriteFile(path, json.data(), json.size());
+}
+
+DustFreeInstance::DustFreeInstance(const MetaProcess* m)
+    : ProcessImplementation(m)
+    , starDetectionSensitivity(TheDFStarDetectionSensitivityParameter->DefaultValue())
+    , starDiffusionDistance(TheDFStarDiffusionDistanceParameter->DefaultValue())
+    , dustMaskViewId()
+    , smoothness(TheDFSmoothnessParameter->DefaultValue())
+    , downsample(TheDFDownsampleParameter->DefaultValue())
+    , testSkyDetection(TheDFTestSkyDetectionParameter->DefaultValue())
+    , inpaintMethod(DFInpaintMethod::Default)
+    , tiledInpainting(TheDFTiledInpaintingParameter->DefaultValue())
+    , dustRegionsOnly(TheDFDustRegionsOnlyParameter->DefaultValue())
+    , starDetectionMethod(DFStarDetectionMethod::Default)
+    , smoothingMethod(DFSmoothingMethod::Default)
+    , memoryBudget(TheDFMemoryBudgetParameter->DefaultValue())
+    , streaming(TheDFStreamingParameter->DefaultValue())
+    , floatIntermediates(TheDFFloatIntermediatesParameter->DefaultValue())
+    , cacheSize(TheDFCacheSizeParameter->DefaultValue())
+    , dustMaskFile()
+    , dustShapes()
+    , targetFrames()
+    , outputDirectory()
+    , outputPostfix(TheDFOutputPostfixParameter->DefaultValue())
+    , overwriteExistingFiles(TheDFOverwriteExistingFilesParameter->DefaultValue())
+    , framesInFlight(TheDFFramesInFlightParameter->DefaultValue())
+    , traceFile()
+{
+}
+
+DustFreeInstance::DustFreeInstance(const DustFreeInstance& x)
+    : ProcessImplementation(x)
+{
+    Assign(x);
+}
+
+void DustFreeInstance::Assign(const ProcessImplementation& p)
+{
+    const DustFreeInstance* x = dynamic_cast<const DustFreeInstance*>(&p);
+    if (x != nullptr) {
+        starDetectionSensitivity = x->starDetectionSensitivity;
+        starDiffusionDistance = x->starDiffusionDistance;
+        dustMaskViewId = x->dustMaskViewId;
+        smoothness = x->smoothness;
+        downsample = x->downsample;
+        testSkyDetection = x->testSkyDetection;
+        inpaintMethod = x->inpaintMethod;
+        tiledInpainting = x->tiledInpainting;
+        dustRegionsOnly = x->dustRegionsOnly;
+        starDetectionMethod = x->starDetectionMethod;
+        smoothingMethod = x->smoothingMethod;
+        memoryBudget = x->memoryBudget;
+        streaming = x->streaming;
+        floatIntermediates = x->floatIntermediates;
+        cacheSize = x->cacheSize;
+        dustMaskFile = x->dustMaskFile;
+        dustShapes = x->dustShapes;
+        targetFrames = x->targetFrames;
+        outputDirectory = x->outputDirectory;
+        outputPostfix = x->outputPostfix;
+        overwriteExistingFiles = x->overwriteExistingFiles;
+        framesInFlight = x->framesInFlight;
+        traceFile = x->traceFile;
+    }
+}
+
+bool DustFreeInstance::IsHistoryUpdater(const View& view) const
+{
+    return true;
+}
+
+UndoFlags DustFreeInstance::UndoMode(const View&) const
+{
+    return UndoFlag::PixelData;
+}
+
+bool DustFreeInstance::CanExecuteOn(const View& view, pcl::String& whyNot) const
+{
+    if (view.Image().IsComplexSample())
+    {
+        whyNot = "DustFree cannot be executed on complex images.";
+        return false;
+    }
+
+    return true;
+}
+
+bool DustFreeInstance::ExecuteOn(View& view)
+{
+    AutoViewLock lock(view);
+
+    StandardStatus status;
+    Console console;
+
+    console.EnableAbort();
+
+    // Follow the processor preferences. A resize waits for the tasks of a
+    // real-time preview still in flight, and does nothing if the count holds.
+    DFSetParallelThreadCount(Thread::NumberOfThreads(PCL_MAX_PROCESSORS, 1));
+
+    ImageVariant image = view.Image();
+
+    if (image.IsComplexSample())
+        return false;
+
+    View dustMaskView = selectedDustMask();
+    image.SetStatusCallback(&status);
+    // Shapes are given in the coordinates of the main image, where a preview
+    // starts at its corner.
+    DFCompiledMask compiled;
+    const Point origin = view.IsPreview() ? view.Window().PreviewRect(view.Id()).LeftTop() : Point(0, 0);
+    processFrame(image, view.FullId(), dustMaskView, dustMaskRevision(dustMaskView, false), compiled, false, origin);
+    if (!traceFile.IsEmpty()) {
+        WriteTrace(traceFile, std::vector<std::string>(1, FrameTrace(profile, view.FullId(), image)));
+        console.WriteLn("Trace file: " + traceFile);
+    }
+    return true;
+}
+
+bool DustFreeInstance::CanExecuteGlobal(String& whyNot) const
+{
+    if (targetFrames.IsEmpty()) {
+        whyNot = "No target frames have been specified.";
+        return false;
+    }
+    if (outputDirectory.Trimmed().IsEmpty()) {
+        whyNot = "No output directory has been specified.";
+        return false;
+    }
+    if (testSkyDetection) {
+        whyNot = "Sky detection cannot be tested on a batch of files.";
+        return false;
+    }
+    return true;
+}
+
+bool DustFreeInstance::ExecuteGlobal()
+{
+    String whyNot;
+    if (!CanExecuteGlobal(whyNot))
+        throw Error(whyNot);
+
+    StandardStatus status;
+    Console console;
+
+    console.EnableAbort();
+
+    // Follow the processor preferences. A resize waits for the tasks of a
+    // real-time preview still in flight, and does nothing if the count holds.
+    DFSetParallelThreadCount(Thread::NumberOfThreads(PCL_MAX_PROCESSORS, 1));
+
+    String directory = outputDirectory.Trimmed();
+    if (!File::DirectoryExists(directory))
+        throw Error("The output directory does not exist: " + directory);
+    if (!directory.EndsWith('/'))
+        directory += '/';
+
+    StringList paths;
+    for (const TargetFrame& frame : targetFrames)
+        if (frame.enabled)
+            paths << frame.path;
+    if (paths.IsEmpty())
+        throw Error("All target frames are disabled.");
+
+    View dustMaskView = selectedDustMask();
+    const uint64 maskRevision = dustMaskRevision(dustMaskView, true);
+    DFCompiledMask compiled;
+
+    // Frames are read ahead and written behind on their own PCL threads while
+    // the current one is processed here, with at most framesInFlight frames
+    // held at once. Only this thread writes to the console: the errors of the
+    // writer are reported at the next frame.
+    std::mutex mutex;
+    StringList writeErrors;
+    int succeeded = 0;
+    int failed = 0;
+    std::vector<std::string> traces;
+    auto reportWriteErrors = [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const String& error : writeErrors)
+            console.CriticalLn("<end><cbr>*** Error: " + error);
+        succeeded -= int(writeErrors.Length());
+        failed += int(writeErrors.Length());
+        writeErrors.Clear();
+    };
+
+    console.WriteLn(String().Format("<end><cbr>Processing %u frame(s), at most %u in flight", paths.Length(), framesInFlight));
+    const bool overwrite = overwriteExistingFiles;
+    DFRunPipeline<BatchFrame>(int(paths.Length()), int(framesInFlight),
+        [&](int i) {
+            return ReadFrame(paths[i], directory + File::ExtractName(paths[i]) + outputPostfix + ".xisf", overwrite);
+        },
+        [&](int i, BatchFrame& frame) {
+            reportWriteErrors();
+            console.WriteLn(String().Format("<end><cbr><br>Frame %d of %u: ", i + 1, paths.Length()) + paths[i]);
+            if (!frame.error.IsEmpty()) {
+                console.CriticalLn("*** Error: " + frame.error);
+                failed++;
+                return;
+            }
+            // A frame that fails is skipped, as one that cannot be read; only
+            // an abort stops the batch, after the frames processed so far are
+            // written.
+            frame.image.SetStatusCallback(&status);
+            try {
+                processFrame(frame.image, paths[i].ToUTF8(), dustMaskView, maskRevision, compiled, true);
+            } catch (const ProcessAborted&) {
+                throw;
+            } catch (const Exception& x) {
+                frame.error = x.Message();
+            } catch (const std::bad_alloc&) {
+                frame.error = "Out of memory";
+            }
+            frame.image.SetStatusCallback(nullptr);
+            if (!frame.error.IsEmpty()) {
+                frame.image.FreeImage();
+                console.CriticalLn("<end><cbr>*** Error: " + frame.error);
+                failed++;
+                return;
+            }
+            if (!traceFile.IsEmpty())
+                traces.push_back(FrameTrace(profile, paths[i].ToUTF8(), frame.image));
+            console.WriteLn("Output file: " + frame.outputPath);
+            succeeded++;
+            Module->ProcessEvents();
+        },
+        [&](int, BatchFrame& frame) {
+            if (frame.error.IsEmpty()) {
+                const String error = WriteFrame(frame);
+                if (!error.IsEmpty()) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    writeErrors << error;
+                }
+            }
+        });
+    reportWriteErrors();
+
+    console.NoteLn(String().Format("<end><cbr><br>%d frame(s) processed, %d failed.", succeeded, failed));
+    if (!traceFile.IsEmpty()) {
+        WriteTrace(traceFile, traces);
+        console.WriteLn("Trace file: " + traceFile);
+    }
+    return true;
+}
+
+std::vector<DFDustShape> DustFreeInstance::enabledDustShapes() const
+{
+    std::vector<DFDustShape> shapes;
+    for (const DustShape& s : dustShapes)
+        if (s.enabled && (s.radius > 0)) {
+            DFDustShape shape;
+            shape.x = s.x;
+            shape.y = s.y;
+            shape.radius = s.radius;
+            shape.innerRadius = s.innerRadius;
+            shape.axisRatio = s.axisRatio;
+            shape.angle = s.angle;
+            shape.feather = s.feather;
+            shapes.push_back(shape);
+        }
+    return shapes;
+}
+
+View DustFreeInstance::selectedDustMask() const
+{
+    // The dust mask comes from its shapes, which replace any mask image and
+    // compiled mask; otherwise from its view, from a compiled dust mask file,
+    // or from both, and then the file is checked against the view.
+    View dustMaskView;
+    if (!enabledDustShapes().empty())
+        return dustMaskView;
+    if (!dustMaskViewId.IsEmpty()) {
+        dustMaskView = View::ViewById(dustMaskViewId);
+        if (dustMaskView.IsNull())
+            throw Error("No such view (dust mask): " + dustMaskViewId);
+    } else if (dustMaskFile.IsEmpty())
+        throw Error("No dust mask selected");
+    return dustMaskView;
+}
+
+// Results are cached for later runs on the same view. A batch never sees its
+// frames again, and the cache, which is held outside the pipeline buffers, is
+// not kept under a memory budget.
+bool DustFreeInstance::cachesResults(bool batch) const
+{
+    return !batch && (cacheSize > 0) && (memoryBudget == 0);
+}
+
+uint64 DustFreeInstance::dustMaskRevision(View& dustMaskView, bool batch) const
+{
+    const std::vector<DFDustShape> shapes = enabledDustShapes();
+    if (!shapes.empty())
+        return pcl::Hash64(shapes.data(), shapes.size() * sizeof(DFDustShape));
+    if (dustMaskView.IsNull() || (!cachesResults(batch) && dustMaskFile.IsEmpty()))
+        return 0;
+    AutoViewLock viewLock(dustMaskView);
+    return ImageKey(dustMaskView.Image(), IsoString());
+}
+
+void DustFreeInstance::processFrame(ImageVariant& image, const IsoString& id, View& dustMaskView,
+    uint64 maskRevision, DFCompiledMask& compiled, bool batch, const Point& origin)
+{
+    Console console;
+    pcl::StatusCallback* status = image->StatusCallback();
+
+    memory.Reset();
+    profile.Reset();
+    fixedStarRange = false;
+    imageKey = maskKey = 0;
+    shapeOrigin = origin;
+    shapeScale = 1;
+    const bool caching = cachesResults(batch);
+    if (!batch || (memoryBudget > 0))
+        TheStageCache.SetCapacity(caching ? size_type(cacheSize) << 20 : 0);
+    memory.Acquire(TheStageCache.Size());
+
+    // The compiled mask is kept from frame to frame while it matches; it is
+    // loaded again, or compiled afresh, for images of another size. Shapes
+    // need neither: they are drawn at the working resolution of every run.
+    const std::vector<DFDustShape> shapes = enabledDustShapes();
+    const bool fromShapes = !shapes.empty();
+    compiledMask = nullptr;
+    compiledMaskChanged = false;
+    if (fromShapes)
+        console.WriteLn(String().Format("<end><cbr>Dust mask: %u shape(s)", unsigned(shapes.size())));
+    else if (!dustMaskFile.IsEmpty() && ((compiled.width != image.Width()) || (compiled.height != image.Height()) ||
+        (!dustMaskView.IsNull() && (compiled.source != maskRevision)))) {
+        if (loadCompiledMask(compiled, maskRevision, image.Width(), image.Height()))
+            console.WriteLn("<end><cbr>Compiled dust mask: " + dustMaskFile);
+        else if (dustMaskView.IsNull())
+            throw Error("The compiled dust mask does not exist or does not match the image: " + dustMaskFile);
+        else {
+            compiled = DFCompiledMask();
+            compiled.source = maskRevision;
+            compiled.width = image.Width();
+            compiled.height = image.Height();
+            console.WriteLn("<end><cbr>Compiling dust mask: " + dustMaskFile);
+        }
+    }
+    if (!fromShapes && !dustMaskFile.IsEmpty() && dustMaskView.IsNull())
+        maskRevision = compiled.source;
+
+    const ImageVariant maskSource = dustMaskView.IsNull() ? ImageVariant() : dustMaskView.Image();
+    const size_type budget = size_type(memoryBudget) << 20;
+    const int workingBits = WorkingInFloat(image, floatIntermediates) ? 32 : image.BitsPerSample();
+    const size_type predicted = maskSource.ImageSize() +
+        predictedPeakMemory(image.Width(), image.Height(), image.NumberOfChannels(), workingBits);
+    console.WriteLn(String().Format("<end><cbr>Predicted peak memory: %.1f MiB", predicted / 1048576.0));
+
+    const bool tiled = streaming || ((budget > 0) && (predicted > budget));
+    if (testSkyDetection || (!dustRegionsOnly && !tiled)) {
+        // A compiled level replaces the copy of the mask altogether.
+        ImageVariant dustMask;
+        if (!fromShapes && !dustMaskFile.IsEmpty())
+            compiledMask = &compiled;
+        if (!fromShapes && (compiled.levels.count(downsample) == 0)) {
+            if (dustMaskView.IsNull() && !testSkyDetection)
+                throw Error(String().Format("The compiled dust mask has no level for a downsampling of %d; "
+                    "select the dust mask image to compile it.", downsample));
+            if (!dustMaskView.IsNull()) {
+                AutoViewLock viewLock(dustMaskView);
+                dustMask.CopyImage(dustMaskView.Image());
+                dustMask.EnsureUniqueImage();
+                dustMask.SetStatusCallback(nullptr);
+            }
+        }
+        memory.Acquire(dustMask.ImageSize());
+        if (caching && !testSkyDetection) {
+            imageKey = ImageKey(image, id);
+            maskKey = maskRevision;
+        }
+        processImage(image, dustMask, id + "_bg");
+        compiledMask = nullptr;
+        if (compiledMaskChanged)
+            saveCompiledMask(compiled);
+        console.WriteLn(String().Format("Peak memory of pipeline buffers: %.1f MiB", memory.Peak() / 1048576.0));
+        console.WriteLn("<raw>" + String(profile.Table().c_str()) + "</raw>");
+        return;
+    }
+
+    if (dustMaskView.IsNull() && !fromShapes)
+        throw Error("Dust regions and tiles are cut from the dust mask image, which must be selected.");
+
+    // Dust regions and tiles are processed as windows of the image, each with
+    // the matching window of a full resolution dust mask. In streaming mode the
+    // mask is not copied: it is read in place from its view when it is a float
+    // image of the size of the image, or resampled once and spilled to a
+    // scratch file. Shapes are drawn for each window instead.
+    const bool inPlace = !fromShapes && streaming && maskSource.IsFloatSample() && (maskSource.BitsPerSample() == 32) &&
+        (maskSource.Width() == image.Width()) && (maskSource.Height() == image.Height());
+    AutoViewLock maskLock(dustMaskView, false);
+    ImageVariant fullMask;
+    DFScratchFile scratch;
+    Array<const float*> maskPlanes;
+    if (inPlace) {
+        if (dustMaskView.FullId() != id)
+            maskLock.Lock();
+        for (int c = 0; c < maskSource.NumberOfChannels(); c++)
+            maskPlanes << static_cast<const Image&>(*maskSource).PixelData(c);
+    } else if (!fromShapes) {
+        DFStageTimer stage(profile, "Mask preparation", memory);
+        // The float copy of the mask and, when it is resampled, its copy at
+        // the size of the image are held together until they are spilled.
+        const size_type copied = size_type(maskSource.Width()) * maskSource.Height() * maskSource.NumberOfChannels() * sizeof(float);
+        const size_type resampled = ((maskSource.Width() != image.Width()) || (maskSource.Height() != image.Height())) ?
+            size_type(image.Width()) * image.Height() * maskSource.NumberOfChannels() * sizeof(float) : 0;
+        if ((budget > 0) && (memory.Current() + copied + resampled > budget))
+            throw Error(String().Format("The memory budget is too small: at least %.0f MiB are required.",
+                (memory.Current() + copied + resampled) / 1048576.0));
+        memory.Acquire(copied + resampled);
+        fullMask.CreateFloatImage(32);
+        {
+            AutoViewLock viewLock(dustMaskView);
+            fullMask.CopyImage(dustMaskView.Image());
+        }
+        fullMask.SetStatusCallback(nullptr);
+        if ((fullMask.Width() != image.Width()) || (fullMask.Height() != image.Height())) {
+            BicubicFilterPixelInterpolation bs(2, 2, CubicBSplineFilter());
+            Resample rs(bs, double(image.Width()) / fullMask.Width(), double(image.Height()) / fullMask.Height());
+            rs >> fullMask;
+        }
+        const Image& maskImage = static_cast<const Image&>(*fullMask);
+        if (streaming) {
+            const size_type plane = size_type(image.Width()) * image.Height();
+            if (!scratch.Create(plane * sizeof(float) * maskImage.NumberOfChannels()))
+                throw Error("Unable to create a scratch file for the dust mask.");
+            for (int c = 0; c < maskImage.NumberOfChannels(); c++) {
+                float* spilled = static_cast<float*>(scratch.Data()) + c * plane;
+                std::copy(maskImage.PixelData(c), maskImage.PixelData(c) + plane, spilled);
+                maskPlanes << spilled;
+            }
+            fullMask.FreeImage();
+            memory.Release(copied + resampled);
+            console.WriteLn(String().Format("Dust mask spilled to a scratch file: %.1f MiB", scratch.Size() / 1048576.0));
+        } else {
+            memory.Release(copied + resampled);
+            memory.Acquire(fullMask.ImageSize());
+            for (int c = 0; c < maskImage.NumberOfChannels(); c++)
+                maskPlanes << maskImage.PixelData(c);
+        }
+    }
+    const int reach = pipelineReach();
+
+    // The image is split into the fewest tiles whose windows, grown by the
+    // reach of the pipeline, fit in the memory budget; streaming without a
+    // budget uses tiles four times the reach across.
+    const size_type held = memory.Current();
+    int tileWidth = image.Width();
+    int tileHeight = image.Height();
+    auto chooseTiles = [&]() {
+        if (budget == 0)
+            tileWidth = tileHeight = downsample * ((pcl::Max(2048, 4 * reach) + downsample - 1) / downsample);
+        else
+            for (int n = streaming ? 1 : 2;; n++) {
+                tileWidth = downsample * ((image.Width() + n * downsample - 1) / (n * downsample));
+                tileHeight = downsample * ((image.Height() + n * downsample - 1) / (n * downsample));
+                const size_type peak = held + predictedPeakMemory(pcl::Min(tileWidth + 2 * reach, image.Width()),
+                    pcl::Min(tileHeight + 2 * reach, image.Height()), image.NumberOfChannels(), workingBits);
+                if (peak <= budget)
+                    break;
+                if ((tileWidth <= downsample) && (tileHeight <= downsample))
+                    throw Error(String().Format("The memory budget is too small: at least %.0f MiB are required.", peak / 1048576.0));
+            }
+    };
+    auto addTiles = [&](Array<Rect>& windows, Array<Rect>& cores) {
+        for (int y = 0; y < image.Height(); y += tileHeight)
+            for (int x = 0; x < image.Width(); x += tileWidth) {
+                Rect core(x, y, pcl::Min(x + tileWidth, image.Width()), pcl::Min(y + tileHeight, image.Height()));
+                cores << core;
+                windows << Rect(pcl::Max(core.x0 - reach, 0), pcl::Max(core.y0 - reach, 0),
+                                pcl::Min(core.x1 + reach, image.Width()), pcl::Min(core.y1 + reach, image.Height()));
+            }
+    };
+
+    Array<Rect> windows;
+    Array<Rect> cores;
+    if (dustRegionsOnly) {
+        // Dust regions only: the correction is zero away from the dust, so only
+        // windows around each dust mote are processed. Each connected component
+        // of the mask is grown by the reach of the pipeline and, for the
+        // inpainting, by half the size of the mote, which is how far its rays
+        // must go to find valid samples. Windows that overlap are merged.
+        DFStageTimer stage(profile, "Dust regions", memory);
+        std::vector<DFRect> components;
+        if (fromShapes)
+            components = DFShapeComponents(shapes.data(), shapes.size(), origin.x, origin.y, image.Width(), image.Height());
+        else if (compiled.hasComponents)
+            components = compiled.components;
+        else {
+            components = DFComponentBounds(maskPlanes.Begin(), int(maskPlanes.Length()), image.Width(), image.Height(), 0.5f);
+            if (!dustMaskFile.IsEmpty()) {
+                compiled.components = components;
+                compiled.hasComponents = true;
+                saveCompiledMask(compiled);
+            }
+        }
+        std::vector<int> margins;
+        for (DFRect& b : components) {
+            // Keep windows aligned with the downsampling grid.
+            b.x0 -= b.x0 % downsample;
+            b.y0 -= b.y0 % downsample;
+            margins.push_back(reach + downsample * ((pcl::Max(b.Width(), b.Height()) / 2 + downsample - 1) / downsample));
+        }
+        size_type area = 0;
+        for (const DFRect& r : DFGrowRegions(components, margins, image.Width(), image.Height())) {
+            windows << Rect(r.x0, r.y0, r.x1, r.y1);
+            area += size_type(r.Width()) * r.Height();
+        }
+        cores = windows;
+        console.WriteLn(String().Format("%u dust region(s), %.1f%% of the image", windows.Length(),
+            100.0 * area / (size_type(image.Width()) * image.Height())));
+    } else {
+        // Tiles: only the core of each window is written back.
+        chooseTiles();
+        addTiles(windows, cores);
+        console.WriteLn(String().Format(streaming ? "Streaming %u tiles of %dx%d pixels" :
+            "Memory budget exceeded: processing %u tiles of %dx%d pixels", cores.Length(), tileWidth, tileHeight));
+    }
+
+    // Windows are thresholded against the star response range of the whole
+    // image, so that their star masks match the one of a single pass. Dust
+    // regions do not cover the image: their range is measured on tiles of it,
+    // or on the whole image at once when there is neither a budget nor
+    // streaming.
+    Array<Rect> rangeWindows = windows;
+    Array<Rect> rangeCores = cores;
+    if (dustRegionsOnly) {
+        rangeWindows.Clear();
+        rangeCores.Clear();
+        if (streaming || (budget > 0))
+            chooseTiles();
+        addTiles(rangeWindows, rangeCores);
+    }
+    StatusMonitor monitor;
+    monitor.SetCallback(status);
+    {
+        DFStageTimer stage(profile, "Star range", memory);
+        monitor.Initialize("Measuring star response", rangeWindows.Length());
+        if (image.IsFloatSample())
+            switch (image.BitsPerSample()) {
+            case 32: measureStarRange(static_cast<const Image&>(*image), rangeWindows, rangeCores, monitor); break;
+            case 64: measureStarRange(static_cast<const DImage&>(*image), rangeWindows, rangeCores, monitor); break;
+            }
+        else
+            switch (image.BitsPerSample()) {
+            case 8: measureStarRange(static_cast<const UInt8Image&>(*image), rangeWindows, rangeCores, monitor); break;
+            case 16: measureStarRange(static_cast<const UInt16Image&>(*image), rangeWindows, rangeCores, monitor); break;
+            case 32: measureStarRange(static_cast<const UInt32Image&>(*image), rangeWindows, rangeCores, monitor); break;
+            }
+        monitor.Complete();
+    }
+    monitor.Initialize(dustRegionsOnly ? "Processing dust regions" : "Processing tiles", windows.Length());
+    if (image.IsFloatSample())
+        switch (image.BitsPerSample()) {
+        case 32: processRegions(static_cast<Image&>(*image), maskPlanes, windows, cores, monitor); break;
+        case 64: processRegions(static_cast<DImage&>(*image), maskPlanes, windows, cores, monitor); break;
+        }
+    else
+        switch (image.BitsPerSample()) {
+        case 8: processRegions(static_cast<UInt8Image&>(*image), maskPlanes, windows, cores, monitor); break;
+        case 16: processRegions(static_cast<UInt16Image&>(*image), maskPlanes, windows, cores, monitor); break;
+        case 32: processRegions(static_cast<UInt32Image&>(*image), maskPlanes, windows, cores, monitor); break;
+        }
+    monitor.Complete();
+    console.WriteLn(String().Format("Peak memory of pipeline buffers: %.1f MiB", memory.Peak() / 1048576.0));
+    console.WriteLn("<raw>" + String(profile.Table().c_str()) + "</raw>");
+}
+
+bool DustFreeInstance::loadCompiledMask(DFCompiledMask& compiled, uint64 revision, int width, int height) const
+{
+    // A file compiled from another mask, or for images of another size, is
+    // stale; without a mask image to check against, any revision is accepted.
+    if (!File::Exists(dustMaskFile))
+        return false;
+    ByteArray data = File::ReadFile(dustMaskFile);
+    return compiled.Deserialize(data.Begin(), data.Length()) &&
+        ((revision == 0) || (compiled.source == revision)) && (compiled.width == width) && (compiled.height == height);
+}
+
+void DustFreeInstance::saveCompiledMask(const DFCompiledMask& compiled) const
+{
+    std::vector<uint8_t> data = compiled.Serialize();
+    File::WriteFile(dustMaskFile, data.data(), data.size());
+}
+
+int DustFreeInstance::pipelineReach() const
+{
+    // Support of the smoothing filter, exp(-r^5/(5 sigma^5)) > 0.01, or three
+    // standard deviations of the recursive Gaussian; then the star mask
+    // dilation and the support of the wavelet scales used to detect stars.
+    const double sigma = pcl::Pow(1.7, double(smoothness));
+    const double blurRadius = (smoothingMethod == DFSmoothingMethod::Recursive) ?
+        3 * DFEquivalentGaussianSigma(sigma, 5.0) : sigma * pcl::Pow(5 * pcl::Ln(100.0), 0.2);
+    return downsample * (pcl::CeilInt(blurRadius) + 2 * starDiffusionDistance + 3 + 32);
+}
+
+size_type DustFreeInstance::predictedPeakMemory(int width, int height, int channels, int bitsPerSample) const
+{
+    const size_type w = (width + downsample - 1) / downsample;
+    const size_type h = (height + downsample - 1) / downsample;
+    const size_type plane = w * h * (bitsPerSample >> 3);
+    const size_type image = plane * channels;
+    const size_type bits = channels * ((w + 63) >> 6) * 8 * h;
+
+    // Star detection: the band-pass responses and two scratch planes, or the
+    // star mask and the layers of the multiscale transform.
+    size_type peak = image + bits +
+        ((starDetectionMethod == DFStarDetectionMethod::BandPass) ? image + 2 * plane : 6 * image);
+
+    // Dust mask at the downsampled size, plus both bit masks.
+    peak = pcl::Max(peak, image + w * h * 4 * channels + 2 * bits);
+
+    // Inpainting: both backgrounds and both fills, or three buffers when they
+    // run one after the other under a budget; plus the scratch of the engine.
+    const bool sequential = memoryBudget > 0;
+    size_type scratch = 0;
+    if (inpaintMethod == DFInpaintMethod::NearestSample)
+        scratch = (sequential ? 1 : 2) * channels * w * h * (DFSiteIndexFits<int32_t>(int(w), int(h)) ? 4 : 8);
+    else if (inpaintMethod == DFInpaintMethod::PushPull)
+        scratch = (sequential ? 1 : 2) * channels * plane;
+    peak = pcl::Max(peak, (sequential ? 3 : 4) * image + 2 * bits + scratch);
+
+    // Smoothing: the correction, plus the padded transforms of the image and
+    // of the filter for the FFT convolution.
+    size_type smoothing = image;
+    if (smoothingMethod != DFSmoothingMethod::Recursive) {
+        const size_type support = 2 * size_type(pcl::CeilInt(pcl::Pow(1.7, double(smoothness)) * pcl::Pow(5 * pcl::Ln(100.0), 0.2))) + 1;
+        smoothing += 2 * (w + support) * (h + support) * 2 * (bitsPerSample >> 3);
+    }
+    return pcl::Max(peak, smoothing);
+}
+
+uint64 DustFreeInstance::starsKey() const
+{
+    uint64 key = CombineKey(imageKey, 1);
+    key = CombineKey(key, downsample);
+    key = CombineKey(key, starDetectionSensitivity);
+    key = CombineKey(key, starDetectionMethod);
+    key = CombineKey(key, floatIntermediates);
+    return CombineKey(key, starDiffusionDistance);
+}
+
+uint64 DustFreeInstance::differenceKey() const
+{
+    uint64 key = CombineKey(starsKey(), 2);
+    key = pcl::Hash64(&maskKey, sizeof(maskKey), key);
+    key = CombineKey(key, inpaintMethod);
+    return CombineKey(key, tiledInpainting);
+}
+
+void DustFreeInstance::processImage(ImageVariant& image, ImageVariant& dustMask, const IsoString& backgroundId)
+{
+    // The difference of the fills depends only on the image, the dust mask and
+    // the parameters of the detection and the inpainting. When a previous run
+    // left it in the cache, only the smoothing is redone.
+    ImageVariant correction;
+    const StageResult* cached = (imageKey != 0) ? TheStageCache.Find(differenceKey()) : nullptr;
+    if (cached != nullptr) {
+        DFStageTimer stage(profile, "Cached difference", memory);
+        memory.Release(dustMask.ImageSize());
+        dustMask.FreeImage();
+        correction.CopyImage(cached->difference);
+        correction.EnsureUniqueImage();
+        correction.SetStatusCallback(nullptr);
+        memory.Acquire(correction.ImageSize());
+        image.Status().Initialize("Smoothing cached correction", 1);
+    } else {
+        if (!computeDifference(image, dustMask, backgroundId, correction))
+            return;
+        if (imageKey != 0) {
+            StageResult result;
+            result.difference.CopyImage(correction);
+            CacheResult(differenceKey(), result, correction.ImageSize(), memory);
+        }
+    }
+
+    // Blur and apply. Convolution and resampling are linear, so blurring and
+    // upsampling the difference once is the same as doing it on both fills.
+    // The recursive filter replaces the variable shape kernel with the Gaussian
+    // of the same variance.
+    DFStageTimer stage(profile, "Smoothing", memory);
+    if (smoothingMethod == DFSmoothingMethod::Recursive) {
+        const double sigma = DFEquivalentGaussianSigma(pcl::Pow(1.7, double(smoothness)), 5.0);
+        if (correction.BitsPerSample() == 32)
+            SmoothChannels(static_cast<Image&>(*correction), sigma);
+        else if (correction.BitsPerSample() == 64)
+            SmoothChannels(static_cast<DImage&>(*correction), sigma);
+    } else {
+        VariableShapeFilter H2(pcl::Pow(1.7f, smoothness), 5.0f, 0.01f, 1.0f, 0.0f);
+        FFTConvolution(H2) >> correction;
+    }
+    image.Status() += 1;
+    image.Status().Complete();
+
+    stage.Next("Correction");
+    ApplyCorrection(image, correction);
+    memory.Release(correction.ImageSize());
+}
+
+bool DustFreeInstance::computeDifference(ImageVariant& image, ImageVariant& dustMask, const IsoString& backgroundId,
+    ImageVariant& correction)
+{
+    // Downsample
+    DFStageTimer stage(profile, "Downsampling", memory);
+    ImageVariant bg;
+    WorkingImage(image, downsample, floatIntermediates, bg);
+    memory.Acquire(bg.ImageSize());
+
+    // Star detection. Once binarized, the star mask is kept packed one bit per
+    // pixel: dilation, inversion and masking of the background work on words.
+    // The response is normalized to its range over the whole image, which is
+    // fixed beforehand when the image is processed in tiles.
+    stage.Next("Star detection");
+    Array<DFBitMask> skyMask;
+    const double threshold = pcl::Pow10(-starDetectionSensitivity);
+    const StageResult* cachedStars = (imageKey != 0) ? TheStageCache.Find(starsKey()) : nullptr;
+    const bool detect = cachedStars == nullptr;
+    image.Status().Initialize("Performing star detection", 3);
+    if (!detect) {
+        skyMask = cachedStars->stars;
+        image.Status() += 2;
+    } else if (starDetectionMethod == DFStarDetectionMethod::BandPass) {
+        const double* range = fixedStarRange ? starRange : nullptr;
+        if (bg.BitsPerSample() == 32)
+            skyMask = DetectStars(static_cast<const Image&>(*bg), threshold, range);
+        else if (bg.BitsPerSample() == 64)
+            skyMask = DetectStars(static_cast<const DImage&>(*bg), threshold, range);
+        image.Status() += 2;
+    } else {
+        ImageVariant starMask;
+        starMask.CopyImage(bg);
+        starMask.EnsureUniqueImage();
+        starMask.SetStatusCallback(nullptr);
+        memory.Acquire(starMask.ImageSize());
+        MultiscaleStarResponse(starMask);
+        const double low = fixedStarRange ? starRange[0] : starMask.MinimumSampleValue();
+        const double high = fixedStarRange ? starRange[1] : starMask.MaximumSampleValue();
+        image.Status() += 1;
+
+        // The median commutes with the normalization, and normalizing and
+        // thresholding is thresholding at the level that normalizes to the
+        // threshold. A flat response is left unscaled.
+        MorphologicalTransformation mf;
+        mf.SetStructure(BoxStructure(3));
+        mf.SetOperator(MedianFilter());
+        mf >> starMask;
+        skyMask = BinarizeChannels(starMask, (high > low) ? low + threshold * (high - low) : threshold);
+        memory.Release(starMask.ImageSize());
+        image.Status() += 1;
+    }
+    for (const DFBitMask& m : skyMask)
+        memory.Acquire(m.MemorySize());
+
+    if (detect) {
+        size_type bytes = 0;
+        for (DFBitMask& m : skyMask) {
+            m.Dilate(2 * starDiffusionDistance + 3);
+            m.Invert();
+            bytes += m.MemorySize();
+        }
+        if (imageKey != 0) {
+            StageResult result;
+            result.stars = skyMask;
+            CacheResult(starsKey(), result, bytes, memory);
+        }
+    }
+    image.Status() += 1;
+
+    // Extract background
+    stage.Next("Background extraction");
+    image.Status().Initialize("Extracting background", 2 * image.NumberOfChannels() + 4);
+    SelectChannels(bg, skyMask);
+    image.Status() += 1;
+
+    if (testSkyDetection) {
+        memory.Release(bg.ImageSize());
+        memory.Release(dustMask.ImageSize());
+        ImageWindow OutputWindow = ImageWindow(bg.Width(), bg.Height(), bg.NumberOfChannels(), bg.BitsPerSample(), true, bg.IsColor(), true, backgroundId);
+        if (OutputWindow.IsNull())
+            throw Error("Unable to create image window: " + backgroundId);
+        OutputWindow.MainView().Lock();
+        OutputWindow.MainView().Image().CopyImage(bg);
+        OutputWindow.MainView().Unlock();
+        OutputWindow.Show();
+
+        return false;
+    }
+
+    // Apply dust mask. A gray mask applies to every channel. The dust-free
+    // masks come from the compiled dust mask when it has this level, and are
+    // added to it otherwise; shapes are always gray.
+    Array<DFBitMask> dustFree;
+    const std::vector<DFBitMask>* compiledLevel = nullptr;
+    if (compiledMask != nullptr) {
+        auto i = compiledMask->levels.find(downsample);
+        if (i != compiledMask->levels.end())
+            compiledLevel = &i->second;
+    }
+    const std::vector<DFDustShape> shapes = enabledDustShapes();
+    if (compiledLevel != nullptr) {
+        for (const DFBitMask& m : *compiledLevel)
+            dustFree << m;
+    } else if (!shapes.empty()) {
+        // Shapes are drawn straight into the mask at the working resolution.
+        DFBitMask mask(bg.Width(), bg.Height());
+        DFRasterizeShapes(shapes.data(), shapes.size(), shapeOrigin.x, shapeOrigin.y, shapeScale * downsample, mask);
+        mask.Invert();
+        dustFree << mask;
+    } else {
+        if ((dustMask.Width() != bg.Width()) || (dustMask.Height() != bg.Height())) {
+            memory.Release(dustMask.ImageSize());
+            BicubicFilterPixelInterpolation bs(2, 2, CubicBSplineFilter());
+            Resample rs(bs, double(bg.Width()) / dustMask.Width(), double(bg.Height()) / dustMask.Height());
+            rs >> dustMask;
+            memory.Acquire(dustMask.ImageSize());
+        }
+        dustFree = BinarizeChannels(dustMask, 0.5);
+        for (DFBitMask& m : dustFree)
+            m.Invert();
+        if (compiledMask != nullptr) {
+            compiledMask->levels[downsample] = std::vector<DFBitMask>(dustFree.Begin(), dustFree.End());
+            compiledMaskChanged = true;
+        }
+    }
+    memory.Release(dustMask.ImageSize());
+    dustMask.FreeImage();
+    if ((dustFree.Length() == 1) && (bg.NumberOfChannels() > 1))
+        dustFree = Array<DFBitMask>(bg.NumberOfChannels(), dustFree[0]);
+
+    if (int(dustFree.Length()) != bg.NumberOfChannels())
+        throw Error("Number of channels of non-sky mask mismatch with the image being processed.");
+
+    for (const DFBitMask& m : dustFree)
+        memory.Acquire(m.MemorySize());
+    ImageVariant dustBg;
+    dustBg.CopyImage(bg);
+    dustBg.EnsureUniqueImage();
+    dustBg.SetStatusCallback(nullptr);
+    memory.Acquire(dustBg.ImageSize());
+    SelectChannels(dustBg, dustFree);
+    image.Status() += 1;
+
+    // Inpaint both backgrounds. The correction is their difference: the
+    // dust-masked fill minus the star-masked fill. Normally both fills run in a
+    // single batch; under a memory budget they run one after the other, and the
+    // dust fill is written over the star background, which is dead by then.
+    stage.Next("Inpainting");
+    const bool sequential = memoryBudget > 0;
+    ImageVariant bg0;
+    bg0.CopyImage(bg);
+    bg0.EnsureUniqueImage();
+    bg0.SetStatusCallback(nullptr);
+    memory.Acquire(bg0.ImageSize());
+    if (sequential)
+        correction = bg;
+    else {
+        correction.CopyImage(dustBg);
+        correction.EnsureUniqueImage();
+        correction.SetStatusCallback(nullptr);
+        memory.Acquire(correction.ImageSize());
+    }
+    image.Status() += 1;
+    if (bg.BitsPerSample() == 32)
+        inpaintBackgrounds(static_cast<Image&>(*bg), static_cast<const Image&>(*dustBg), static_cast<Image&>(*bg0), static_cast<Image&>(*correction), sequential, image.Status());
+    else if (bg.BitsPerSample() == 64)
+        inpaintBackgrounds(static_cast<DImage&>(*bg), static_cast<const DImage&>(*dustBg), static_cast<DImage&>(*bg0), static_cast<DImage&>(*correction), sequential, image.Status());
+    memory.Release(dustBg.ImageSize());
+    dustBg.FreeImage();
+    if (!sequential) {
+        memory.Release(bg.ImageSize());
+        bg.FreeImage();
+    }
+    correction.Subtract(bg0);
+    memory.Release(bg0.ImageSize());
+    bg0.FreeImage();
+    for (const DFBitMask& m : skyMask)
+        memory.Release(m.MemorySize());
+    for (const DFBitMask& m : dustFree)
+        memory.Release(m.MemorySize());
+    skyMask.Clear();
+    dustFree.Clear();
+
+    return true;
+}
+
+void DustFreeInstance::processPreview(ImageVariant& image, ImageVariant& dustMask, const Point& origin, int scale,
+    bool coarse) const
+{
+    // The preview shows the image at 1:scale from origin. The pipeline runs on
+    // it at the nearest integer downsampling, doubled for a coarse preview, and
+    // the distances given in downsampled pixels are rescaled to match.
+    DustFreeInstance preview(*this);
+    preview.downsample = pcl::Max(1, pcl::RoundInt(double(downsample) / scale)) * (coarse ? 2 : 1);
+    const double k = double(downsample) / (preview.downsample * scale);
+    preview.starDiffusionDistance = int8(pcl::RoundInt(starDiffusionDistance * k));
+    preview.smoothness = float(smoothness + pcl::Ln(k) / pcl::Ln(1.7));
+    preview.testSkyDetection = false;
+    preview.dustRegionsOnly = false;
+    preview.streaming = false;
+    preview.memoryBudget = 0;
+    preview.shapeOrigin = origin;
+    preview.shapeScale = scale;
+    preview.processImage(image, dustMask, IsoString());
+}
+
+void* DustFreeInstance::LockParameter(const MetaParameter* p, size_type tableRow)
+{
+    if (p == TheDFStarDetectionSensitivityParameter)
+        return &starDetectionSensitivity;
+    if (p == TheDFStarDiffusionDistanceParameter)
+        return &starDiffusionDistance;
+    if (p == TheDFSmoothnessParameter)
+        return &smoothness;
+    if (p == TheDFDownsampleParameter)
+        return &downsample;
+    if (p == TheDFTestSkyDetectionParameter)
+        return &testSkyDetection;
+    if (p == TheDFInpaintMethodParameter)
+        return &inpaintMethod;
+    if (p == TheDFTiledInpaintingParameter)
+        return &tiledInpainting;
+    if (p == TheDFDustRegionsOnlyParameter)
+        return &dustRegionsOnly;
+    if (p == TheDFStarDetectionMethodParameter)
+        return &starDetectionMethod;
+    if (p == TheDFSmoothingMethodParameter)
+        return &smoothingMethod;
+    if (p == TheDFMemoryBudgetParameter)
+        return &memoryBudget;
+    if (p == TheDFStreamingParameter)
+        return &streaming;
+    if (p == TheDFFloatIntermediatesParameter)
+        return &floatIntermediates;
+    if (p == TheDFCacheSizeParameter)
+        return &cacheSize;
+    if (p == TheDFDustMaskFileParameter)
+        return dustMaskFile.Begin();
+    if (p == TheDFDustShapeEnabledParameter)
+        return &dustShapes[tableRow].enabled;
+    if (p == TheDFDustShapeXParameter)
+        return &dustShapes[tableRow].x;
+    if (p == TheDFDustShapeYParameter)
+        return &dustShapes[tableRow].y;
+    if (p == TheDFDustShapeRadiusParameter)
+        return &dustShapes[tableRow].radius;
+    if (p == TheDFDustShapeInnerRadiusParameter)
+        return &dustShapes[tableRow].innerRadius;
+    if (p == TheDFDustShapeAxisRatioParameter)
+        return &dustShapes[tableRow].axisRatio;
+    if (p == TheDFDustShapeAngleParameter)
+        return &dustShapes[tableRow].angle;
+    if (p == TheDFDustShapeFeatherParameter)
+        return &dustShapes[tableRow].feather;
+    if (p == TheDFTargetFrameEnabledParameter)
+        return &targetFrames[tableRow].enabled;
+    if (p == TheDFTargetFramePathParameter)
+        return targetFrames[tableRow].path.Begin();
+    if (p == TheDFOutputDirectoryParameter)
+        return outputDirectory.Begin();
+    if (p == TheDFOutputPostfixParameter)
+        return outputPostfix.Begin();
+    if (p == TheDFOverwriteExistingFilesParameter)
+        return &overwriteExistingFiles;
+    if (p == TheDFFramesInFlightParameter)
+        return &framesInFlight;
+    if (p == TheDFTraceFileParameter)
+        return traceFile.Begin();
+    return 0;
+}
+
+bool DustFreeInstance::AllocateParameter(size_type sizeOrLength, const MetaParameter* p, size_type tableRow)
+{
+    String* value = nullptr;
+    if (p == TheDFDustMaskFileParameter)
+        value = &dustMaskFile;
+    else if (p == TheDFDustShapesParameter) {
+        dustShapes.Clear();
+        if (sizeOrLength > 0)
+            dustShapes.Add(DustShape(), sizeOrLength);
+        return true;
+    } else if (p == TheDFTargetFramesParameter) {
+        targetFrames.Clear();
+        if (sizeOrLength > 0)
+            targetFrames.Add(TargetFrame(), sizeOrLength);
+        return true;
+    } else if (p == TheDFTargetFramePathParameter)
+        value = &targetFrames[tableRow].path;
+    else if (p == TheDFOutputDirectoryParameter)
+        value = &outputDirectory;
+    else if (p == TheDFOutputPostfixParameter)
+        value = &outputPostfix;
+    else if (p == TheDFTraceFileParameter)
+        value = &traceFile;
+    else
+        return false;
+
+    value->Clear();
+    if (sizeOrLength > 0)
+        value->SetLength(sizeOrLength);
+    return true;
+}
+
+size_type DustFreeInstance::ParameterLength(const MetaParameter* p, size_type tableRow) const
+{
+    if (p == TheDFDustMaskFileParameter)
+        return dustMaskFile.Length();
+    if (p == TheDFDustShapesParameter)
+        return dustShapes.Length();
+    if (p == TheDFTargetFramesParameter)
+        return targetFrames.Length();
+    if (p == TheDFTargetFramePathParameter)
+        return targetFrames[tableRow].path.Length();
+    if (p == TheDFOutputDirectoryParameter)
+        return outputDirectory.Length();
+    if (p == TheDFOutputPostfixParameter)
+        return outputPostfix.Length();
+    if (p == TheDFTraceFileParameter)
+        return traceFile.Length();
+    return 0;
+}
+
+template <class P>
+void DustFreeInstance::processRegions(GenericImage<P>& image, const Array<const float*>& dustMask, const Array<Rect>& windows,
+    const Array<Rect>& cores, StatusMonitor& monitor)
+{
+    const int channels = int(dustMask.Length());
+    const Point origin = shapeOrigin;
+    for (size_type i = 0; i < windows.Length(); i++) {
+        const Rect& w = windows[i];
+        const Rect& c = cores[i];
+        GenericImage<P> region;
+        region.Assign(image, w);
+        memory.Acquire(region.ImageSize());
+        Image regionMask;
+        if (channels > 0) {
+            regionMask.AllocateData(w.Width(), w.Height(), channels, (channels < 3) ? ColorSpace::Gray : ColorSpace::RGB);
+            for (int ch = 0; ch < channels; ch++)
+                for (int y = 0; y < w.Height(); y++) {
+                    const float* row = dustMask[ch] + size_type(w.y0 + y) * image.Width() + w.x0;
+                    std::copy(row, row + w.Width(), regionMask.ScanLine(y, ch));
+                }
+            memory.Acquire(regionMask.ImageSize());
+        }
+        ImageVariant regionImage(&region);
+        ImageVariant regionDustMask(&regionMask);
+        shapeOrigin = origin + w.LeftTop();
+        processImage(regionImage, regionDustMask, IsoString());
+        memory.Release(region.ImageSize());
+        if (c != w)
+            region.CropTo(Rect(c.x0 - w.x0, c.y0 - w.y0, c.x1 - w.x0, c.y1 - w.y0));
+        image.Apply(region, ImageOp::Mov, c.LeftTop());
+        ++monitor;
+    }
+    shapeOrigin = origin;
+}
+
+template <class P>
+void DustFreeInstance::measureStarRange(const GenericImage<P>& image, const Array<Rect>& windows, const Array<Rect>& cores,
+    StatusMonitor& monitor)
+{
+    // Star detection normalizes its response to the range of the image. The
+    // range over the core of every window is the range of the whole image as
+    // long as the windows cover the support of the detection filters.
+    double low = 1;
+    double high = 0;
+    for (size_type i = 0; i < windows.Length(); i++) {
+        const Rect& w = windows[i];
+        const Rect& c = cores[i];
+        GenericImage<P> region;
+        region.Assign(image, w);
+        memory.Acquire(region.ImageSize());
+        ImageVariant bg(&region);
+        if (WorkingInFloat(bg, floatIntermediates)) {
+            ImageVariant working;
+            WorkingImage(bg, downsample, floatIntermediates, working);
+            memory.Release(region.ImageSize());
+            region.FreeData();
+            bg = working;
+            memory.Acquire(bg.ImageSize());
+        } else if (downsample > 1) {
+            memory.Release(region.ImageSize());
+            IntegerResample ir(-downsample);
+            ir >> bg;
+            memory.Acquire(region.ImageSize());
+        }
+        const Rect core((c.x0 - w.x0) / downsample, (c.y0 - w.y0) / downsample,
+                        pcl::Min((c.x1 - w.x0 + downsample - 1) / downsample, bg.Width()),
+                        pcl::Min((c.y1 - w.y0 + downsample - 1) / downsample, bg.Height()));
+        if (starDetectionMethod == DFStarDetectionMethod::BandPass) {
+            memory.Acquire(3 * bg.ImageSize());
+            StarResponseRange(bg, core, low, high);
+            memory.Release(3 * bg.ImageSize());
+        } else {
+            memory.Acquire(5 * bg.ImageSize());
+            MultiscaleStarResponse(bg);
+            memory.Release(5 * bg.ImageSize());
+            low = pcl::Min(low, bg.MinimumSampleValue(core));
+            high = pcl::Max(high, bg.MaximumSampleValue(core));
+        }
+        memory.Release(bg.ImageSize());
+        ++monitor;
+    }
+    fixedStarRange = true;
+    starRange[0] = low;
+    starRange[1] = high;
+}
+
+template <class P>
+void DustFreeInstance::inpaintBackgrounds(GenericImage<P>& starBg, const GenericImage<P>& dustBg,
+    GenericImage<P>& starFilled, GenericImage<P>& dustFilled, bool sequential, StatusMonitor& status)
+{
+    typedef typename P::sample sample;
+    const int width = starBg.Width();
+    const int height = starBg.Height();
+    const int channels = starBg.NumberOfChannels();
+    const int method = inpaintMethod;
+    const bool tiled = tiledInpainting;
+    DFInpaintCounter* const counter = profile.InpaintCounter();
+
+    // Every background is an independent task; the kernels split their own work
+    // into nested tasks, so idle threads pick up whatever is left of any of them.
+    // The ray march walks all channels of a background at once; the other
+    // engines run a task per channel.
+    DFTaskGroup batch;
+    auto submit = [&](const GenericImage<P>& input, GenericImage<P>& output) {
+        if (method == DFInpaintMethod::RayMarch) {
+            batch.Run([=, &input, &output]() {
+                Array<const sample*> in;
+                Array<sample*> out;
+                for (int c = 0; c < channels; c++) {
+                    in << input.PixelData(c);
+                    out << output.PixelData(c);
+                }
+                DFInpaintRayMarch(in.Begin(), out.Begin(), channels, width, height, tiled, counter);
+            });
+            return;
+        }
+        for (int c = 0; c < channels; c++)
+            batch.Run([=, &input, &output]() {
+                if (method == DFInpaintMethod::NearestSample)
+                    DFInpaintNearestSample(input.PixelData(c), output.PixelData(c), width, height, counter);
+                else
+                    DFInpaintPushPull(input.PixelData(c), output.PixelData(c), width, height, counter);
+            });
+    };
+    submit(starBg, starFilled);
+    if (sequential)
+        batch.Wait();
+    submit(dustBg, dustFilled);
+    batch.Wait();
+    status += 2 * channels;
+}
+
+}	// namespace pcl
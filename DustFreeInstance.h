@@ -1,40 +1,136 @@
-#ifndef __DustFreeInstance_h
-#define __DustFreeInstance_h
-
-#include <pcl/ProcessImplementation.h>
-#include <pcl/MetaParameter.h> // pcl_enum
-
-namespace pcl
-{
-
-class DustFreeInstance : public ProcessImplementation
-{
-public:
-    DustFreeInstance(const MetaProcess*);
-    DustFreeInstance(const DustFreeInstance&);
-
-    void Assign(const ProcessImplementation&) override;
-    bool IsHistoryUpdater(const View& v) const override;
-    UndoFlags UndoMode(const View&) const override;
-    bool CanExecuteOn(const View&, pcl::String& whyNot) const override;
-    bool ExecuteOn(View&) override;
-    void* LockParameter(const MetaParameter*, size_type tableRow) override;
-
-private:
-    float starDetectionSensitivity;
-    int starDiffusionDistance;
-    String dustMaskViewId;
-    float smoothness;
-    int downsample;
-    bool testSkyDetection;
-
-    template <class P>
-    static void inpaint(DustFreeInstance* dustFree, ReferenceArray<GenericImage<P>>& inputs, GenericImage<P>& output, int y, int channel);
-
-    friend class DustFreeProcess;
-    friend class DustFreeInterface;
-};
-
-}	// namespace pcl
-
-#endif	// __DustFreeInstance_h
+#ifndef __DustFreeInstance_h
+#define __DustFreeInstance_h
+
+#include <pcl/ProcessImplementation.h>
+#include <pcl/MetaParameter.h> // pcl_enum
+
+#include "DustFreeCompiledMask.h"
+#include "DustFreeMemory.h"
+#include "DustFreeProfile.h"
+#include "DustFreeShapes.h"
+
+namespace pcl
+{
+
+class DustFreeInstance : public ProcessImplementation
+{
+public:
+    DustFreeInstance(const MetaProcess*);
+    DustFreeInstance(const DustFreeInstance&);
+
+    void Assign(const ProcessImplementation&) override;
+    bool IsHistoryUpdater(const View& v) const override;
+    UndoFlags UndoMode(const View&) const override;
+    bool CanExecuteOn(const View&, pcl::String& whyNot) const override;
+    bool ExecuteOn(View&) override;
+    bool CanExecuteGlobal(pcl::String& whyNot) const override;
+    bool ExecuteGlobal() override;
+    void* LockParameter(const MetaParameter*, size_type tableRow) override;
+    bool AllocateParameter(size_type sizeOrLength, const MetaParameter* p, size_type tableRow) override;
+    size_type ParameterLength(const MetaParameter* p, size_type tableRow) const override;
+
+private:
+    float starDetectionSensitivity;
+    int8 starDiffusionDistance;
+    String dustMaskViewId;
+    float smoothness;
+    int downsample;
+    pcl_bool testSkyDetection;
+    pcl_enum inpaintMethod;
+    pcl_bool tiledInpainting;
+    pcl_bool dustRegionsOnly;
+    pcl_enum starDetectionMethod;
+    pcl_enum smoothingMethod;
+    uint32 memoryBudget;
+    pcl_bool streaming;
+    pcl_bool floatIntermediates;
+    uint32 cacheSize;
+    String dustMaskFile;
+
+    struct DustShape
+    {
+        pcl_bool enabled;
+        double   x;
+        double   y;
+        double   radius;
+        double   innerRadius;
+        double   axisRatio;
+        double   angle;
+        double   feather;
+
+        DustShape()
+            : enabled(true), x(0), y(0), radius(10), innerRadius(0), axisRatio(1), angle(0), feather(0)
+        {
+        }
+    };
+    typedef Array<DustShape> shape_list;
+
+    shape_list dustShapes;
+
+    struct TargetFrame
+    {
+        pcl_bool enabled;
+        String   path;
+
+        TargetFrame(const String& path = String())
+            : enabled(true), path(path)
+        {
+        }
+    };
+    typedef Array<TargetFrame> target_list;
+
+    target_list targetFrames;
+    String outputDirectory;
+    String outputPostfix;
+    pcl_bool overwriteExistingFiles;
+    uint32 framesInFlight;
+    String traceFile;
+
+    DFMemoryLedger memory;
+    DFStageProfile profile;
+    bool fixedStarRange = false;
+    double starRange[2];
+    uint64 imageKey = 0;
+    uint64 maskKey = 0;
+    DFCompiledMask* compiledMask = nullptr;
+    bool compiledMaskChanged = false;
+    Point shapeOrigin;
+    int shapeScale = 1;
+
+    std::vector<DFDustShape> enabledDustShapes() const;
+    View selectedDustMask() const;
+    bool cachesResults(bool batch) const;
+    uint64 dustMaskRevision(View& dustMaskView, bool batch) const;
+    void processFrame(ImageVariant& image, const IsoString& id, View& dustMaskView, uint64 maskRevision,
+        DFCompiledMask& compiled, bool batch, const Point& origin = Point(0, 0));
+
+    int pipelineReach() const;
+    size_type predictedPeakMemory(int width, int height, int channels, int bitsPerSample) const;
+
+    bool loadCompiledMask(DFCompiledMask& compiled, uint64 revision, int width, int height) const;
+    void saveCompiledMask(const DFCompiledMask& compiled) const;
+
+    uint64 starsKey() const;
+    uint64 differenceKey() const;
+
+    void processImage(ImageVariant& image, ImageVariant& dustMask, const IsoString& backgroundId);
+    bool computeDifference(ImageVariant& image, ImageVariant& dustMask, const IsoString& backgroundId,
+        ImageVariant& correction);
+    void processPreview(ImageVariant& image, ImageVariant& dustMask, const Point& origin, int scale, bool coarse) const;
+    template <class P>
+    void processRegions(GenericImage<P>& image, const Array<const float*>& dustMask, const Array<Rect>& windows,
+        const Array<Rect>& cores, StatusMonitor& monitor);
+    template <class P>
+    void measureStarRange(const GenericImage<P>& image, const Array<Rect>& windows, const Array<Rect>& cores,
+        StatusMonitor& monitor);
+    template <class P>
+    void inpaintBackgrounds(GenericImage<P>& starBg, const GenericImage<P>& dustBg,
+        GenericImage<P>& starFilled, GenericImage<P>& dustFilled, bool sequential, StatusMonitor& status);
+
+    friend class DustFreeProcess;
+    friend class DustFreeInterface;
+};
+
+}	// namespace pcl
+
+#endif	// __DustFreeInstance_h
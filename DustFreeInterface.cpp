@@ -1,291 +1,992 @@
-#include "DustFreeInterface.h"
-#include "DustFreeParameters.h"
-#include "DustFreeProcess.h"
-
-#include <pcl/ErrorHandler.h>
-#include <pcl/ViewSelectionDialog.h>
-
-namespace pcl
-{
-
-DustFreeInterface* TheDustFreeInterface = nullptr;
-
-DustFreeInterface::DustFreeInterface()
-	: instance(TheDustFreeProcess)
-{
-	TheDustFreeInterface = this;
-}
-
-DustFreeInterface::~DustFreeInterface()
-{
-	if (GUI != nullptr)
-		delete GUI, GUI = nullptr;
-}
-
-IsoString DustFreeInterface::Id() const
-{
-	return "DustFree";
-}
-
-MetaProcess* DustFreeInterface::Process() const
-{
-	return TheDustFreeProcess;
-}
-
-IsoString DustFreeInterface::IconImageSVG() const
-{
-	return TheDustFreeProcess->IconImageSVG();
-}
-
-InterfaceFeatures DustFreeInterface::Features() const
-{
-	return InterfaceFeature::Default;
-}
-
-void DustFreeInterface::ApplyInstance() const
-{
-	instance.LaunchOnCurrentView();
-}
-
-void DustFreeInterface::ResetInstance()
-{
-	DustFreeInstance defaultInstance(TheDustFreeProcess);
-	ImportProcess(defaultInstance);
-}
-
-bool DustFreeInterface::Launch(const MetaProcess& P, const ProcessImplementation*, bool& dynamic, unsigned& /*flags*/)
-{
-	if (GUI == nullptr)
-	{
-		GUI = new GUIData(*this);
-		SetWindowTitle("DustFree");
-		UpdateControls();
-	}
-
-	dynamic = false;
-	return &P == TheDustFreeProcess;
-}
-
-ProcessImplementation* DustFreeInterface::NewProcess() const
-{
-	return new DustFreeInstance(instance);
-}
-
-bool DustFreeInterface::ValidateProcess(const ProcessImplementation& p, String& whyNot) const
-{
-	if (dynamic_cast<const DustFreeInstance*>(&p) != nullptr)
-		return true;
-	whyNot = "Not a DustFree instance.";
-	return false;
-}
-
-bool DustFreeInterface::RequiresInstanceValidation() const
-{
-	return true;
-}
-
-bool DustFreeInterface::ImportProcess(const ProcessImplementation& p)
-{
-	instance.Assign(p);
-	UpdateControls();
-	return true;
-}
-
-#define NO_MASK			String( "<No mask>" )
-#define MASK_ID(x)		(x.IsEmpty() ? NO_MASK : x)
-#define DUST_MASK_ID	MASK_ID(instance.dustMaskViewId)
-
-void DustFreeInterface::UpdateControls()
-{
-	GUI->StarDetectionSensitivity_NumericControl.SetValue(instance.starDetectionSensitivity);
-	GUI->StarDiffusionDistance_NumericControl.SetValue(instance.starDiffusionDistance);
-	GUI->DustMaskView_Edit.SetText(DUST_MASK_ID);
-	GUI->Smoothness_NumericControl.SetValue(instance.smoothness);
-	GUI->Downsample_SpinBox.SetValue(instance.downsample);
-	GUI->TestSkyDetection_CheckBox.SetChecked(instance.testSkyDetection);
-}
-
-void DustFreeInterface::__GetFocus(Control& sender)
-{
-	Edit* e = dynamic_cast<Edit*>(&sender);
-	if (e != nullptr)
-		if (e->Text() == NO_MASK)
-			e->Clear();
-}
-
-void DustFreeInterface::__EditCompleted(Edit& sender)
-{
-	if (sender == GUI->DustMaskView_Edit)
-	{
-		try
-		{
-			String id = sender.Text().Trimmed();
-			if (id == NO_MASK)
-				id.Clear();
-			if (!id.IsEmpty())
-				if (!View::IsValidViewId(id))
-					throw Error("Invalid view identifier: " + id);
-			instance.dustMaskViewId = id;
-			sender.SetText(DUST_MASK_ID);
-		}
-		catch (...)
-		{
-			sender.SetText(DUST_MASK_ID);
-			try
-			{
-				throw;
-			}
-			ERROR_HANDLER
-				sender.SelectAll();
-			sender.Focus();
-		}
-	}
-}
-
-void DustFreeInterface::__EditValueUpdated(NumericEdit& sender, double value)
-{
-	if (sender == GUI->StarDetectionSensitivity_NumericControl)
-		instance.starDetectionSensitivity = value;
-	else if (sender == GUI->StarDiffusionDistance_NumericControl)
-		instance.starDiffusionDistance = value;
-	else if (sender == GUI->Smoothness_NumericControl)
-		instance.smoothness = value;
-}
-
-void DustFreeInterface::__SpinBoxValueUpdated(SpinBox & sender, int value)
-{
-	if (sender == GUI->Downsample_SpinBox)
-		instance.downsample = value;
-}
-
-void DustFreeInterface::__Click(Button& sender, bool checked)
-{
-	if (sender == GUI->DustMaskView_ToolButton) {
-		ViewSelectionDialog d(instance.dustMaskViewId);
-		if (d.Execute() == StdDialogCode::Ok)
-		{
-			instance.dustMaskViewId = d.Id();
-			GUI->DustMaskView_Edit.SetText(DUST_MASK_ID);
-		}
-	} else if (sender == GUI->TestSkyDetection_CheckBox) {
-		instance.testSkyDetection = checked;
-	}
-}
-
-void DustFreeInterface::__ViewDrag(Control& sender, const Point& pos, const View& view, unsigned modifiers, bool& wantsView)
-{
-	if (sender == GUI->DustMaskView_Edit)
-		wantsView = true;
-}
-
-// ----------------------------------------------------------------------------
-
-void DustFreeInterface::__ViewDrop(Control& sender, const Point& pos, const View& view, unsigned modifiers)
-{
-	if (sender == GUI->DustMaskView_Edit) {
-		instance.dustMaskViewId = view.FullId();
-		GUI->DustMaskView_Edit.SetText(DUST_MASK_ID);
-	}
-}
-
-DustFreeInterface::GUIData::GUIData(DustFreeInterface& w)
-{
-	pcl::Font fnt = w.Font();
-	int labelWidth1 = fnt.Width(String("Star detection sensitivity:") + 'T');
-	int editWidth1 = fnt.Width(String('0', 12));
-	int ui4 = w.LogicalPixelsToPhysical(4);
-
-	StarDetectionSensitivity_NumericControl.label.SetText("Star detection sensitivity:");
-	StarDetectionSensitivity_NumericControl.label.SetFixedWidth(labelWidth1);
-	StarDetectionSensitivity_NumericControl.slider.SetRange(0, 600);
-	StarDetectionSensitivity_NumericControl.slider.SetScaledMinWidth(300);
-	StarDetectionSensitivity_NumericControl.SetReal();
-	StarDetectionSensitivity_NumericControl.SetRange(TheDFStarDetectionSensitivityParameter->MinimumValue(), TheDFStarDetectionSensitivityParameter->MaximumValue());
-	StarDetectionSensitivity_NumericControl.SetPrecision(TheDFStarDetectionSensitivityParameter->Precision());
-	StarDetectionSensitivity_NumericControl.edit.SetFixedWidth(editWidth1);
-	StarDetectionSensitivity_NumericControl.SetToolTip("<p>This value describes the star detection sensitivity. "
-		"Increasing sensitivity allows identifying fainter stars, at the risk of identifying noise as stars.</p>");
-	StarDetectionSensitivity_NumericControl.OnValueUpdated((NumericEdit::value_event_handler) & DustFreeInterface::__EditValueUpdated, w);
-	StarDetectionSensitivity_Sizer.SetSpacing(4);
-	StarDetectionSensitivity_Sizer.Add(StarDetectionSensitivity_NumericControl);
-	StarDetectionSensitivity_Sizer.AddStretch();
-
-	StarDiffusionDistance_NumericControl.label.SetText("Star diffusion distance:");
-	StarDiffusionDistance_NumericControl.label.SetFixedWidth(labelWidth1);
-	StarDiffusionDistance_NumericControl.slider.SetRange(0, 1000);
-	StarDiffusionDistance_NumericControl.slider.SetScaledMinWidth(300);
-	StarDiffusionDistance_NumericControl.SetInteger();
-	StarDiffusionDistance_NumericControl.SetRange(TheDFStarDiffusionDistanceParameter->MinimumValue(), TheDFStarDiffusionDistanceParameter->MaximumValue());
-	StarDiffusionDistance_NumericControl.edit.SetFixedWidth(editWidth1);
-	StarDiffusionDistance_NumericControl.SetToolTip("<p>After star detection is done, the star mask will be diffused in order to protect the edges "
-		                                              "and flares of stars. This value describes the distance of the diffusion.</p>");
-	StarDiffusionDistance_NumericControl.OnValueUpdated((NumericEdit::value_event_handler) & DustFreeInterface::__EditValueUpdated, w);
-	StarDiffusionDistance_Sizer.SetSpacing(4);
-	StarDiffusionDistance_Sizer.Add(StarDiffusionDistance_NumericControl);
-	StarDiffusionDistance_Sizer.AddStretch();
-
-	DustMaskView_Label.SetText("Dust mask image:");
-	DustMaskView_Label.SetFixedWidth(labelWidth1);
-	DustMaskView_Label.SetTextAlignment(TextAlign::Right | TextAlign::VertCenter);
-	DustMaskView_Edit.SetToolTip("<p>123</p>");
-	DustMaskView_Edit.OnGetFocus((Control::event_handler) & DustFreeInterface::__GetFocus, w);
-	DustMaskView_Edit.OnEditCompleted((Edit::edit_event_handler) & DustFreeInterface::__EditCompleted, w);
-	DustMaskView_Edit.OnViewDrag((Control::view_drag_event_handler) & DustFreeInterface::__ViewDrag, w);
-	DustMaskView_Edit.OnViewDrop((Control::view_drop_event_handler) & DustFreeInterface::__ViewDrop, w);
-	DustMaskView_ToolButton.SetIcon(Bitmap(w.ScaledResource(":/icons/select-view.png")));
-	DustMaskView_ToolButton.SetScaledFixedSize(20, 20);
-	DustMaskView_ToolButton.SetToolTip("<p>Binary mask of the dusts that need to be removed.</p>");
-	DustMaskView_ToolButton.OnClick((Button::click_event_handler) & DustFreeInterface::__Click, w);
-	DustMaskView_Sizer.SetSpacing(4);
-	DustMaskView_Sizer.Add(DustMaskView_Label);
-	DustMaskView_Sizer.Add(DustMaskView_Edit);
-	DustMaskView_Sizer.Add(DustMaskView_ToolButton);
-
-	Smoothness_NumericControl.label.SetText("Smoothness:");
-	Smoothness_NumericControl.label.SetFixedWidth(labelWidth1);
-	Smoothness_NumericControl.slider.SetRange(0, 1000);
-	Smoothness_NumericControl.slider.SetScaledMinWidth(300);
-	Smoothness_NumericControl.SetReal();
-	Smoothness_NumericControl.SetRange(TheDFSmoothnessParameter->MinimumValue(), TheDFSmoothnessParameter->MaximumValue());
-	Smoothness_NumericControl.SetPrecision(TheDFSmoothnessParameter->Precision());
-	Smoothness_NumericControl.edit.SetFixedWidth(editWidth1);
-	Smoothness_NumericControl.SetToolTip("<p>Smoothness of inpainting after dust removal.</p>");
-	Smoothness_NumericControl.OnValueUpdated((NumericEdit::value_event_handler) & DustFreeInterface::__EditValueUpdated, w);
-	Smoothness_Sizer.SetSpacing(4);
-	Smoothness_Sizer.Add(Smoothness_NumericControl);
-	Smoothness_Sizer.AddStretch();
-
-	Downsample_Label.SetText("Downsample");
-	Downsample_Label.SetFixedWidth(labelWidth1);
-	Downsample_Label.SetTextAlignment(TextAlign::Right | TextAlign::VertCenter);
-	Downsample_SpinBox.SetRange(TheDFDownsampleParameter->MinimumValue(), int(TheDFDownsampleParameter->MaximumValue()));
-	Downsample_SpinBox.OnValueUpdated((SpinBox::value_event_handler) & DustFreeInterface::__SpinBoxValueUpdated, w);
-	Downsample_Sizer.SetSpacing(4);
-	Downsample_Sizer.Add(Downsample_Label);
-	Downsample_Sizer.Add(Downsample_SpinBox);
-	Downsample_Sizer.AddStretch();
-
-	TestSkyDetection_CheckBox.SetText("Test sky detection");
-	TestSkyDetection_CheckBox.SetToolTip("<p>If selected, only sky detection will be shown as the result. Inpainting will be skipped.</p>");
-	TestSkyDetection_CheckBox.OnClick((Button::click_event_handler) & DustFreeInterface::__Click, w);
-	TestSkyDetection_Sizer.AddUnscaledSpacing(labelWidth1 + ui4);
-	TestSkyDetection_Sizer.Add(TestSkyDetection_CheckBox);
-	TestSkyDetection_Sizer.AddStretch();
-
-	Global_Sizer.SetMargin(8);
-	Global_Sizer.SetSpacing(4);
-	Global_Sizer.Add(StarDetectionSensitivity_Sizer);
-	Global_Sizer.Add(StarDiffusionDistance_Sizer);
-	Global_Sizer.Add(DustMaskView_Sizer);
-	Global_Sizer.Add(Smoothness_Sizer);
-	Global_Sizer.Add(Downsample_Sizer);
-	Global_Sizer.Add(TestSkyDetection_Sizer);
-
-	w.SetSizer(Global_Sizer);
-
-	w.EnsureLayoutUpdated();
-	w.AdjustToContents();
-	w.SetFixedSize();
-}
-
-}	// namespace pcl
+#include "DustFreeInterface.h"
+#include "DustFreeParameters.h"
+#include "DustFreeProcess.h"
+
+#include <pcl/ErrorHandler.h>
+#include <pcl/File.h>
+#include <pcl/FileDialog.h>
+#include <pcl/FileFormat.h>
+#include <pcl/MetaModule.h>
+#include <pcl/RealTimePreview.h>
+#include <pcl/Thread.h>
+#include <pcl/ViewSelectionDialog.h>
+
+namespace pcl
+{
+
+DustFreeInterface* TheDustFreeInterface = nullptr;
+
+// Status of the preview pipeline: stops it, at the end of the current stage,
+// as soon as its thread is aborted.
+class PreviewStatus : public StatusCallback
+{
+public:
+	PreviewStatus(const Thread& thread) : thread(thread)
+	{
+	}
+
+	int Initialized(const StatusMonitor&) const override
+	{
+		return thread.IsAborted();
+	}
+
+	int Updated(const StatusMonitor&) const override
+	{
+		return thread.IsAborted();
+	}
+
+	int Completed(const StatusMonitor&) const override
+	{
+		return 0;
+	}
+
+	void InitializationMessageChanged(const StatusMonitor&) const override
+	{
+	}
+
+private:
+	const Thread& thread;
+};
+
+// Runs the pipeline on a copy of the preview image, so that the interface
+// keeps responding and can restart it when a parameter changes.
+class DustFreeInterface::RealTimeThread : public Thread
+{
+public:
+	UInt16Image image;
+
+	RealTimeThread(const DustFreeInstance& instance, const Image& dustMask, const Point& origin, int scale)
+		: instance(instance), dustMask(dustMask), origin(origin), scale(scale)
+	{
+	}
+
+	void Reset(const UInt16Image& preview, const DustFreeInstance& current, bool coarsePreview)
+	{
+		image.Assign(preview);
+		instance.Assign(current);
+		coarse = coarsePreview;
+	}
+
+	void Run() override
+	{
+		PreviewStatus status(*this);
+		Image work(image);
+		work.SetStatusCallback(&status);
+		try {
+			Image mask(dustMask);
+			ImageVariant target(&work);
+			ImageVariant targetMask(&mask);
+			instance.processPreview(target, targetMask, origin, scale, coarse);
+			work.Truncate();
+			image.Assign(work);
+		} catch (...) {
+			// Aborted or failed: the preview is left as it was.
+		}
+	}
+
+private:
+	DustFreeInstance instance;
+	const Image& dustMask;
+	Point origin;
+	int scale;
+	bool coarse = false;
+};
+
+// Copies a rectangle of an image of any sample type.
+static void CopyRegion(const ImageVariant& source, const Rect& rect, Image& target)
+{
+	if (source.IsFloatSample())
+		switch (source.BitsPerSample()) {
+		case 32: target.Assign(static_cast<const Image&>(*source), rect); return;
+		case 64: target.Assign(static_cast<const DImage&>(*source), rect); return;
+		}
+	else
+		switch (source.BitsPerSample()) {
+		case 8: target.Assign(static_cast<const UInt8Image&>(*source), rect); return;
+		case 16: target.Assign(static_cast<const UInt16Image&>(*source), rect); return;
+		case 32: target.Assign(static_cast<const UInt32Image&>(*source), rect); return;
+		}
+	throw Error("Unsupported mask sample type.");
+}
+
+DustFreeInterface::DustFreeInterface()
+	: instance(TheDustFreeProcess)
+{
+	TheDustFreeInterface = this;
+}
+
+DustFreeInterface::~DustFreeInterface()
+{
+	if (GUI != nullptr)
+		delete GUI, GUI = nullptr;
+}
+
+IsoString DustFreeInterface::Id() const
+{
+	return "DustFree";
+}
+
+MetaProcess* DustFreeInterface::Process() const
+{
+	return TheDustFreeProcess;
+}
+
+IsoString DustFreeInterface::IconImageSVG() const
+{
+	return TheDustFreeProcess->IconImageSVG();
+}
+
+InterfaceFeatures DustFreeInterface::Features() const
+{
+	return InterfaceFeature::Default | InterfaceFeature::ApplyGlobalButton | InterfaceFeature::RealTimeButton;
+}
+
+void DustFreeInterface::ApplyInstance() const
+{
+	instance.LaunchOnCurrentView();
+}
+
+void DustFreeInterface::ApplyInstanceGlobal() const
+{
+	instance.LaunchGlobal();
+}
+
+void DustFreeInterface::ResetInstance()
+{
+	DustFreeInstance defaultInstance(TheDustFreeProcess);
+	ImportProcess(defaultInstance);
+}
+
+bool DustFreeInterface::Launch(const MetaProcess& P, const ProcessImplementation*, bool& dynamic, unsigned& /*flags*/)
+{
+	if (GUI == nullptr)
+	{
+		GUI = new GUIData(*this);
+		SetWindowTitle("DustFree");
+		UpdateControls();
+	}
+
+	dynamic = false;
+	return &P == TheDustFreeProcess;
+}
+
+ProcessImplementation* DustFreeInterface::NewProcess() const
+{
+	return new DustFreeInstance(instance);
+}
+
+bool DustFreeInterface::ValidateProcess(const ProcessImplementation& p, String& whyNot) const
+{
+	if (dynamic_cast<const DustFreeInstance*>(&p) != nullptr)
+		return true;
+	whyNot = "Not a DustFree instance.";
+	return false;
+}
+
+bool DustFreeInterface::RequiresInstanceValidation() const
+{
+	return true;
+}
+
+bool DustFreeInterface::ImportProcess(const ProcessImplementation& p)
+{
+	instance.Assign(p);
+	UpdateControls();
+	UpdateRealTimePreview();
+	return true;
+}
+
+bool DustFreeInterface::RequiresRealTimePreviewUpdate(const UInt16Image&, const View&, const Rect&, int) const
+{
+	return true;
+}
+
+bool DustFreeInterface::GenerateRealTimePreview(UInt16Image& image, const View& view, const Rect& rect, int zoomLevel, String& info) const
+{
+	const bool fromShapes = !instance.enabledDustShapes().empty();
+	View dustMaskView;
+	if (!fromShapes && !instance.dustMaskViewId.IsEmpty())
+		dustMaskView = View::ViewById(instance.dustMaskViewId);
+	if (dustMaskView.IsNull() && !fromShapes) {
+		info = "No dust mask";
+		return false;
+	}
+
+	// The window of the dust mask under the preview, at the resolution of the
+	// mask; the pipeline resamples it to the preview. Shapes are drawn by the
+	// pipeline from the corner of the window, in the coordinates of the main
+	// image, where a preview starts at its corner.
+	const ImageVariant target = view.Image();
+	const Rect area = rect.IsRect() ? rect : Rect(target.Width(), target.Height());
+	const Point origin = view.IsPreview() ? view.Window().PreviewRect(view.Id()).LeftTop() + area.LeftTop() : area.LeftTop();
+	Image dustMask;
+	if (!fromShapes) {
+		ImageVariant mask = dustMaskView.Image();
+		const double sx = double(mask.Width()) / target.Width();
+		const double sy = double(mask.Height()) / target.Height();
+		CopyRegion(mask, Rect(pcl::TruncInt(area.x0 * sx), pcl::TruncInt(area.y0 * sy),
+			pcl::Min(pcl::CeilInt(area.x1 * sx), mask.Width()), pcl::Min(pcl::CeilInt(area.y1 * sy), mask.Height())), dustMask);
+	}
+
+	realTimeThread = new RealTimeThread(instance, dustMask, origin, (zoomLevel < 0) ? -zoomLevel : 1);
+	for (;;) {
+		const bool coarse = coarsePreview;
+		realTimeThread->Reset(image, instance, coarse);
+		realTimeThread->Start();
+
+		while (realTimeThread->IsActive()) {
+			Module->ProcessEvents();
+			if (!IsRealTimePreviewActive()) {
+				realTimeThread->Abort();
+				realTimeThread->Wait();
+				delete realTimeThread;
+				realTimeThread = nullptr;
+				return false;
+			}
+		}
+
+		if (!realTimeThread->IsAborted()) {
+			image.Assign(realTimeThread->image);
+			if (coarse)
+				info = "Coarse preview";
+			delete realTimeThread;
+			realTimeThread = nullptr;
+			return true;
+		}
+	}
+}
+
+void DustFreeInterface::RealTimePreviewUpdated(bool active)
+{
+	if (GUI != nullptr) {
+		if (active)
+			RealTimePreview::SetOwner(*this);
+		else
+			RealTimePreview::SetOwner(ProcessInterface::Null());
+	}
+}
+
+void DustFreeInterface::UpdateRealTimePreview()
+{
+	if (IsRealTimePreviewActive()) {
+		if (realTimeThread != nullptr)
+			realTimeThread->Abort();
+		GUI->UpdateRealTimePreview_Timer.Start();
+	}
+}
+
+#define NO_MASK			String( "<No mask>" )
+#define MASK_ID(x)		(x.IsEmpty() ? NO_MASK : x)
+#define DUST_MASK_ID	MASK_ID(instance.dustMaskViewId)
+
+template <class L>
+static String DustShapesText(const L& shapes)
+{
+	if (shapes.IsEmpty())
+		return "<No shapes>";
+	size_type enabled = 0;
+	for (const auto& s : shapes)
+		if (s.enabled)
+			++enabled;
+	return String().Format("%u shape(s), %u enabled", unsigned(shapes.Length()), unsigned(enabled));
+}
+
+void DustFreeInterface::UpdateControls()
+{
+	GUI->StarDetectionSensitivity_NumericControl.SetValue(instance.starDetectionSensitivity);
+	GUI->StarDetectionMethod_ComboBox.SetCurrentItem(instance.starDetectionMethod);
+	GUI->StarDiffusionDistance_NumericControl.SetValue(instance.starDiffusionDistance);
+	GUI->DustMaskView_Edit.SetText(DUST_MASK_ID);
+	GUI->DustMaskFile_Edit.SetText(instance.dustMaskFile);
+	GUI->DustShapes_Edit.SetText(DustShapesText(instance.dustShapes));
+	GUI->Smoothness_NumericControl.SetValue(instance.smoothness);
+	GUI->SmoothingMethod_ComboBox.SetCurrentItem(instance.smoothingMethod);
+	GUI->InpaintMethod_ComboBox.SetCurrentItem(instance.inpaintMethod);
+	GUI->TiledInpainting_CheckBox.SetChecked(instance.tiledInpainting);
+	GUI->TiledInpainting_CheckBox.Enable(instance.inpaintMethod == DFInpaintMethod::RayMarch);
+	GUI->Downsample_SpinBox.SetValue(instance.downsample);
+	GUI->MemoryBudget_SpinBox.SetValue(int(instance.memoryBudget));
+	GUI->CacheSize_SpinBox.SetValue(int(instance.cacheSize));
+	GUI->Streaming_CheckBox.SetChecked(instance.streaming);
+	GUI->FloatIntermediates_CheckBox.SetChecked(instance.floatIntermediates);
+	GUI->DustRegionsOnly_CheckBox.SetChecked(instance.dustRegionsOnly);
+	GUI->TestSkyDetection_CheckBox.SetChecked(instance.testSkyDetection);
+	GUI->TraceFile_Edit.SetText(instance.traceFile);
+	GUI->OutputDirectory_Edit.SetText(instance.outputDirectory);
+	GUI->OutputPostfix_Edit.SetText(instance.outputPostfix);
+	GUI->FramesInFlight_SpinBox.SetValue(int(instance.framesInFlight));
+	GUI->OverwriteExistingFiles_CheckBox.SetChecked(instance.overwriteExistingFiles);
+	UpdateTargetFrames();
+}
+
+void DustFreeInterface::UpdateTargetFrames()
+{
+	GUI->TargetFrames_TreeBox.DisableUpdates();
+	GUI->TargetFrames_TreeBox.Clear();
+	for (size_type i = 0; i < instance.targetFrames.Length(); i++) {
+		const DustFreeInstance::TargetFrame& frame = instance.targetFrames[i];
+		TreeBox::Node* node = new TreeBox::Node(GUI->TargetFrames_TreeBox);
+		node->SetText(0, String(i + 1));
+		node->SetAlignment(0, TextAlign::Right);
+		node->SetIcon(1, Bitmap(ScaledResource(frame.enabled ? ":/browser/enabled.png" : ":/browser/disabled.png")));
+		node->SetText(1, File::ExtractNameAndExtension(frame.path));
+		node->SetToolTip(1, frame.path);
+	}
+	GUI->TargetFrames_TreeBox.AdjustColumnWidthToContents(0);
+	GUI->TargetFrames_TreeBox.AdjustColumnWidthToContents(1);
+	GUI->TargetFrames_TreeBox.EnableUpdates();
+}
+
+void DustFreeInterface::__GetFocus(Control& sender)
+{
+	Edit* e = dynamic_cast<Edit*>(&sender);
+	if (e != nullptr)
+		if (e->Text() == NO_MASK)
+			e->Clear();
+}
+
+void DustFreeInterface::__EditCompleted(Edit& sender)
+{
+	if (sender == GUI->DustMaskView_Edit)
+	{
+		try
+		{
+			String id = sender.Text().Trimmed();
+			if (id == NO_MASK)
+				id.Clear();
+			if (!id.IsEmpty())
+				if (!View::IsValidViewId(id))
+					throw Error("Invalid view identifier: " + id);
+			instance.dustMaskViewId = id;
+			sender.SetText(DUST_MASK_ID);
+			UpdateRealTimePreview();
+		}
+		catch (...)
+		{
+			sender.SetText(DUST_MASK_ID);
+			try
+			{
+				throw;
+			}
+			ERROR_HANDLER
+				sender.SelectAll();
+			sender.Focus();
+		}
+	} else if (sender == GUI->DustMaskFile_Edit) {
+		instance.dustMaskFile = sender.Text().Trimmed();
+		sender.SetText(instance.dustMaskFile);
+		UpdateRealTimePreview();
+	} else if (sender == GUI->OutputDirectory_Edit) {
+		instance.outputDirectory = sender.Text().Trimmed();
+		sender.SetText(instance.outputDirectory);
+	} else if (sender == GUI->OutputPostfix_Edit) {
+		instance.outputPostfix = sender.Text().Trimmed();
+		sender.SetText(instance.outputPostfix);
+	} else if (sender == GUI->TraceFile_Edit) {
+		instance.traceFile = sender.Text().Trimmed();
+		sender.SetText(instance.traceFile);
+	}
+}
+
+void DustFreeInterface::__EditValueUpdated(NumericEdit& sender, double value)
+{
+	if (sender == GUI->StarDetectionSensitivity_NumericControl)
+		instance.starDetectionSensitivity = value;
+	else if (sender == GUI->StarDiffusionDistance_NumericControl)
+		instance.starDiffusionDistance = value;
+	else if (sender == GUI->Smoothness_NumericControl)
+		instance.smoothness = value;
+
+	// While a slider moves the preview runs at a coarser scale, and it is
+	// refined once the value has not changed for a while.
+	coarsePreview = true;
+	GUI->RefinePreview_Timer.Stop();
+	GUI->RefinePreview_Timer.Start();
+	UpdateRealTimePreview();
+}
+
+void DustFreeInterface::__SpinBoxValueUpdated(SpinBox & sender, int value)
+{
+	if (sender == GUI->Downsample_SpinBox)
+		instance.downsample = value;
+	else if (sender == GUI->MemoryBudget_SpinBox)
+		instance.memoryBudget = uint32(value);
+	else if (sender == GUI->CacheSize_SpinBox)
+		instance.cacheSize = uint32(value);
+	else if (sender == GUI->FramesInFlight_SpinBox) {
+		instance.framesInFlight = uint32(value);
+		return;
+	}
+	UpdateRealTimePreview();
+}
+
+void DustFreeInterface::__Click(Button& sender, bool checked)
+{
+	if (sender == GUI->DustMaskView_ToolButton) {
+		ViewSelectionDialog d(instance.dustMaskViewId);
+		if (d.Execute() == StdDialogCode::Ok)
+		{
+			instance.dustMaskViewId = d.Id();
+			GUI->DustMaskView_Edit.SetText(DUST_MASK_ID);
+		}
+	} else if (sender == GUI->DustMaskFile_ToolButton) {
+		SaveFileDialog d;
+		d.SetCaption("DustFree: Compiled Dust Mask");
+		d.Filters() << FileFilter("Compiled dust masks", ".dfmask");
+		d.DisableOverwritePrompt();
+		if (!instance.dustMaskFile.IsEmpty())
+			d.SetInitialPath(instance.dustMaskFile);
+		if (d.Execute()) {
+			instance.dustMaskFile = d.FileName();
+			GUI->DustMaskFile_Edit.SetText(instance.dustMaskFile);
+		}
+	} else if (sender == GUI->DustShapes_ToolButton) {
+		OpenFileDialog d;
+		d.SetCaption("DustFree: Dust Shapes");
+		d.Filters() << FileFilter("Shape lists", StringList() << ".txt" << ".csv");
+		if (!d.Execute())
+			return;
+		try
+		{
+			ByteArray text = File::ReadFile(d.FileName());
+			std::vector<DFDustShape> shapes;
+			const int line = DFParseShapes(reinterpret_cast<const char*>(text.Begin()), text.Length(), shapes);
+			if (line != 0)
+				throw Error(String().Format("Malformed or out of range dust shape at line %d: ", line) + d.FileName());
+			instance.dustShapes.Clear();
+			for (const DFDustShape& s : shapes) {
+				DustFreeInstance::DustShape shape;
+				shape.x = s.x;
+				shape.y = s.y;
+				shape.radius = s.radius;
+				shape.innerRadius = s.innerRadius;
+				shape.axisRatio = s.axisRatio;
+				shape.angle = s.angle;
+				shape.feather = s.feather;
+				instance.dustShapes << shape;
+			}
+			GUI->DustShapes_Edit.SetText(DustShapesText(instance.dustShapes));
+		}
+		ERROR_HANDLER
+	} else if (sender == GUI->ClearDustShapes_ToolButton) {
+		instance.dustShapes.Clear();
+		GUI->DustShapes_Edit.SetText(DustShapesText(instance.dustShapes));
+	} else if (sender == GUI->TraceFile_ToolButton) {
+		SaveFileDialog d;
+		d.SetCaption("DustFree: Trace File");
+		d.Filters() << FileFilter("JSON files", ".json");
+		if (!instance.traceFile.IsEmpty())
+			d.SetInitialPath(instance.traceFile);
+		if (d.Execute()) {
+			instance.traceFile = d.FileName();
+			GUI->TraceFile_Edit.SetText(instance.traceFile);
+		}
+		return;
+	} else if (sender == GUI->TestSkyDetection_CheckBox) {
+		instance.testSkyDetection = checked;
+	} else if (sender == GUI->TiledInpainting_CheckBox) {
+		instance.tiledInpainting = checked;
+	} else if (sender == GUI->DustRegionsOnly_CheckBox) {
+		instance.dustRegionsOnly = checked;
+	} else if (sender == GUI->Streaming_CheckBox) {
+		instance.streaming = checked;
+	} else if (sender == GUI->FloatIntermediates_CheckBox) {
+		instance.floatIntermediates = checked;
+	}
+	UpdateRealTimePreview();
+}
+
+void DustFreeInterface::__ItemSelected(ComboBox& sender, int itemIndex)
+{
+	if (sender == GUI->InpaintMethod_ComboBox) {
+		instance.inpaintMethod = itemIndex;
+		GUI->TiledInpainting_CheckBox.Enable(instance.inpaintMethod == DFInpaintMethod::RayMarch);
+	} else if (sender == GUI->StarDetectionMethod_ComboBox) {
+		instance.starDetectionMethod = itemIndex;
+	} else if (sender == GUI->SmoothingMethod_ComboBox) {
+		instance.smoothingMethod = itemIndex;
+	}
+	UpdateRealTimePreview();
+}
+
+// The batch controls only edit the list of frames and where they are written,
+// so they leave the real-time preview alone.
+void DustFreeInterface::__BatchClick(Button& sender, bool checked)
+{
+	if (sender == GUI->AddFiles_PushButton) {
+		OpenFileDialog d;
+		d.SetCaption("DustFree: Select Target Frames");
+		d.LoadImageFilters();
+		d.EnableMultipleSelections();
+		if (d.Execute()) {
+			for (const String& path : d.FileNames())
+				instance.targetFrames << DustFreeInstance::TargetFrame(path);
+			UpdateTargetFrames();
+		}
+	} else if ((sender == GUI->ToggleSelected_PushButton) || (sender == GUI->RemoveSelected_PushButton)) {
+		DustFreeInstance::target_list frames;
+		for (int i = 0; i < GUI->TargetFrames_TreeBox.NumberOfChildren(); i++) {
+			DustFreeInstance::TargetFrame frame = instance.targetFrames[i];
+			if (GUI->TargetFrames_TreeBox[i]->IsSelected()) {
+				if (sender == GUI->RemoveSelected_PushButton)
+					continue;
+				frame.enabled = !frame.enabled;
+			}
+			frames << frame;
+		}
+		instance.targetFrames = frames;
+		UpdateTargetFrames();
+	} else if (sender == GUI->Clear_PushButton) {
+		instance.targetFrames.Clear();
+		UpdateTargetFrames();
+	} else if (sender == GUI->OutputDirectory_ToolButton) {
+		GetDirectoryDialog d;
+		d.SetCaption("DustFree: Select Output Directory");
+		if (d.Execute()) {
+			instance.outputDirectory = d.Directory();
+			GUI->OutputDirectory_Edit.SetText(instance.outputDirectory);
+		}
+	} else if (sender == GUI->OverwriteExistingFiles_CheckBox) {
+		instance.overwriteExistingFiles = checked;
+	}
+}
+
+void DustFreeInterface::__NodeActivated(TreeBox& sender, TreeBox::Node& node, int col)
+{
+	const int index = sender.ChildIndex(&node);
+	if ((index >= 0) && (size_type(index) < instance.targetFrames.Length())) {
+		instance.targetFrames[index].enabled = !instance.targetFrames[index].enabled;
+		UpdateTargetFrames();
+	}
+}
+
+void DustFreeInterface::__ViewDrag(Control& sender, const Point& pos, const View& view, unsigned modifiers, bool& wantsView)
+{
+	if (sender == GUI->DustMaskView_Edit)
+		wantsView = true;
+}
+
+// ----------------------------------------------------------------------------
+
+void DustFreeInterface::__ViewDrop(Control& sender, const Point& pos, const View& view, unsigned modifiers)
+{
+	if (sender == GUI->DustMaskView_Edit) {
+		instance.dustMaskViewId = view.FullId();
+		GUI->DustMaskView_Edit.SetText(DUST_MASK_ID);
+		UpdateRealTimePreview();
+	}
+}
+
+void DustFreeInterface::__Timer(Timer& sender)
+{
+	if (sender == GUI->RefinePreview_Timer) {
+		coarsePreview = false;
+		UpdateRealTimePreview();
+	} else if (sender == GUI->UpdateRealTimePreview_Timer) {
+		if (realTimeThread != nullptr)
+			if (realTimeThread->IsActive())
+				return;
+		if (IsRealTimePreviewActive())
+			RealTimePreview::Update();
+	}
+}
+
+DustFreeInterface::GUIData::GUIData(DustFreeInterface& w)
+{
+	pcl::Font fnt = w.Font();
+	int labelWidth1 = fnt.Width(String("Star detection sensitivity:") + 'T');
+	int editWidth1 = fnt.Width(String('0', 12));
+	int ui4 = w.LogicalPixelsToPhysical(4);
+
+	StarDetectionSensitivity_NumericControl.label.SetText("Star detection sensitivity:");
+	StarDetectionSensitivity_NumericControl.label.SetFixedWidth(labelWidth1);
+	StarDetectionSensitivity_NumericControl.slider.SetRange(0, 600);
+	StarDetectionSensitivity_NumericControl.slider.SetScaledMinWidth(300);
+	StarDetectionSensitivity_NumericControl.SetReal();
+	StarDetectionSensitivity_NumericControl.SetRange(TheDFStarDetectionSensitivityParameter->MinimumValue(), TheDFStarDetectionSensitivityParameter->MaximumValue());
+	StarDetectionSensitivity_NumericControl.SetPrecision(TheDFStarDetectionSensitivityParameter->Precision());
+	StarDetectionSensitivity_NumericControl.edit.SetFixedWidth(editWidth1);
+	StarDetectionSensitivity_NumericControl.SetToolTip("<p>This value describes the star detection sensitivity. "
+		"Increasing sensitivity allows identifying fainter stars, at the risk of identifying noise as stars.</p>");
+	StarDetectionSensitivity_NumericControl.OnValueUpdated((NumericEdit::value_event_handler) & DustFreeInterface::__EditValueUpdated, w);
+	StarDetectionSensitivity_Sizer.SetSpacing(4);
+	StarDetectionSensitivity_Sizer.Add(StarDetectionSensitivity_NumericControl);
+	StarDetectionSensitivity_Sizer.AddStretch();
+
+	StarDetectionMethod_Label.SetText("Star detection:");
+	StarDetectionMethod_Label.SetFixedWidth(labelWidth1);
+	StarDetectionMethod_Label.SetTextAlignment(TextAlign::Right | TextAlign::VertCenter);
+	StarDetectionMethod_ComboBox.AddItem("Multiscale linear transform");
+	StarDetectionMethod_ComboBox.AddItem("Band-pass (fast)");
+	StarDetectionMethod_ComboBox.SetToolTip("<p>Algorithm used to detect stars.</p>"
+		"<p><b>Multiscale linear transform</b> is the original detector.</p>"
+		"<p><b>Band-pass</b> computes the same wavelet scales with B3 spline a trous kernels in a few streaming passes, "
+		"and thresholds and median-filters a bit mask instead of a full image. It is much faster and uses far less "
+		"memory, but the detected stars can differ slightly.</p>");
+	StarDetectionMethod_ComboBox.OnItemSelected((ComboBox::item_event_handler) & DustFreeInterface::__ItemSelected, w);
+	StarDetectionMethod_Sizer.SetSpacing(4);
+	StarDetectionMethod_Sizer.Add(StarDetectionMethod_Label);
+	StarDetectionMethod_Sizer.Add(StarDetectionMethod_ComboBox);
+	StarDetectionMethod_Sizer.AddStretch();
+
+	StarDiffusionDistance_NumericControl.label.SetText("Star diffusion distance:");
+	StarDiffusionDistance_NumericControl.label.SetFixedWidth(labelWidth1);
+	StarDiffusionDistance_NumericControl.slider.SetRange(0, 1000);
+	StarDiffusionDistance_NumericControl.slider.SetScaledMinWidth(300);
+	StarDiffusionDistance_NumericControl.SetInteger();
+	StarDiffusionDistance_NumericControl.SetRange(TheDFStarDiffusionDistanceParameter->MinimumValue(), TheDFStarDiffusionDistanceParameter->MaximumValue());
+	StarDiffusionDistance_NumericControl.edit.SetFixedWidth(editWidth1);
+	StarDiffusionDistance_NumericControl.SetToolTip("<p>After star detection is done, the star mask will be diffused in order to protect the edges "
+		                                              "and flares of stars. This value describes the distance of the diffusion.</p>");
+	StarDiffusionDistance_NumericControl.OnValueUpdated((NumericEdit::value_event_handler) & DustFreeInterface::__EditValueUpdated, w);
+	StarDiffusionDistance_Sizer.SetSpacing(4);
+	StarDiffusionDistance_Sizer.Add(StarDiffusionDistance_NumericControl);
+	StarDiffusionDistance_Sizer.AddStretch();
+
+	DustMaskView_Label.SetText("Dust mask image:");
+	DustMaskView_Label.SetFixedWidth(labelWidth1);
+	DustMaskView_Label.SetTextAlignment(TextAlign::Right | TextAlign::VertCenter);
+	DustMaskView_Edit.SetToolTip("<p>123</p>");
+	DustMaskView_Edit.OnGetFocus((Control::event_handler) & DustFreeInterface::__GetFocus, w);
+	DustMaskView_Edit.OnEditCompleted((Edit::edit_event_handler) & DustFreeInterface::__EditCompleted, w);
+	DustMaskView_Edit.OnViewDrag((Control::view_drag_event_handler) & DustFreeInterface::__ViewDrag, w);
+	DustMaskView_Edit.OnViewDrop((Control::view_drop_event_handler) & DustFreeInterface::__ViewDrop, w);
+	DustMaskView_ToolButton.SetIcon(Bitmap(w.ScaledResource(":/icons/select-view.png")));
+	DustMaskView_ToolButton.SetScaledFixedSize(20, 20);
+	DustMaskView_ToolButton.SetToolTip("<p>Binary mask of the dusts that need to be removed.</p>");
+	DustMaskView_ToolButton.OnClick((Button::click_event_handler) & DustFreeInterface::__Click, w);
+	DustMaskView_Sizer.SetSpacing(4);
+	DustMaskView_Sizer.Add(DustMaskView_Label);
+	DustMaskView_Sizer.Add(DustMaskView_Edit);
+	DustMaskView_Sizer.Add(DustMaskView_ToolButton);
+
+	const char* dustMaskFileToolTip = "<p>File holding the dust mask compiled for the size of the images: its binarized "
+		"masks at every downsampling used so far and its connected components. It is created and extended as needed, and "
+		"later runs read it instead of resampling and binarizing the mask image again.</p>"
+		"<p>The file is rebuilt if the dust mask image has changed. With no dust mask image selected, the file alone is "
+		"used.</p>";
+	DustMaskFile_Label.SetText("Compiled mask:");
+	DustMaskFile_Label.SetFixedWidth(labelWidth1);
+	DustMaskFile_Label.SetTextAlignment(TextAlign::Right | TextAlign::VertCenter);
+	DustMaskFile_Edit.SetToolTip(dustMaskFileToolTip);
+	DustMaskFile_Edit.OnEditCompleted((Edit::edit_event_handler) & DustFreeInterface::__EditCompleted, w);
+	DustMaskFile_ToolButton.SetIcon(Bitmap(w.ScaledResource(":/icons/select-file.png")));
+	DustMaskFile_ToolButton.SetScaledFixedSize(20, 20);
+	DustMaskFile_ToolButton.SetToolTip(dustMaskFileToolTip);
+	DustMaskFile_ToolButton.OnClick((Button::click_event_handler) & DustFreeInterface::__Click, w);
+	DustMaskFile_Sizer.SetSpacing(4);
+	DustMaskFile_Sizer.Add(DustMaskFile_Label);
+	DustMaskFile_Sizer.Add(DustMaskFile_Edit);
+	DustMaskFile_Sizer.Add(DustMaskFile_ToolButton);
+
+	const char* dustShapesToolTip = "<p>Dust motes given as circles, ellipses or rings instead of a mask image. They are "
+		"drawn straight into the dust mask at the working resolution, and take the place of the dust mask image and of the "
+		"compiled mask.</p>"
+		"<p>The list is loaded from a text file with a shape per line: x, y and radius in pixels of the image, then "
+		"optionally the inner radius of a ring, the axis ratio and angle in degrees of an ellipse, and the width of a "
+		"feathered edge. Lines starting with # are skipped.</p>";
+	DustShapes_Label.SetText("Dust shapes:");
+	DustShapes_Label.SetFixedWidth(labelWidth1);
+	DustShapes_Label.SetTextAlignment(TextAlign::Right | TextAlign::VertCenter);
+	DustShapes_Edit.SetReadOnly();
+	DustShapes_Edit.SetToolTip(dustShapesToolTip);
+	DustShapes_ToolButton.SetIcon(Bitmap(w.ScaledResource(":/icons/select-file.png")));
+	DustShapes_ToolButton.SetScaledFixedSize(20, 20);
+	DustShapes_ToolButton.SetToolTip(dustShapesToolTip);
+	DustShapes_ToolButton.OnClick((Button::click_event_handler) & DustFreeInterface::__Click, w);
+	ClearDustShapes_ToolButton.SetIcon(Bitmap(w.ScaledResource(":/icons/clear.png")));
+	ClearDustShapes_ToolButton.SetScaledFixedSize(20, 20);
+	ClearDustShapes_ToolButton.SetToolTip("<p>Remove all dust shapes.</p>");
+	ClearDustShapes_ToolButton.OnClick((Button::click_event_handler) & DustFreeInterface::__Click, w);
+	DustShapes_Sizer.SetSpacing(4);
+	DustShapes_Sizer.Add(DustShapes_Label);
+	DustShapes_Sizer.Add(DustShapes_Edit);
+	DustShapes_Sizer.Add(DustShapes_ToolButton);
+	DustShapes_Sizer.Add(ClearDustShapes_ToolButton);
+
+	Smoothness_NumericControl.label.SetText("Smoothness:");
+	Smoothness_NumericControl.label.SetFixedWidth(labelWidth1);
+	Smoothness_NumericControl.slider.SetRange(0, 1000);
+	Smoothness_NumericControl.slider.SetScaledMinWidth(300);
+	Smoothness_NumericControl.SetReal();
+	Smoothness_NumericControl.SetRange(TheDFSmoothnessParameter->MinimumValue(), TheDFSmoothnessParameter->MaximumValue());
+	Smoothness_NumericControl.SetPrecision(TheDFSmoothnessParameter->Precision());
+	Smoothness_NumericControl.edit.SetFixedWidth(editWidth1);
+	Smoothness_NumericControl.SetToolTip("<p>Smoothness of inpainting after dust removal.</p>");
+	Smoothness_NumericControl.OnValueUpdated((NumericEdit::value_event_handler) & DustFreeInterface::__EditValueUpdated, w);
+	Smoothness_Sizer.SetSpacing(4);
+	Smoothness_Sizer.Add(Smoothness_NumericControl);
+	Smoothness_Sizer.AddStretch();
+
+	SmoothingMethod_Label.SetText("Smoothing:");
+	SmoothingMethod_Label.SetFixedWidth(labelWidth1);
+	SmoothingMethod_Label.SetTextAlignment(TextAlign::Right | TextAlign::VertCenter);
+	SmoothingMethod_ComboBox.AddItem("FFT convolution (reference)");
+	SmoothingMethod_ComboBox.AddItem("Recursive Gaussian");
+	SmoothingMethod_ComboBox.SetToolTip("<p>Algorithm used to smooth the correction.</p>"
+		"<p><b>FFT convolution</b> applies the exact variable shape kernel. Its cost and memory grow with the "
+		"smoothness.</p>"
+		"<p><b>Recursive Gaussian</b> applies a Gaussian of the same width with an IIR filter, in place, at a cost that "
+		"does not depend on the smoothness. The result is slightly different.</p>");
+	SmoothingMethod_ComboBox.OnItemSelected((ComboBox::item_event_handler) & DustFreeInterface::__ItemSelected, w);
+	SmoothingMethod_Sizer.SetSpacing(4);
+	SmoothingMethod_Sizer.Add(SmoothingMethod_Label);
+	SmoothingMethod_Sizer.Add(SmoothingMethod_ComboBox);
+	SmoothingMethod_Sizer.AddStretch();
+
+	InpaintMethod_Label.SetText("Inpainting:");
+	InpaintMethod_Label.SetFixedWidth(labelWidth1);
+	InpaintMethod_Label.SetTextAlignment(TextAlign::Right | TextAlign::VertCenter);
+	InpaintMethod_ComboBox.AddItem("Ray march (reference)");
+	InpaintMethod_ComboBox.AddItem("Nearest sample");
+	InpaintMethod_ComboBox.AddItem("Push-pull pyramid");
+	InpaintMethod_ComboBox.SetToolTip("<p>Algorithm used to fill the holes left by stars and dust.</p>"
+		"<p><b>Ray march</b> casts 32 rays from every hole pixel and blends the first valid samples they hit. "
+		"Its cost grows with the size of the holes.</p>"
+		"<p><b>Nearest sample</b> locates the nearest valid samples with an exact distance transform and blends them "
+		"with the same inverse distance weights. Its cost is linear in the number of pixels, whatever the size of the holes.</p>"
+		"<p><b>Push-pull pyramid</b> averages the valid samples into a coarse-to-fine pyramid and fills the holes from the "
+		"coarser levels. It is the fastest method and closes large dust donuts smoothly, which makes it practical to run "
+		"with no downsampling.</p>");
+	InpaintMethod_ComboBox.OnItemSelected((ComboBox::item_event_handler) & DustFreeInterface::__ItemSelected, w);
+	InpaintMethod_Sizer.SetSpacing(4);
+	InpaintMethod_Sizer.Add(InpaintMethod_Label);
+	InpaintMethod_Sizer.Add(InpaintMethod_ComboBox);
+	InpaintMethod_Sizer.AddStretch();
+
+	TiledInpainting_CheckBox.SetText("Tiled ray march");
+	TiledInpainting_CheckBox.SetToolTip("<p>Runs the ray march over 128x128 pixel tiles, each one against a cache-resident copy "
+		"of the tile and its surroundings. Only the rays that travel beyond the copy read the whole image. The result is "
+		"identical; on machines with many cores this considerably reduces memory traffic.</p>");
+	TiledInpainting_CheckBox.OnClick((Button::click_event_handler) & DustFreeInterface::__Click, w);
+	TiledInpainting_Sizer.AddUnscaledSpacing(labelWidth1 + ui4);
+	TiledInpainting_Sizer.Add(TiledInpainting_CheckBox);
+	TiledInpainting_Sizer.AddStretch();
+
+	Downsample_Label.SetText("Downsample");
+	Downsample_Label.SetFixedWidth(labelWidth1);
+	Downsample_Label.SetTextAlignment(TextAlign::Right | TextAlign::VertCenter);
+	Downsample_SpinBox.SetRange(TheDFDownsampleParameter->MinimumValue(), int(TheDFDownsampleParameter->MaximumValue()));
+	Downsample_SpinBox.OnValueUpdated((SpinBox::value_event_handler) & DustFreeInterface::__SpinBoxValueUpdated, w);
+	Downsample_Sizer.SetSpacing(4);
+	Downsample_Sizer.Add(Downsample_Label);
+	Downsample_Sizer.Add(Downsample_SpinBox);
+	Downsample_Sizer.AddStretch();
+
+	MemoryBudget_Label.SetText("Memory budget (MiB)");
+	MemoryBudget_Label.SetFixedWidth(labelWidth1);
+	MemoryBudget_Label.SetTextAlignment(TextAlign::Right | TextAlign::VertCenter);
+	MemoryBudget_SpinBox.SetRange(int(TheDFMemoryBudgetParameter->MinimumValue()), int(TheDFMemoryBudgetParameter->MaximumValue()));
+	MemoryBudget_SpinBox.SetMinimumValueText("Unlimited");
+	MemoryBudget_SpinBox.SetToolTip("<p>Upper bound for the memory held by the process, in MiB. When the predicted peak "
+		"exceeds it, the image is processed in overlapping tiles, and the two inpainting passes run one after the other "
+		"reusing their buffers. Tiling can make a slight difference near the tile borders.</p>"
+		"<p>Zero means no limit.</p>");
+	MemoryBudget_SpinBox.OnValueUpdated((SpinBox::value_event_handler) & DustFreeInterface::__SpinBoxValueUpdated, w);
+	MemoryBudget_Sizer.SetSpacing(4);
+	MemoryBudget_Sizer.Add(MemoryBudget_Label);
+	MemoryBudget_Sizer.Add(MemoryBudget_SpinBox);
+	MemoryBudget_Sizer.AddStretch();
+
+	CacheSize_Label.SetText("Stage cache (MiB)");
+	CacheSize_Label.SetFixedWidth(labelWidth1);
+	CacheSize_Label.SetTextAlignment(TextAlign::Right | TextAlign::VertCenter);
+	CacheSize_SpinBox.SetRange(int(TheDFCacheSizeParameter->MinimumValue()), int(TheDFCacheSizeParameter->MaximumValue()));
+	CacheSize_SpinBox.SetMinimumValueText("Disabled");
+	CacheSize_SpinBox.SetToolTip("<p>Memory kept across runs for the star masks and the inpainted backgrounds, in MiB. "
+		"Running again on the same image and dust mask with only a new smoothness redoes just the smoothing; with only a "
+		"new dust mask or inpainting method, the star detection is reused. The least recently used results are dropped "
+		"first.</p>"
+		"<p>Only single views are cached: batches of target frames never reuse their results. The cache is dropped "
+		"under a memory budget, and its memory counts towards the peak reported for each run.</p>"
+		"<p>Zero, the default, disables the cache and frees its memory.</p>");
+	CacheSize_SpinBox.OnValueUpdated((SpinBox::value_event_handler) & DustFreeInterface::__SpinBoxValueUpdated, w);
+	CacheSize_Sizer.SetSpacing(4);
+	CacheSize_Sizer.Add(CacheSize_Label);
+	CacheSize_Sizer.Add(CacheSize_SpinBox);
+	CacheSize_Sizer.AddStretch();
+
+	Streaming_CheckBox.SetText("Streaming");
+	Streaming_CheckBox.SetToolTip("<p>Processes the image tile by tile, for images too large to be copied in memory. "
+		"Each tile is grown by the reach of the star detection, the inpainting and the smoothing filter, and only its "
+		"core is written back. The dust mask is read in place from its view, or spilled to a scratch file when it has "
+		"to be resampled. Tiles are sized from the memory budget, if any.</p>");
+	Streaming_CheckBox.OnClick((Button::click_event_handler) & DustFreeInterface::__Click, w);
+	Streaming_Sizer.AddUnscaledSpacing(labelWidth1 + ui4);
+	Streaming_Sizer.Add(Streaming_CheckBox);
+	Streaming_Sizer.AddStretch();
+
+	FloatIntermediates_CheckBox.SetText("32-bit intermediates");
+	FloatIntermediates_CheckBox.SetToolTip("<p>Runs the pipeline of a 64-bit image in 32-bit floating point: the working "
+		"image is averaged down straight into single precision, and only the final correction is added to the 64-bit "
+		"samples. The correction is a smooth background, so this halves the memory of the pipeline and speeds up its "
+		"kernels at no visible cost. Other images are not affected.</p>");
+	FloatIntermediates_CheckBox.OnClick((Button::click_event_handler) & DustFreeInterface::__Click, w);
+	FloatIntermediates_Sizer.AddUnscaledSpacing(labelWidth1 + ui4);
+	FloatIntermediates_Sizer.Add(FloatIntermediates_CheckBox);
+	FloatIntermediates_Sizer.AddStretch();
+
+	DustRegionsOnly_CheckBox.SetText("Process dust regions only");
+	DustRegionsOnly_CheckBox.SetToolTip("<p>Processes only windows around the connected components of the dust mask, each one "
+		"grown by the reach of the smoothing filter and of the inpainting, and leaves the rest of the image untouched. Much "
+		"faster on large images with a few dust motes; the result may differ slightly from a whole-image run near the "
+		"borders of the windows.</p>");
+	DustRegionsOnly_CheckBox.OnClick((Button::click_event_handler) & DustFreeInterface::__Click, w);
+	DustRegionsOnly_Sizer.AddUnscaledSpacing(labelWidth1 + ui4);
+	DustRegionsOnly_Sizer.Add(DustRegionsOnly_CheckBox);
+	DustRegionsOnly_Sizer.AddStretch();
+
+	TestSkyDetection_CheckBox.SetText("Test sky detection");
+	TestSkyDetection_CheckBox.SetToolTip("<p>If selected, only sky detection will be shown as the result. Inpainting will be skipped.</p>");
+	TestSkyDetection_CheckBox.OnClick((Button::click_event_handler) & DustFreeInterface::__Click, w);
+	TestSkyDetection_Sizer.AddUnscaledSpacing(labelWidth1 + ui4);
+	TestSkyDetection_Sizer.Add(TestSkyDetection_CheckBox);
+	TestSkyDetection_Sizer.AddStretch();
+
+	const char* traceFileToolTip = "<p>Every run writes a table of its stages to the console: their wall and CPU time, "
+		"the memory of their buffers, the resident memory of the process and the work done by the inpainting.</p>"
+		"<p>If a file is given, the same measurements are also written to it as JSON, one entry per processed frame. "
+		"The file is replaced by every run.</p>";
+	TraceFile_Label.SetText("Trace file:");
+	TraceFile_Label.SetFixedWidth(labelWidth1);
+	TraceFile_Label.SetTextAlignment(TextAlign::Right | TextAlign::VertCenter);
+	TraceFile_Edit.SetToolTip(traceFileToolTip);
+	TraceFile_Edit.OnEditCompleted((Edit::edit_event_handler) & DustFreeInterface::__EditCompleted, w);
+	TraceFile_ToolButton.SetIcon(Bitmap(w.ScaledResource(":/icons/select-file.png")));
+	TraceFile_ToolButton.SetScaledFixedSize(20, 20);
+	TraceFile_ToolButton.SetToolTip(traceFileToolTip);
+	TraceFile_ToolButton.OnClick((Button::click_event_handler) & DustFreeInterface::__Click, w);
+	TraceFile_Sizer.SetSpacing(4);
+	TraceFile_Sizer.Add(TraceFile_Label);
+	TraceFile_Sizer.Add(TraceFile_Edit);
+	TraceFile_Sizer.Add(TraceFile_ToolButton);
+
+	const char* batchToolTip = "<p>Frames processed by a global execution of the process. Each one is read from its "
+		"file, processed with the parameters above and written to the output directory as an XISF file. The next frame "
+		"is read and the previous one written while the current one is processed.</p>";
+	TargetFrames_TreeBox.SetMinHeight(8 * fnt.Height());
+	TargetFrames_TreeBox.SetNumberOfColumns(2);
+	TargetFrames_TreeBox.HideHeader();
+	TargetFrames_TreeBox.EnableMultipleSelections();
+	TargetFrames_TreeBox.DisableRootDecoration();
+	TargetFrames_TreeBox.EnableAlternateRowColor();
+	TargetFrames_TreeBox.SetToolTip(batchToolTip);
+	TargetFrames_TreeBox.OnNodeActivated((TreeBox::node_event_handler) & DustFreeInterface::__NodeActivated, w);
+
+	AddFiles_PushButton.SetText("Add Files");
+	AddFiles_PushButton.SetToolTip("<p>Adds image files to the list of target frames.</p>");
+	AddFiles_PushButton.OnClick((Button::click_event_handler) & DustFreeInterface::__BatchClick, w);
+	ToggleSelected_PushButton.SetText("Toggle Selected");
+	ToggleSelected_PushButton.SetToolTip("<p>Enables or disables the selected target frames.</p>");
+	ToggleSelected_PushButton.OnClick((Button::click_event_handler) & DustFreeInterface::__BatchClick, w);
+	RemoveSelected_PushButton.SetText("Remove Selected");
+	RemoveSelected_PushButton.SetToolTip("<p>Removes the selected target frames from the list.</p>");
+	RemoveSelected_PushButton.OnClick((Button::click_event_handler) & DustFreeInterface::__BatchClick, w);
+	Clear_PushButton.SetText("Clear");
+	Clear_PushButton.SetToolTip("<p>Clears the list of target frames.</p>");
+	Clear_PushButton.OnClick((Button::click_event_handler) & DustFreeInterface::__BatchClick, w);
+	TargetButtons_Sizer.SetSpacing(4);
+	TargetButtons_Sizer.Add(AddFiles_PushButton);
+	TargetButtons_Sizer.Add(ToggleSelected_PushButton);
+	TargetButtons_Sizer.Add(RemoveSelected_PushButton);
+	TargetButtons_Sizer.Add(Clear_PushButton);
+	TargetButtons_Sizer.AddStretch();
+	TargetFrames_Sizer.SetSpacing(4);
+	TargetFrames_Sizer.Add(TargetFrames_TreeBox, 100);
+	TargetFrames_Sizer.Add(TargetButtons_Sizer);
+
+	OutputDirectory_Label.SetText("Output directory:");
+	OutputDirectory_Label.SetFixedWidth(labelWidth1);
+	OutputDirectory_Label.SetTextAlignment(TextAlign::Right | TextAlign::VertCenter);
+	OutputDirectory_Edit.SetToolTip("<p>Directory where the processed frames are written.</p>");
+	OutputDirectory_Edit.OnEditCompleted((Edit::edit_event_handler) & DustFreeInterface::__EditCompleted, w);
+	OutputDirectory_ToolButton.SetIcon(Bitmap(w.ScaledResource(":/icons/select-file.png")));
+	OutputDirectory_ToolButton.SetScaledFixedSize(20, 20);
+	OutputDirectory_ToolButton.SetToolTip("<p>Selects the output directory.</p>");
+	OutputDirectory_ToolButton.OnClick((Button::click_event_handler) & DustFreeInterface::__BatchClick, w);
+	OutputDirectory_Sizer.SetSpacing(4);
+	OutputDirectory_Sizer.Add(OutputDirectory_Label);
+	OutputDirectory_Sizer.Add(OutputDirectory_Edit, 100);
+	OutputDirectory_Sizer.Add(OutputDirectory_ToolButton);
+
+	OutputPostfix_Label.SetText("Postfix:");
+	OutputPostfix_Label.SetFixedWidth(labelWidth1);
+	OutputPostfix_Label.SetTextAlignment(TextAlign::Right | TextAlign::VertCenter);
+	OutputPostfix_Edit.SetFixedWidth(editWidth1);
+	OutputPostfix_Edit.SetToolTip("<p>Appended to the name of each input file to form the name of its output file.</p>");
+	OutputPostfix_Edit.OnEditCompleted((Edit::edit_event_handler) & DustFreeInterface::__EditCompleted, w);
+	OutputPostfix_Sizer.SetSpacing(4);
+	OutputPostfix_Sizer.Add(OutputPostfix_Label);
+	OutputPostfix_Sizer.Add(OutputPostfix_Edit);
+	OutputPostfix_Sizer.AddStretch();
+
+	FramesInFlight_Label.SetText("Frames in flight:");
+	FramesInFlight_Label.SetFixedWidth(labelWidth1);
+	FramesInFlight_Label.SetTextAlignment(TextAlign::Right | TextAlign::VertCenter);
+	FramesInFlight_SpinBox.SetRange(int(TheDFFramesInFlightParameter->MinimumValue()), int(TheDFFramesInFlightParameter->MaximumValue()));
+	FramesInFlight_SpinBox.SetToolTip("<p>Maximum number of frames held in memory at once, from the start of their read to "
+		"the end of their write. Three are enough to read, process and write at the same time; one processes the frames "
+		"strictly one after the other.</p>");
+	FramesInFlight_SpinBox.OnValueUpdated((SpinBox::value_event_handler) & DustFreeInterface::__SpinBoxValueUpdated, w);
+	FramesInFlight_Sizer.SetSpacing(4);
+	FramesInFlight_Sizer.Add(FramesInFlight_Label);
+	FramesInFlight_Sizer.Add(FramesInFlight_SpinBox);
+	FramesInFlight_Sizer.AddStretch();
+
+	OverwriteExistingFiles_CheckBox.SetText("Overwrite existing files");
+	OverwriteExistingFiles_CheckBox.SetToolTip("<p>Replaces existing output files. Otherwise, frames whose output file "
+		"exists are skipped and reported as failed.</p>");
+	OverwriteExistingFiles_CheckBox.OnClick((Button::click_event_handler) & DustFreeInterface::__BatchClick, w);
+	OverwriteExistingFiles_Sizer.AddUnscaledSpacing(labelWidth1 + ui4);
+	OverwriteExistingFiles_Sizer.Add(OverwriteExistingFiles_CheckBox);
+	OverwriteExistingFiles_Sizer.AddStretch();
+
+	Batch_Sizer.SetMargin(6);
+	Batch_Sizer.SetSpacing(4);
+	Batch_Sizer.Add(TargetFrames_Sizer, 100);
+	Batch_Sizer.Add(OutputDirectory_Sizer);
+	Batch_Sizer.Add(OutputPostfix_Sizer);
+	Batch_Sizer.Add(FramesInFlight_Sizer);
+	Batch_Sizer.Add(OverwriteExistingFiles_Sizer);
+
+	Batch_GroupBox.SetTitle("Batch");
+	Batch_GroupBox.SetSizer(Batch_Sizer);
+
+	Global_Sizer.SetMargin(8);
+	Global_Sizer.SetSpacing(4);
+	Global_Sizer.Add(StarDetectionSensitivity_Sizer);
+	Global_Sizer.Add(StarDetectionMethod_Sizer);
+	Global_Sizer.Add(StarDiffusionDistance_Sizer);
+	Global_Sizer.Add(DustMaskView_Sizer);
+	Global_Sizer.Add(DustMaskFile_Sizer);
+	Global_Sizer.Add(DustShapes_Sizer);
+	Global_Sizer.Add(Smoothness_Sizer);
+	Global_Sizer.Add(SmoothingMethod_Sizer);
+	Global_Sizer.Add(InpaintMethod_Sizer);
+	Global_Sizer.Add(TiledInpainting_Sizer);
+	Global_Sizer.Add(Downsample_Sizer);
+	Global_Sizer.Add(MemoryBudget_Sizer);
+	Global_Sizer.Add(CacheSize_Sizer);
+	Global_Sizer.Add(Streaming_Sizer);
+	Global_Sizer.Add(FloatIntermediates_Sizer);
+	Global_Sizer.Add(DustRegionsOnly_Sizer);
+	Global_Sizer.Add(TestSkyDetection_Sizer);
+	Global_Sizer.Add(TraceFile_Sizer);
+	Global_Sizer.Add(Batch_GroupBox);
+
+	w.SetSizer(Global_Sizer);
+
+	UpdateRealTimePreview_Timer.SetSingleShot();
+	UpdateRealTimePreview_Timer.SetInterval(0.025);
+	UpdateRealTimePreview_Timer.OnTimeout((Timer::timer_event_handler) & DustFreeInterface::__Timer, w);
+
+	RefinePreview_Timer.SetSingleShot();
+	RefinePreview_Timer.SetInterval(0.5);
+	RefinePreview_Timer.OnTimeout((Timer::timer_event_handler) & DustFreeInterface::__Timer, w);
+
+	w.EnsureLayoutUpdated();
+	w.AdjustToContents();
+	w.SetFixedSize();
+}
+
+}	// namespace pcl
@@ -1,80 +1,159 @@
-#ifndef __DustFreeInterface_h
-#define __DustFreeInterface_h
-
-#include <pcl/CheckBox.h>
-#include <pcl/Edit.h>
-#include <pcl/Label.h>
-#include <pcl/NumericControl.h>
-#include <pcl/ProcessInterface.h>
-#include <pcl/Sizer.h>
-#include <pcl/SpinBox.h>
-#include <pcl/ToolButton.h>
-
-#include "DustFreeInstance.h"
-
-namespace pcl {
-
-class DustFreeInterface : public ProcessInterface
-{
-public:
-    DustFreeInterface();
-    virtual ~DustFreeInterface();
-
-    IsoString Id() const override;
-    MetaProcess* Process() const override;
-    IsoString IconImageSVG() const override;
-    InterfaceFeatures Features() const override;
-    void ApplyInstance() const override;
-    void ResetInstance() override;
-    bool Launch(const MetaProcess&, const ProcessImplementation*, bool& dynamic, unsigned& /*flags*/) override;
-    ProcessImplementation* NewProcess() const override;
-    bool ValidateProcess(const ProcessImplementation&, pcl::String& whyNot) const override;
-    bool RequiresInstanceValidation() const override;
-    bool ImportProcess(const ProcessImplementation&) override;
-
-private:
-    DustFreeInstance instance;
-
-    struct GUIData
-    {
-        GUIData(DustFreeInterface&);
-
-        VerticalSizer   Global_Sizer;
-            HorizontalSizer StarDetectionSensitivity_Sizer;
-                NumericControl  StarDetectionSensitivity_NumericControl;
-            HorizontalSizer StarDiffusionDistance_Sizer;
-                NumericControl  StarDiffusionDistance_NumericControl;
-            HorizontalSizer DustMaskView_Sizer;
-                Label           DustMaskView_Label;
-                Edit            DustMaskView_Edit;
-                ToolButton      DustMaskView_ToolButton;
-            HorizontalSizer Smoothness_Sizer;
-                NumericControl  Smoothness_NumericControl;
-            HorizontalSizer   Downsample_Sizer;
-                Label           Downsample_Label;
-                SpinBox         Downsample_SpinBox;
-            HorizontalSizer TestSkyDetection_Sizer;
-                CheckBox        TestSkyDetection_CheckBox;
-    };
-
-    GUIData* GUI = nullptr;
-
-    void UpdateControls();
-    void __GetFocus(Control& sender);
-    void __EditCompleted(Edit& sender);
-    void __EditValueUpdated(NumericEdit& sender, double value);
-    void __SpinBoxValueUpdated(SpinBox& sender, int value);
-    void __Click(Button& sender, bool checked);
-    void __ViewDrag(Control& sender, const Point& pos, const View& view, unsigned modifiers, bool& wantsView);
-    void __ViewDrop(Control& sender, const Point& pos, const View& view, unsigned modifiers);
-
-    friend struct GUIData;
-};
-
-PCL_BEGIN_LOCAL
-extern DustFreeInterface* TheDustFreeInterface;
-PCL_END_LOCAL
-
-}	// namespace pcl
-
-#endif  // __DustFreeInterface_h
+#ifndef __DustFreeInterface_h
+#define __DustFreeInterface_h
+
+#include <pcl/CheckBox.h>
+#include <pcl/ComboBox.h>
+#include <pcl/Edit.h>
+#include <pcl/GroupBox.h>
+#include <pcl/Label.h>
+#include <pcl/NumericControl.h>
+#include <pcl/ProcessInterface.h>
+#include <pcl/PushButton.h>
+#include <pcl/Sizer.h>
+#include <pcl/SpinBox.h>
+#include <pcl/Timer.h>
+#include <pcl/ToolButton.h>
+#include <pcl/TreeBox.h>
+
+#include "DustFreeInstance.h"
+
+namespace pcl {
+
+class DustFreeInterface : public ProcessInterface
+{
+public:
+    DustFreeInterface();
+    virtual ~DustFreeInterface();
+
+    IsoString Id() const override;
+    MetaProcess* Process() const override;
+    IsoString IconImageSVG() const override;
+    InterfaceFeatures Features() const override;
+    void ApplyInstance() const override;
+    void ApplyInstanceGlobal() const override;
+    void ResetInstance() override;
+    bool Launch(const MetaProcess&, const ProcessImplementation*, bool& dynamic, unsigned& /*flags*/) override;
+    ProcessImplementation* NewProcess() const override;
+    bool ValidateProcess(const ProcessImplementation&, pcl::String& whyNot) const override;
+    bool RequiresInstanceValidation() const override;
+    bool ImportProcess(const ProcessImplementation&) override;
+    bool RequiresRealTimePreviewUpdate(const UInt16Image&, const View&, const Rect&, int zoomLevel) const override;
+    bool GenerateRealTimePreview(UInt16Image&, const View&, const Rect&, int zoomLevel, String& info) const override;
+    void RealTimePreviewUpdated(bool active) override;
+
+private:
+    DustFreeInstance instance;
+
+    class RealTimeThread;
+    mutable RealTimeThread* realTimeThread = nullptr;
+    bool coarsePreview = false;
+
+    struct GUIData
+    {
+        GUIData(DustFreeInterface&);
+
+        VerticalSizer   Global_Sizer;
+            HorizontalSizer StarDetectionSensitivity_Sizer;
+                NumericControl  StarDetectionSensitivity_NumericControl;
+            HorizontalSizer StarDetectionMethod_Sizer;
+                Label           StarDetectionMethod_Label;
+                ComboBox        StarDetectionMethod_ComboBox;
+            HorizontalSizer StarDiffusionDistance_Sizer;
+                NumericControl  StarDiffusionDistance_NumericControl;
+            HorizontalSizer DustMaskView_Sizer;
+                Label           DustMaskView_Label;
+                Edit            DustMaskView_Edit;
+                ToolButton      DustMaskView_ToolButton;
+            HorizontalSizer DustMaskFile_Sizer;
+                Label           DustMaskFile_Label;
+                Edit            DustMaskFile_Edit;
+                ToolButton      DustMaskFile_ToolButton;
+            HorizontalSizer DustShapes_Sizer;
+                Label           DustShapes_Label;
+                Edit            DustShapes_Edit;
+                ToolButton      DustShapes_ToolButton;
+                ToolButton      ClearDustShapes_ToolButton;
+            HorizontalSizer Smoothness_Sizer;
+                NumericControl  Smoothness_NumericControl;
+            HorizontalSizer SmoothingMethod_Sizer;
+                Label           SmoothingMethod_Label;
+                ComboBox        SmoothingMethod_ComboBox;
+            HorizontalSizer InpaintMethod_Sizer;
+                Label           InpaintMethod_Label;
+                ComboBox        InpaintMethod_ComboBox;
+            HorizontalSizer TiledInpainting_Sizer;
+                CheckBox        TiledInpainting_CheckBox;
+            HorizontalSizer   Downsample_Sizer;
+                Label           Downsample_Label;
+                SpinBox         Downsample_SpinBox;
+            HorizontalSizer MemoryBudget_Sizer;
+                Label           MemoryBudget_Label;
+                SpinBox         MemoryBudget_SpinBox;
+            HorizontalSizer CacheSize_Sizer;
+                Label           CacheSize_Label;
+                SpinBox         CacheSize_SpinBox;
+            HorizontalSizer Streaming_Sizer;
+                CheckBox        Streaming_CheckBox;
+            HorizontalSizer FloatIntermediates_Sizer;
+                CheckBox        FloatIntermediates_CheckBox;
+            HorizontalSizer DustRegionsOnly_Sizer;
+                CheckBox        DustRegionsOnly_CheckBox;
+            HorizontalSizer TestSkyDetection_Sizer;
+                CheckBox        TestSkyDetection_CheckBox;
+            HorizontalSizer TraceFile_Sizer;
+                Label           TraceFile_Label;
+                Edit            TraceFile_Edit;
+                ToolButton      TraceFile_ToolButton;
+            GroupBox        Batch_GroupBox;
+            VerticalSizer   Batch_Sizer;
+                HorizontalSizer TargetFrames_Sizer;
+                    TreeBox         TargetFrames_TreeBox;
+                    VerticalSizer   TargetButtons_Sizer;
+                        PushButton      AddFiles_PushButton;
+                        PushButton      ToggleSelected_PushButton;
+                        PushButton      RemoveSelected_PushButton;
+                        PushButton      Clear_PushButton;
+                HorizontalSizer OutputDirectory_Sizer;
+                    Label           OutputDirectory_Label;
+                    Edit            OutputDirectory_Edit;
+                    ToolButton      OutputDirectory_ToolButton;
+                HorizontalSizer OutputPostfix_Sizer;
+                    Label           OutputPostfix_Label;
+                    Edit            OutputPostfix_Edit;
+                HorizontalSizer FramesInFlight_Sizer;
+                    Label           FramesInFlight_Label;
+                    SpinBox         FramesInFlight_SpinBox;
+                HorizontalSizer OverwriteExistingFiles_Sizer;
+                    CheckBox        OverwriteExistingFiles_CheckBox;
+
+        Timer UpdateRealTimePreview_Timer;
+        Timer RefinePreview_Timer;
+    };
+
+    GUIData* GUI = nullptr;
+
+    void UpdateControls();
+    void UpdateTargetFrames();
+    void UpdateRealTimePreview();
+    void __GetFocus(Control& sender);
+    void __EditCompleted(Edit& sender);
+    void __EditValueUpdated(NumericEdit& sender, double value);
+    void __SpinBoxValueUpdated(SpinBox& sender, int value);
+    void __Click(Button& sender, bool checked);
+    void __ItemSelected(ComboBox& sender, int itemIndex);
+    void __BatchClick(Button& sender, bool checked);
+    void __NodeActivated(TreeBox& sender, TreeBox::Node& node, int col);
+    void __ViewDrag(Control& sender, const Point& pos, const View& view, unsigned modifiers, bool& wantsView);
+    void __ViewDrop(Control& sender, const Point& pos, const View& view, unsigned modifiers);
+    void __Timer(Timer& sender);
+
+    friend struct GUIData;
+};
+
+PCL_BEGIN_LOCAL
+extern DustFreeInterface* TheDustFreeInterface;
+PCL_END_LOCAL
+
+}	// namespace pcl
+
+#endif  // __DustFreeInterface_h
@@ -0,0 +1,71 @@
+#ifndef __DustFreeMemory_h
+#define __DustFreeMemory_h
+
+#include <algorithm>
+#include <cstddef>
+
+namespace pcl
+{
+
+// Bookkeeping of the memory held by the buffers of the pipeline. Every stage
+// records the buffers it allocates and the ones it frees once they are dead,
+// so that the peak can be checked against the predicted one. Memory allocated
+// internally by library routines is not seen here.
+class DFMemoryLedger
+{
+public:
+    void Reset()
+    {
+        m_current = m_peak = m_stagePeak = m_acquired = 0;
+    }
+
+    void Acquire(size_t bytes)
+    {
+        m_current += bytes;
+        m_acquired += bytes;
+        m_peak = std::max(m_peak, m_current);
+        m_stagePeak = std::max(m_stagePeak, m_current);
+    }
+
+    void Release(size_t bytes)
+    {
+        m_current -= std::min(bytes, m_current);
+    }
+
+    size_t Current() const
+    {
+        return m_current;
+    }
+
+    size_t Peak() const
+    {
+        return m_peak;
+    }
+
+    // Total of all acquisitions since Reset.
+    size_t Acquired() const
+    {
+        return m_acquired;
+    }
+
+    // Peak since the last call to StartStage.
+    void StartStage()
+    {
+        m_stagePeak = m_current;
+    }
+
+    size_t StagePeak() const
+    {
+        return m_stagePeak;
+    }
+
+private:
+    size_t m_current = 0;
+    size_t m_peak = 0;
+    size_t m_stagePeak = 0;
+    size_t m_acquired = 0;
+};
+
+}	// namespace pcl
+
+#endif	// __DustFreeMemory_h
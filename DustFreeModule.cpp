@@ -11,6 +11,9 @@
 #include "DustFreeModule.h"
 #include "DustFreeProcess.h"
 #include "DustFreeInterface.h"
+#include "DustFreeParallel.h"
+
+#include <pcl/Thread.h>
 
 namespace pcl
 {
@@ -81,6 +84,44 @@ void DustFreeModule::GetReleaseDate(int& year, int& month, int& day) const
     day = MODULE_RELEASE_DAY;
 }
 
+// Workers of the kernel thread pool, run as PCL threads.
+class DustFreeWorkerThread : public Thread, public DFWorkerThread
+{
+public:
+    explicit DustFreeWorkerThread(std::function<void()> body)
+        : body(std::move(body))
+    {
+    }
+
+    void Run() override
+    {
+        body();
+    }
+
+    void Join() override
+    {
+        Wait();
+    }
+
+private:
+    std::function<void()> body;
+};
+
+void DustFreeModule::OnLoad()
+{
+    DFSetParallelThreadFactory([](std::function<void()> body) -> std::unique_ptr<DFWorkerThread> {
+        std::unique_ptr<DustFreeWorkerThread> thread(new DustFreeWorkerThread(std::move(body)));
+        thread->Start();
+        return std::unique_ptr<DFWorkerThread>(thread.release());
+    });
+    DFSetParallelThreadCount(Thread::NumberOfThreads(PCL_MAX_PROCESSORS, 1));
+}
+
+void DustFreeModule::OnUnload()
+{
+    DFParallelShutdown();
+}
+
 }   // namespace pcl
 
 PCL_MODULE_EXPORT int InstallPixInsightModule(int mode)
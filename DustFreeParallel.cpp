@@ -0,0 +1,439 @@
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <thread>
+
+#include "DustFreeParallel.h"
+#include "DustFreeProfile.h"
+
+namespace pcl
+{
+
+struct DFTask
+{
+    std::function<void()> body;
+    DFTaskGroup* group = nullptr;
+    DFCpuAccount* account = nullptr;
+};
+
+class DFTaskQueue
+{
+public:
+    void Push(DFTask&& task)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+
+    // Owner end: the most recently pushed task, whose data is still hot.
+    bool Pop(DFTask& task)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_tasks.empty())
+            return false;
+        task = std::move(m_tasks.back());
+        m_tasks.pop_back();
+        return true;
+    }
+
+    // Thief end: the oldest task, usually the largest remaining piece of work.
+    bool Steal(DFTask& task)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_tasks.empty())
+            return false;
+        task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::deque<DFTask> m_tasks;
+};
+
+class DFStdWorkerThread : public DFWorkerThread
+{
+public:
+    explicit DFStdWorkerThread(std::function<void()> body)
+        : m_thread(std::move(body))
+    {
+    }
+
+    void Join() override
+    {
+        m_thread.join();
+    }
+
+private:
+    std::thread m_thread;
+};
+
+class DFThreadPool
+{
+public:
+    static DFThreadPool& Instance()
+    {
+        static DFThreadPool pool;
+        return pool;
+    }
+
+    ~DFThreadPool()
+    {
+        Shutdown();
+    }
+
+    int NumberOfThreads() const
+    {
+        return m_threadCount.load();
+    }
+
+    void SetNumberOfThreads(int count)
+    {
+        count = std::max(1, count);
+        if (count != m_threadCount.load())
+            Reconfigure([this, count]() { m_threadCount = count; });
+    }
+
+    void SetThreadFactory(DFThreadFactory factory)
+    {
+        Reconfigure([this, &factory]() { m_factory = std::move(factory); });
+    }
+
+    std::unique_ptr<DFWorkerThread> StartThread(std::function<void()> body)
+    {
+        std::unique_lock<std::mutex> lock(m_controlMutex);
+        m_idle.wait(lock, [this]() { return !m_reconfiguring; });
+        if (m_factory)
+            return m_factory(std::move(body));
+        return std::make_unique<DFStdWorkerThread>(std::move(body));
+    }
+
+    void Shutdown()
+    {
+        Reconfigure([]() {});
+    }
+
+    // Task groups are registered while they have tasks in flight, so that the
+    // workers are only stopped between them. Groups created from inside a task
+    // belong to one already registered and never wait.
+    void Enter()
+    {
+        if (t_depth > 0) {
+            m_users++;
+            return;
+        }
+        std::unique_lock<std::mutex> lock(m_controlMutex);
+        m_idle.wait(lock, [this]() { return !m_reconfiguring; });
+        m_users++;
+    }
+
+    void Leave()
+    {
+        std::lock_guard<std::mutex> lock(m_controlMutex);
+        if (--m_users == 0)
+            m_idle.notify_all();
+    }
+
+    void Submit(DFTask&& task)
+    {
+        EnsureStarted();
+        size_t q = (t_pool == this) ? t_worker : m_nextQueue++ % m_queues.size();
+        m_queues[q]->Push(std::move(task));
+        m_queued++;
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+        }
+        m_wake.notify_one();
+    }
+
+    // Runs one pending task, if there is any. A worker looks at its own deque
+    // first; then every thread steals round the deques of the others.
+    bool RunOne()
+    {
+        if (m_queued.load() <= 0)
+            return false;
+        DFTask task;
+        const size_t n = m_queues.size();
+        const bool worker = t_pool == this;
+        bool found = worker && m_queues[t_worker]->Pop(task);
+        const size_t first = worker ? t_worker + 1 : m_nextVictim++;
+        for (size_t i = 0; !found && (i < n); i++)
+            found = m_queues[(first + i) % n]->Steal(task);
+        if (!found)
+            return false;
+        m_queued--;
+        Execute(task);
+        return true;
+    }
+
+    // The account that tasks submitted by the calling thread are charged to.
+    static DFCpuAccount* Account()
+    {
+        return t_account;
+    }
+
+    static DFCpuAccount* SetAccount(DFCpuAccount* account)
+    {
+        std::swap(account, t_account);
+        return account;
+    }
+
+private:
+    std::mutex m_controlMutex;
+    std::atomic<int> m_threadCount{ std::max(1, int(std::thread::hardware_concurrency())) };
+    std::atomic<bool> m_running{ false };
+    std::atomic<int> m_users{ 0 };
+    bool m_reconfiguring = false;
+    std::condition_variable m_idle;
+    DFThreadFactory m_factory;
+    std::vector<std::unique_ptr<DFTaskQueue>> m_queues;
+    std::vector<std::unique_ptr<DFWorkerThread>> m_workers;
+    std::atomic<size_t> m_nextQueue{ 0 };
+    std::atomic<size_t> m_nextVictim{ 0 };
+    std::atomic<int> m_queued{ 0 };
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    bool m_stop = false;
+
+    static thread_local DFThreadPool* t_pool;
+    static thread_local size_t t_worker;
+    static thread_local int t_depth;
+    static thread_local DFCpuAccount* t_account;
+
+    DFThreadPool() = default;
+
+    // Stops the workers once no task group is in flight, then applies change;
+    // the pool restarts on the next submission.
+    template <class F>
+    void Reconfigure(F change)
+    {
+        std::unique_lock<std::mutex> lock(m_controlMutex);
+        m_reconfiguring = true;
+        m_idle.wait(lock, [this]() { return m_users.load() == 0; });
+        Stop();
+        change();
+        m_reconfiguring = false;
+        m_idle.notify_all();
+    }
+
+    // The calling thread counts as one of the pool threads, so there are
+    // m_threadCount - 1 workers. Each worker has a deque, and one more has no
+    // owner. Tasks submitted from outside the pool are dealt round-robin over
+    // all of them, so that every worker finds its share in its own deque; the
+    // share of the extra deque is taken by stealing.
+    void EnsureStarted()
+    {
+        if (m_running.load())
+            return;
+        std::lock_guard<std::mutex> lock(m_controlMutex);
+        if (m_running.load())
+            return;
+        m_stop = false;
+        const int workers = m_threadCount.load() - 1;
+        m_queues.clear();
+        for (int i = 0; i <= workers; i++)
+            m_queues.push_back(std::make_unique<DFTaskQueue>());
+        for (int i = 0; i < workers; i++) {
+            std::function<void()> body = [this, i]() { WorkerLoop(size_t(i)); };
+            if (m_factory)
+                m_workers.push_back(m_factory(std::move(body)));
+            else
+                m_workers.push_back(std::make_unique<DFStdWorkerThread>(std::move(body)));
+        }
+        m_running = true;
+    }
+
+    void Stop()
+    {
+        if (!m_running.load())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (std::unique_ptr<DFWorkerThread>& t : m_workers)
+            t->Join();
+        m_workers.clear();
+        m_running = false;
+    }
+
+    void WorkerLoop(size_t index)
+    {
+        t_pool = this;
+        t_worker = index;
+        for (;;) {
+            if (RunOne())
+                continue;
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_wake.wait(lock, [this]() { return m_stop || (m_queued.load() > 0); });
+            if (m_stop)
+                break;
+        }
+        t_pool = nullptr;
+    }
+
+    // When the task belongs to another account than the one the thread is
+    // charging, its CPU time moves from that one to the task's.
+    static void Execute(DFTask& task)
+    {
+        std::exception_ptr error;
+        DFCpuAccount* const charged = t_account;
+        const bool moved = task.account != charged;
+        const double start = moved ? DFThreadCPUTime() : 0;
+        t_account = task.account;
+        t_depth++;
+        try {
+            task.body();
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        t_depth--;
+        t_account = charged;
+        if (moved) {
+            const int64_t used = int64_t(1.0e9 * (DFThreadCPUTime() - start));
+            if (task.account != nullptr)
+                task.account->m_nanoseconds += used;
+            if (charged != nullptr)
+                charged->m_nanoseconds -= used;
+        }
+        task.group->Finish(error);
+    }
+};
+
+thread_local DFThreadPool* DFThreadPool::t_pool = nullptr;
+thread_local size_t DFThreadPool::t_worker = 0;
+thread_local int DFThreadPool::t_depth = 0;
+thread_local DFCpuAccount* DFThreadPool::t_account = nullptr;
+
+DFTaskGroup::~DFTaskGroup()
+{
+    try {
+        Wait();
+    }
+    catch (...) {
+    }
+}
+
+void DFTaskGroup::Run(std::function<void()> task)
+{
+    if (!m_entered.exchange(true))
+        DFThreadPool::Instance().Enter();
+    m_pending++;
+    DFTask t;
+    t.body = std::move(task);
+    t.group = this;
+    t.account = DFThreadPool::Account();
+    DFThreadPool::Instance().Submit(std::move(t));
+}
+
+void DFTaskGroup::Wait()
+{
+    DFThreadPool& pool = DFThreadPool::Instance();
+    while (m_pending.load() > 0) {
+        if (pool.RunOne())
+            continue;
+        // Nothing left to steal: the remaining tasks run on other threads. Nap
+        // briefly, then look again for tasks they may have spawned.
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait_for(lock, std::chrono::milliseconds(1), [this]() { return m_pending.load() == 0; });
+    }
+
+    // Finish() decrements under the mutex, so once it has been taken here the
+    // last task is done touching this group.
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(error, m_error);
+    }
+    if (m_entered.exchange(false))
+        pool.Leave();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void DFTaskGroup::Finish(std::exception_ptr error)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (error && !m_error)
+        m_error = error;
+    if (--m_pending == 0)
+        m_done.notify_all();
+}
+
+void DFParallelFor(int count, const std::function<void(int, int)>& body, int grain)
+{
+    if (count <= 0)
+        return;
+
+    const int chunks = std::min(count / std::max(1, grain), 4 * DFParallelThreadCount());
+    if (chunks <= 1) {
+        body(0, count);
+        return;
+    }
+
+    DFTaskGroup group;
+    for (int i = 0; i < chunks; i++) {
+        const int begin = int(int64_t(count) * i / chunks);
+        const int end = int(int64_t(count) * (i + 1) / chunks);
+        group.Run([&body, begin, end]() { body(begin, end); });
+    }
+    group.Wait();
+}
+
+int DFParallelThreadCount()
+{
+    return DFThreadPool::Instance().NumberOfThreads();
+}
+
+void DFSetParallelThreadCount(int count)
+{
+    DFThreadPool::Instance().SetNumberOfThreads(count);
+}
+
+void DFSetParallelThreadFactory(DFThreadFactory factory)
+{
+    DFThreadPool::Instance().SetThreadFactory(std::move(factory));
+}
+
+DFCpuAccount* DFSetCpuAccount(DFCpuAccount* account)
+{
+    return DFThreadPool::SetAccount(account);
+}
+
+std::unique_ptr<DFWorkerThread> DFStartThread(std::function<void()> body)
+{
+    return DFThreadPool::Instance().StartThread(std::move(body));
+}
+
+void DFParallelShutdown()
+{
+    DFThreadPool::Instance().Shutdown();
+}
+
+std::vector<int> DFBalancedRanges(const std::vector<uint64_t>& cost, int parts)
+{
+    uint64_t total = 0;
+    for (uint64_t c : cost)
+        total += c;
+
+    std::vector<int> bounds(1, 0);
+    const int count = int(cost.size());
+    uint64_t sum = 0;
+    for (int i = 0, k = 1; i < count; i++) {
+        sum += cost[i];
+        if ((k < parts) && (i + 1 < count) && (sum * parts >= total * k)) {
+            bounds.push_back(i + 1);
+            while ((k < parts) && (sum * parts >= total * k))
+                k++;
+        }
+    }
+    if (count > 0)
+        bounds.push_back(count);
+    return bounds;
+}
+
+}	// namespace pcl
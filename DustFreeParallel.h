@@ -0,0 +1,119 @@
+#ifndef __DustFreeParallel_h
+#define __DustFreeParallel_h
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace pcl
+{
+
+// Work-stealing thread pool shared by the whole module. Workers are started on
+// first use and persist across executions; each one owns a task deque, runs its
+// own tasks newest first and steals the oldest tasks of the others when it runs
+// dry. Threads waiting on a DFTaskGroup run pending tasks meanwhile, so groups
+// can be nested freely.
+
+// A set of tasks that is waited for as a whole. Tasks may be submitted from any
+// thread, including from inside other tasks.
+class DFTaskGroup
+{
+public:
+    DFTaskGroup() = default;
+    DFTaskGroup(const DFTaskGroup&) = delete;
+    DFTaskGroup& operator=(const DFTaskGroup&) = delete;
+
+    // Waits for pending tasks; their exceptions are discarded.
+    ~DFTaskGroup();
+
+    void Run(std::function<void()> task);
+
+    // Returns once every task submitted so far has finished. The first
+    // exception thrown by a task is rethrown here.
+    void Wait();
+
+private:
+    std::atomic<int> m_pending{ 0 };
+    std::atomic<bool> m_entered{ false };
+    std::mutex m_mutex;
+    std::condition_variable m_done;
+    std::exception_ptr m_error;
+
+    void Finish(std::exception_ptr error);
+
+    friend class DFThreadPool;
+};
+
+// CPU time charged to a run. The tasks submitted by a thread that has set an
+// account, directly or from inside those tasks, are charged to it wherever
+// they run; the tasks of other accounts that the thread runs itself while it
+// waits are taken back from it. The CPU time of the thread plus the account
+// is then the CPU time of the run alone, even while other runs, such as a
+// real-time preview, share the workers.
+class DFCpuAccount
+{
+public:
+    double Seconds() const
+    {
+        return 1.0e-9 * double(m_nanoseconds.load());
+    }
+
+private:
+    std::atomic<int64_t> m_nanoseconds{ 0 };
+
+    friend class DFThreadPool;
+};
+
+// Sets the account of the calling thread, or none; returns the previous one.
+DFCpuAccount* DFSetCpuAccount(DFCpuAccount* account);
+
+// Runs body(begin, end) over a partition of [0, count) on the module thread
+// pool. Each subrange holds at least grain items; there are a few subranges per
+// thread so that idle threads can steal the leftovers of slow ones. Exceptions
+// thrown by body are rethrown on the calling thread.
+void DFParallelFor(int count, const std::function<void(int, int)>& body, int grain = 1);
+
+// Number of threads, the calling one included, that run pool tasks.
+int DFParallelThreadCount();
+
+// Resizes the pool; does nothing if it already has that many threads. The task
+// groups in flight, on any thread, are waited for first, and new ones wait for
+// the resize. Must not be called from a pool task.
+void DFSetParallelThreadCount(int count);
+
+// A pool worker, started by the factory that created it.
+class DFWorkerThread
+{
+public:
+    virtual ~DFWorkerThread() = default;
+
+    // Returns once the thread has run its body.
+    virtual void Join() = 0;
+};
+
+// Creates and starts a thread that runs body. Workers are std::thread objects
+// unless a factory is installed; the module installs one that runs them as
+// PCL threads. Like a resize, it waits for the task groups in flight.
+typedef std::function<std::unique_ptr<DFWorkerThread>(std::function<void()>)> DFThreadFactory;
+void DFSetParallelThreadFactory(DFThreadFactory factory);
+
+// Creates and starts a thread outside the pool that runs body, with the
+// installed factory, so that it is a PCL thread within the module.
+std::unique_ptr<DFWorkerThread> DFStartThread(std::function<void()> body);
+
+// Stops and joins all workers once no task group is in flight. The pool
+// restarts on the next submission.
+void DFParallelShutdown();
+
+// Splits the items [0, cost.size()) into at most parts contiguous ranges of
+// similar total cost. Returns the range boundaries, from 0 to cost.size().
+std::vector<int> DFBalancedRanges(const std::vector<uint64_t>& cost, int parts);
+
+}	// namespace pcl
+
+#endif	// __DustFreeParallel_h
@@ -1,137 +1,695 @@
-#include "DustFreeParameters.h"
-
-namespace pcl
-{
-
-DFStarDetectionSensitivity* TheDFStarDetectionSensitivityParameter = nullptr;
-DFStarDiffusionDistance* TheDFStarDiffusionDistanceParameter = nullptr;
-DFSmoothness* TheDFSmoothnessParameter = nullptr;
-DFTestSkyDetection * TheDFTestSkyDetectionParameter = nullptr;
-DFDownsample * TheDFDownsampleParameter = nullptr;
-
-DFStarDetectionSensitivity::DFStarDetectionSensitivity(MetaProcess* P) : MetaFloat(P)
-{
-    TheDFStarDetectionSensitivityParameter = this;
-}
-
-IsoString DFStarDetectionSensitivity::Id() const
-{
-    return "starDetectionSensitivity";
-}
-
-int DFStarDetectionSensitivity::Precision() const
-{
-    return 2;
-}
-
-double DFStarDetectionSensitivity::MinimumValue() const
-{
-    return 0.0;
-}
-
-double DFStarDetectionSensitivity::MaximumValue() const
-{
-    return 6.0;
-}
-
-double DFStarDetectionSensitivity::DefaultValue() const
-{
-    return 4.0;
-}
-
-DFStarDiffusionDistance::DFStarDiffusionDistance(MetaProcess* P) : MetaInt8(P)
-{
-    TheDFStarDiffusionDistanceParameter = this;
-}
-
-IsoString DFStarDiffusionDistance::Id() const
-{
-    return "starDiffusionDistance";
-}
-
-double DFStarDiffusionDistance::MinimumValue() const
-{
-    return 0.0;
-}
-
-double DFStarDiffusionDistance::MaximumValue() const
-{
-    return 10.0;
-}
-
-double DFStarDiffusionDistance::DefaultValue() const
-{
-    return 5.0;
-}
-
-DFSmoothness::DFSmoothness(MetaProcess* P) : MetaFloat(P)
-{
-    TheDFSmoothnessParameter = this;
-}
-
-IsoString DFSmoothness::Id() const
-{
-    return "smoothness";
-}
-
-int DFSmoothness::Precision() const
-{
-    return 2;
-}
-
-double DFSmoothness::MinimumValue() const
-{
-    return 0.0;
-}
-
-double DFSmoothness::MaximumValue() const
-{
-    return 10.0;
-}
-
-double DFSmoothness::DefaultValue() const
-{
-    return 2.0;
-}
-
-DFTestSkyDetection::DFTestSkyDetection(MetaProcess * P) : MetaBoolean(P) 
-{
-    TheDFTestSkyDetectionParameter = this; 
-}
-
-IsoString DFTestSkyDetection::Id() const
-{
-    return "testSkyDetection";
-}
-
-bool DFTestSkyDetection::DefaultValue() const
-{
-    return false; 
-}
-
-DFDownsample::DFDownsample(MetaProcess * P) : MetaUInt32(P) 
-{
-    TheDFDownsampleParameter = this; 
-}
-
-IsoString DFDownsample::Id() const
-{
-    return "downsample"; 
-}
-
-double DFDownsample::DefaultValue() const
-{
-    return 2; 
-}
-
-double DFDownsample::MinimumValue() const
-{
-    return 1; 
-}
-
-double DFDownsample::MaximumValue() const
-{
-    return 16; 
-}
-
-}	// namespace pcl
+#include "DustFreeParameters.h"
+#include "DustFreeShapes.h"
+
+namespace pcl
+{
+
+DFStarDetectionSensitivity* TheDFStarDetectionSensitivityParameter = nullptr;
+DFStarDiffusionDistance* TheDFStarDiffusionDistanceParameter = nullptr;
+DFSmoothness* TheDFSmoothnessParameter = nullptr;
+DFTestSkyDetection * TheDFTestSkyDetectionParameter = nullptr;
+DFDownsample * TheDFDownsampleParameter = nullptr;
+DFInpaintMethod* TheDFInpaintMethodParameter = nullptr;
+DFTiledInpainting* TheDFTiledInpaintingParameter = nullptr;
+DFDustRegionsOnly* TheDFDustRegionsOnlyParameter = nullptr;
+DFStarDetectionMethod* TheDFStarDetectionMethodParameter = nullptr;
+DFSmoothingMethod* TheDFSmoothingMethodParameter = nullptr;
+DFMemoryBudget* TheDFMemoryBudgetParameter = nullptr;
+DFStreaming* TheDFStreamingParameter = nullptr;
+DFFloatIntermediates* TheDFFloatIntermediatesParameter = nullptr;
+DFCacheSize* TheDFCacheSizeParameter = nullptr;
+DFDustMaskFile* TheDFDustMaskFileParameter = nullptr;
+DFTargetFrames* TheDFTargetFramesParameter = nullptr;
+DFTargetFrameEnabled* TheDFTargetFrameEnabledParameter = nullptr;
+DFTargetFramePath* TheDFTargetFramePathParameter = nullptr;
+DFOutputDirectory* TheDFOutputDirectoryParameter = nullptr;
+DFOutputPostfix* TheDFOutputPostfixParameter = nullptr;
+DFOverwriteExistingFiles* TheDFOverwriteExistingFilesParameter = nullptr;
+DFFramesInFlight* TheDFFramesInFlightParameter = nullptr;
+DFTraceFile* TheDFTraceFileParameter = nullptr;
+DFDustShapes* TheDFDustShapesParameter = nullptr;
+DFDustShapeEnabled* TheDFDustShapeEnabledParameter = nullptr;
+DFDustShapeX* TheDFDustShapeXParameter = nullptr;
+DFDustShapeY* TheDFDustShapeYParameter = nullptr;
+DFDustShapeRadius* TheDFDustShapeRadiusParameter = nullptr;
+DFDustShapeInnerRadius* TheDFDustShapeInnerRadiusParameter = nullptr;
+DFDustShapeAxisRatio* TheDFDustShapeAxisRatioParameter = nullptr;
+DFDustShapeAngle* TheDFDustShapeAngleParameter = nullptr;
+DFDustShapeFeather* TheDFDustShapeFeatherParameter = nullptr;
+
+DFStarDetectionSensitivity::DFStarDetectionSensitivity(MetaProcess* P) : MetaFloat(P)
+{
+    TheDFStarDetectionSensitivityParameter = this;
+}
+
+IsoString DFStarDetectionSensitivity::Id() const
+{
+    return "starDetectionSensitivity";
+}
+
+int DFStarDetectionSensitivity::Precision() const
+{
+    return 2;
+}
+
+double DFStarDetectionSensitivity::MinimumValue() const
+{
+    return 0.0;
+}
+
+double DFStarDetectionSensitivity::MaximumValue() const
+{
+    return 6.0;
+}
+
+double DFStarDetectionSensitivity::DefaultValue() const
+{
+    return 4.0;
+}
+
+DFStarDiffusionDistance::DFStarDiffusionDistance(MetaProcess* P) : MetaInt8(P)
+{
+    TheDFStarDiffusionDistanceParameter = this;
+}
+
+IsoString DFStarDiffusionDistance::Id() const
+{
+    return "starDiffusionDistance";
+}
+
+double DFStarDiffusionDistance::MinimumValue() const
+{
+    return 0.0;
+}
+
+double DFStarDiffusionDistance::MaximumValue() const
+{
+    return 50.0;
+}
+
+double DFStarDiffusionDistance::DefaultValue() const
+{
+    return 5.0;
+}
+
+DFSmoothness::DFSmoothness(MetaProcess* P) : MetaFloat(P)
+{
+    TheDFSmoothnessParameter = this;
+}
+
+IsoString DFSmoothness::Id() const
+{
+    return "smoothness";
+}
+
+int DFSmoothness::Precision() const
+{
+    return 2;
+}
+
+double DFSmoothness::MinimumValue() const
+{
+    return 0.0;
+}
+
+double DFSmoothness::MaximumValue() const
+{
+    return 10.0;
+}
+
+double DFSmoothness::DefaultValue() const
+{
+    return 2.0;
+}
+
+DFTestSkyDetection::DFTestSkyDetection(MetaProcess * P) : MetaBoolean(P) 
+{
+    TheDFTestSkyDetectionParameter = this; 
+}
+
+IsoString DFTestSkyDetection::Id() const
+{
+    return "testSkyDetection";
+}
+
+bool DFTestSkyDetection::DefaultValue() const
+{
+    return false; 
+}
+
+DFDownsample::DFDownsample(MetaProcess * P) : MetaUInt32(P) 
+{
+    TheDFDownsampleParameter = this; 
+}
+
+IsoString DFDownsample::Id() const
+{
+    return "downsample"; 
+}
+
+double DFDownsample::DefaultValue() const
+{
+    return 2; 
+}
+
+double DFDownsample::MinimumValue() const
+{
+    return 1; 
+}
+
+double DFDownsample::MaximumValue() const
+{
+    return 16; 
+}
+
+DFInpaintMethod::DFInpaintMethod(MetaProcess* P) : MetaEnumeration(P)
+{
+    TheDFInpaintMethodParameter = this;
+}
+
+IsoString DFInpaintMethod::Id() const
+{
+    return "inpaintMethod";
+}
+
+size_type DFInpaintMethod::NumberOfElements() const
+{
+    return NumberOfItems;
+}
+
+IsoString DFInpaintMethod::ElementId(size_type i) const
+{
+    switch (i) {
+    default:
+    case RayMarch:
+        return "InpaintMethod_RayMarch";
+    case NearestSample:
+        return "InpaintMethod_NearestSample";
+    case PushPull:
+        return "InpaintMethod_PushPull";
+    }
+}
+
+int DFInpaintMethod::ElementValue(size_type i) const
+{
+    return int(i);
+}
+
+size_type DFInpaintMethod::DefaultValueIndex() const
+{
+    return size_type(Default);
+}
+
+DFTiledInpainting::DFTiledInpainting(MetaProcess* P) : MetaBoolean(P)
+{
+    TheDFTiledInpaintingParameter = this;
+}
+
+IsoString DFTiledInpainting::Id() const
+{
+    return "tiledInpainting";
+}
+
+bool DFTiledInpainting::DefaultValue() const
+{
+    return true;
+}
+
+DFDustRegionsOnly::DFDustRegionsOnly(MetaProcess* P) : MetaBoolean(P)
+{
+    TheDFDustRegionsOnlyParameter = this;
+}
+
+IsoString DFDustRegionsOnly::Id() const
+{
+    return "dustRegionsOnly";
+}
+
+bool DFDustRegionsOnly::DefaultValue() const
+{
+    return false;
+}
+
+DFStarDetectionMethod::DFStarDetectionMethod(MetaProcess* P) : MetaEnumeration(P)
+{
+    TheDFStarDetectionMethodParameter = this;
+}
+
+IsoString DFStarDetectionMethod::Id() const
+{
+    return "starDetectionMethod";
+}
+
+size_type DFStarDetectionMethod::NumberOfElements() const
+{
+    return NumberOfItems;
+}
+
+IsoString DFStarDetectionMethod::ElementId(size_type i) const
+{
+    switch (i) {
+    default:
+    case MultiscaleLinear:
+        return "StarDetectionMethod_MultiscaleLinear";
+    case BandPass:
+        return "StarDetectionMethod_BandPass";
+    }
+}
+
+int DFStarDetectionMethod::ElementValue(size_type i) const
+{
+    return int(i);
+}
+
+size_type DFStarDetectionMethod::DefaultValueIndex() const
+{
+    return size_type(Default);
+}
+
+DFSmoothingMethod::DFSmoothingMethod(MetaProcess* P) : MetaEnumeration(P)
+{
+    TheDFSmoothingMethodParameter = this;
+}
+
+IsoString DFSmoothingMethod::Id() const
+{
+    return "smoothingMethod";
+}
+
+size_type DFSmoothingMethod::NumberOfElements() const
+{
+    return NumberOfItems;
+}
+
+IsoString DFSmoothingMethod::ElementId(size_type i) const
+{
+    switch (i) {
+    default:
+    case FFT:
+        return "SmoothingMethod_FFT";
+    case Recursive:
+        return "SmoothingMethod_Recursive";
+    }
+}
+
+int DFSmoothingMethod::ElementValue(size_type i) const
+{
+    return int(i);
+}
+
+size_type DFSmoothingMethod::DefaultValueIndex() const
+{
+    return size_type(Default);
+}
+
+DFMemoryBudget::DFMemoryBudget(MetaProcess* P) : MetaUInt32(P)
+{
+    TheDFMemoryBudgetParameter = this;
+}
+
+IsoString DFMemoryBudget::Id() const
+{
+    return "memoryBudget";
+}
+
+double DFMemoryBudget::DefaultValue() const
+{
+    return 0;
+}
+
+double DFMemoryBudget::MinimumValue() const
+{
+    return 0;
+}
+
+double DFMemoryBudget::MaximumValue() const
+{
+    return 1048576;
+}
+
+DFStreaming::DFStreaming(MetaProcess* P) : MetaBoolean(P)
+{
+    TheDFStreamingParameter = this;
+}
+
+IsoString DFStreaming::Id() const
+{
+    return "streaming";
+}
+
+bool DFStreaming::DefaultValue() const
+{
+    return false;
+}
+
+DFFloatIntermediates::DFFloatIntermediates(MetaProcess* P) : MetaBoolean(P)
+{
+    TheDFFloatIntermediatesParameter = this;
+}
+
+IsoString DFFloatIntermediates::Id() const
+{
+    return "floatIntermediates";
+}
+
+bool DFFloatIntermediates::DefaultValue() const
+{
+    return true;
+}
+
+DFCacheSize::DFCacheSize(MetaProcess* P) : MetaUInt32(P)
+{
+    TheDFCacheSizeParameter = this;
+}
+
+IsoString DFCacheSize::Id() const
+{
+    return "cacheSize";
+}
+
+double DFCacheSize::DefaultValue() const
+{
+    return 0;
+}
+
+double DFCacheSize::MinimumValue() const
+{
+    return 0;
+}
+
+double DFCacheSize::MaximumValue() const
+{
+    return 1048576;
+}
+
+DFDustMaskFile::DFDustMaskFile(MetaProcess* P) : MetaString(P)
+{
+    TheDFDustMaskFileParameter = this;
+}
+
+IsoString DFDustMaskFile::Id() const
+{
+    return "dustMaskFile";
+}
+
+DFTargetFrames::DFTargetFrames(MetaProcess* P) : MetaTable(P)
+{
+    TheDFTargetFramesParameter = this;
+}
+
+IsoString DFTargetFrames::Id() const
+{
+    return "targetFrames";
+}
+
+DFTargetFrameEnabled::DFTargetFrameEnabled(MetaTable* T) : MetaBoolean(T)
+{
+    TheDFTargetFrameEnabledParameter = this;
+}
+
+IsoString DFTargetFrameEnabled::Id() const
+{
+    return "enabled";
+}
+
+bool DFTargetFrameEnabled::DefaultValue() const
+{
+    return true;
+}
+
+DFTargetFramePath::DFTargetFramePath(MetaTable* T) : MetaString(T)
+{
+    TheDFTargetFramePathParameter = this;
+}
+
+IsoString DFTargetFramePath::Id() const
+{
+    return "path";
+}
+
+DFOutputDirectory::DFOutputDirectory(MetaProcess* P) : MetaString(P)
+{
+    TheDFOutputDirectoryParameter = this;
+}
+
+IsoString DFOutputDirectory::Id() const
+{
+    return "outputDirectory";
+}
+
+DFOutputPostfix::DFOutputPostfix(MetaProcess* P) : MetaString(P)
+{
+    TheDFOutputPostfixParameter = this;
+}
+
+IsoString DFOutputPostfix::Id() const
+{
+    return "outputPostfix";
+}
+
+String DFOutputPostfix::DefaultValue() const
+{
+    return "_df";
+}
+
+DFOverwriteExistingFiles::DFOverwriteExistingFiles(MetaProcess* P) : MetaBoolean(P)
+{
+    TheDFOverwriteExistingFilesParameter = this;
+}
+
+IsoString DFOverwriteExistingFiles::Id() const
+{
+    return "overwriteExistingFiles";
+}
+
+bool DFOverwriteExistingFiles::DefaultValue() const
+{
+    return false;
+}
+
+DFFramesInFlight::DFFramesInFlight(MetaProcess* P) : MetaUInt32(P)
+{
+    TheDFFramesInFlightParameter = this;
+}
+
+IsoString DFFramesInFlight::Id() const
+{
+    return "framesInFlight";
+}
+
+double DFFramesInFlight::DefaultValue() const
+{
+    return 3;
+}
+
+double DFFramesInFlight::MinimumValue() const
+{
+    return 1;
+}
+
+double DFFramesInFlight::MaximumValue() const
+{
+    return 64;
+}
+
+DFTraceFile::DFTraceFile(MetaProcess* P) : MetaString(P)
+{
+    TheDFTraceFileParameter = this;
+}
+
+IsoString DFTraceFile::Id() const
+{
+    return "traceFile";
+}
+
+DFDustShapes::DFDustShapes(MetaProcess* P) : MetaTable(P)
+{
+    TheDFDustShapesParameter = this;
+}
+
+IsoString DFDustShapes::Id() const
+{
+    return "dustShapes";
+}
+
+DFDustShapeEnabled::DFDustShapeEnabled(MetaTable* T) : MetaBoolean(T)
+{
+    TheDFDustShapeEnabledParameter = this;
+}
+
+IsoString DFDustShapeEnabled::Id() const
+{
+    return "shapeEnabled";
+}
+
+bool DFDustShapeEnabled::DefaultValue() const
+{
+    return true;
+}
+
+DFDustShapeX::DFDustShapeX(MetaTable* T) : MetaDouble(T)
+{
+    TheDFDustShapeXParameter = this;
+}
+
+IsoString DFDustShapeX::Id() const
+{
+    return "shapeX";
+}
+
+int DFDustShapeX::Precision() const
+{
+    return 2;
+}
+
+double DFDustShapeX::DefaultValue() const
+{
+    return 0.0;
+}
+
+DFDustShapeY::DFDustShapeY(MetaTable* T) : MetaDouble(T)
+{
+    TheDFDustShapeYParameter = this;
+}
+
+IsoString DFDustShapeY::Id() const
+{
+    return "shapeY";
+}
+
+int DFDustShapeY::Precision() const
+{
+    return 2;
+}
+
+double DFDustShapeY::DefaultValue() const
+{
+    return 0.0;
+}
+
+DFDustShapeRadius::DFDustShapeRadius(MetaTable* T) : MetaDouble(T)
+{
+    TheDFDustShapeRadiusParameter = this;
+}
+
+IsoString DFDustShapeRadius::Id() const
+{
+    return "shapeRadius";
+}
+
+int DFDustShapeRadius::Precision() const
+{
+    return 2;
+}
+
+double DFDustShapeRadius::MinimumValue() const
+{
+    return 0.0;
+}
+
+double DFDustShapeRadius::DefaultValue() const
+{
+    return 10.0;
+}
+
+DFDustShapeInnerRadius::DFDustShapeInnerRadius(MetaTable* T) : MetaDouble(T)
+{
+    TheDFDustShapeInnerRadiusParameter = this;
+}
+
+IsoString DFDustShapeInnerRadius::Id() const
+{
+    return "shapeInnerRadius";
+}
+
+int DFDustShapeInnerRadius::Precision() const
+{
+    return 2;
+}
+
+double DFDustShapeInnerRadius::MinimumValue() const
+{
+    return 0.0;
+}
+
+double DFDustShapeInnerRadius::DefaultValue() const
+{
+    return 0.0;
+}
+
+DFDustShapeAxisRatio::DFDustShapeAxisRatio(MetaTable* T) : MetaDouble(T)
+{
+    TheDFDustShapeAxisRatioParameter = this;
+}
+
+IsoString DFDustShapeAxisRatio::Id() const
+{
+    return "shapeAxisRatio";
+}
+
+int DFDustShapeAxisRatio::Precision() const
+{
+    return 3;
+}
+
+double DFDustShapeAxisRatio::MinimumValue() const
+{
+    return DFMinimumAxisRatio;
+}
+
+double DFDustShapeAxisRatio::MaximumValue() const
+{
+    return 1.0;
+}
+
+double DFDustShapeAxisRatio::DefaultValue() const
+{
+    return 1.0;
+}
+
+DFDustShapeAngle::DFDustShapeAngle(MetaTable* T) : MetaDouble(T)
+{
+    TheDFDustShapeAngleParameter = this;
+}
+
+IsoString DFDustShapeAngle::Id() const
+{
+    return "shapeAngle";
+}
+
+int DFDustShapeAngle::Precision() const
+{
+    return 2;
+}
+
+double DFDustShapeAngle::DefaultValue() const
+{
+    return 0.0;
+}
+
+DFDustShapeFeather::DFDustShapeFeather(MetaTable* T) : MetaDouble(T)
+{
+    TheDFDustShapeFeatherParameter = this;
+}
+
+IsoString DFDustShapeFeather::Id() const
+{
+    return "shapeFeather";
+}
+
+int DFDustShapeFeather::Precision() const
+{
+    return 2;
+}
+
+double DFDustShapeFeather::MinimumValue() const
+{
+    return 0.0;
+}
+
+double DFDustShapeFeather::DefaultValue() const
+{
+    return 0.0;
+}
+
+}	// namespace pcl
@@ -1,80 +1,414 @@
-#ifndef __DustFreeParameters_h
-#define __DustFreeParameters_h
-
-#include <pcl/MetaParameter.h>
-
-namespace pcl
-{
-
-PCL_BEGIN_LOCAL
-
-class DFStarDetectionSensitivity : public MetaFloat
-{
-public:
-    DFStarDetectionSensitivity(MetaProcess*);
-
-    IsoString Id() const override;
-    int Precision() const override;
-    double MinimumValue() const override;
-    double MaximumValue() const override;
-    double DefaultValue() const override;
-};
-
-extern DFStarDetectionSensitivity* TheDFStarDetectionSensitivityParameter;
-
-class DFStarDiffusionDistance : public MetaInt8
-{
-public:
-    DFStarDiffusionDistance(MetaProcess*);
-
-    IsoString Id() const override;
-    double MinimumValue() const override;
-    double MaximumValue() const override;
-    double DefaultValue() const override;
-};
-
-extern DFStarDiffusionDistance* TheDFStarDiffusionDistanceParameter;
-
-class DFSmoothness : public MetaFloat
-{
-public:
-    DFSmoothness(MetaProcess*);
-
-    IsoString Id() const override;
-    int Precision() const override;
-    double MinimumValue() const override;
-    double MaximumValue() const override;
-    double DefaultValue() const override;
-};
-
-extern DFSmoothness* TheDFSmoothnessParameter;
-
-class DFTestSkyDetection : public MetaBoolean
-{
-public:
-    DFTestSkyDetection(MetaProcess*);
-
-    IsoString Id() const override;
-    bool DefaultValue() const override;
-};
-
-extern DFTestSkyDetection * TheDFTestSkyDetectionParameter;
-
-class DFDownsample : public MetaUInt32
-{
-public:
-    DFDownsample(MetaProcess*);
-
-    IsoString Id() const override;
-    double DefaultValue() const override;
-    double MinimumValue() const override;
-    double MaximumValue() const override;
-};
-
-extern DFDownsample * TheDFDownsampleParameter;
-
-PCL_END_LOCAL
-
-}	// namespace pcl
-
-#endif	// __DustFreeParameters_h
+#ifndef __DustFreeParameters_h
+#define __DustFreeParameters_h
+
+#include <pcl/MetaParameter.h>
+
+namespace pcl
+{
+
+PCL_BEGIN_LOCAL
+
+class DFStarDetectionSensitivity : public MetaFloat
+{
+public:
+    DFStarDetectionSensitivity(MetaProcess*);
+
+    IsoString Id() const override;
+    int Precision() const override;
+    double MinimumValue() const override;
+    double MaximumValue() const override;
+    double DefaultValue() const override;
+};
+
+extern DFStarDetectionSensitivity* TheDFStarDetectionSensitivityParameter;
+
+class DFStarDiffusionDistance : public MetaInt8
+{
+public:
+    DFStarDiffusionDistance(MetaProcess*);
+
+    IsoString Id() const override;
+    double MinimumValue() const override;
+    double MaximumValue() const override;
+    double DefaultValue() const override;
+};
+
+extern DFStarDiffusionDistance* TheDFStarDiffusionDistanceParameter;
+
+class DFSmoothness : public MetaFloat
+{
+public:
+    DFSmoothness(MetaProcess*);
+
+    IsoString Id() const override;
+    int Precision() const override;
+    double MinimumValue() const override;
+    double MaximumValue() const override;
+    double DefaultValue() const override;
+};
+
+extern DFSmoothness* TheDFSmoothnessParameter;
+
+class DFTestSkyDetection : public MetaBoolean
+{
+public:
+    DFTestSkyDetection(MetaProcess*);
+
+    IsoString Id() const override;
+    bool DefaultValue() const override;
+};
+
+extern DFTestSkyDetection * TheDFTestSkyDetectionParameter;
+
+class DFDownsample : public MetaUInt32
+{
+public:
+    DFDownsample(MetaProcess*);
+
+    IsoString Id() const override;
+    double DefaultValue() const override;
+    double MinimumValue() const override;
+    double MaximumValue() const override;
+};
+
+extern DFDownsample * TheDFDownsampleParameter;
+
+class DFInpaintMethod : public MetaEnumeration
+{
+public:
+    enum { RayMarch,
+           NearestSample,
+           PushPull,
+           NumberOfItems,
+           Default = RayMarch };
+
+    DFInpaintMethod(MetaProcess*);
+
+    IsoString Id() const override;
+    size_type NumberOfElements() const override;
+    IsoString ElementId(size_type) const override;
+    int ElementValue(size_type) const override;
+    size_type DefaultValueIndex() const override;
+};
+
+extern DFInpaintMethod* TheDFInpaintMethodParameter;
+
+class DFTiledInpainting : public MetaBoolean
+{
+public:
+    DFTiledInpainting(MetaProcess*);
+
+    IsoString Id() const override;
+    bool DefaultValue() const override;
+};
+
+extern DFTiledInpainting* TheDFTiledInpaintingParameter;
+
+class DFDustRegionsOnly : public MetaBoolean
+{
+public:
+    DFDustRegionsOnly(MetaProcess*);
+
+    IsoString Id() const override;
+    bool DefaultValue() const override;
+};
+
+extern DFDustRegionsOnly* TheDFDustRegionsOnlyParameter;
+
+class DFStarDetectionMethod : public MetaEnumeration
+{
+public:
+    enum { MultiscaleLinear,
+           BandPass,
+           NumberOfItems,
+           Default = MultiscaleLinear };
+
+    DFStarDetectionMethod(MetaProcess*);
+
+    IsoString Id() const override;
+    size_type NumberOfElements() const override;
+    IsoString ElementId(size_type) const override;
+    int ElementValue(size_type) const override;
+    size_type DefaultValueIndex() const override;
+};
+
+extern DFStarDetectionMethod* TheDFStarDetectionMethodParameter;
+
+class DFSmoothingMethod : public MetaEnumeration
+{
+public:
+    enum { FFT,
+           Recursive,
+           NumberOfItems,
+           Default = FFT };
+
+    DFSmoothingMethod(MetaProcess*);
+
+    IsoString Id() const override;
+    size_type NumberOfElements() const override;
+    IsoString ElementId(size_type) const override;
+    int ElementValue(size_type) const override;
+    size_type DefaultValueIndex() const override;
+};
+
+extern DFSmoothingMethod* TheDFSmoothingMethodParameter;
+
+class DFMemoryBudget : public MetaUInt32
+{
+public:
+    DFMemoryBudget(MetaProcess*);
+
+    IsoString Id() const override;
+    double DefaultValue() const override;
+    double MinimumValue() const override;
+    double MaximumValue() const override;
+};
+
+extern DFMemoryBudget* TheDFMemoryBudgetParameter;
+
+class DFStreaming : public MetaBoolean
+{
+public:
+    DFStreaming(MetaProcess*);
+
+    IsoString Id() const override;
+    bool DefaultValue() const override;
+};
+
+extern DFStreaming* TheDFStreamingParameter;
+
+class DFFloatIntermediates : public MetaBoolean
+{
+public:
+    DFFloatIntermediates(MetaProcess*);
+
+    IsoString Id() const override;
+    bool DefaultValue() const override;
+};
+
+extern DFFloatIntermediates* TheDFFloatIntermediatesParameter;
+
+class DFCacheSize : public MetaUInt32
+{
+public:
+    DFCacheSize(MetaProcess*);
+
+    IsoString Id() const override;
+    double DefaultValue() const override;
+    double MinimumValue() const override;
+    double MaximumValue() const override;
+};
+
+extern DFCacheSize* TheDFCacheSizeParameter;
+
+class DFDustMaskFile : public MetaString
+{
+public:
+    DFDustMaskFile(MetaProcess*);
+
+    IsoString Id() const override;
+};
+
+extern DFDustMaskFile* TheDFDustMaskFileParameter;
+
+class DFTargetFrames : public MetaTable
+{
+public:
+    DFTargetFrames(MetaProcess*);
+
+    IsoString Id() const override;
+};
+
+extern DFTargetFrames* TheDFTargetFramesParameter;
+
+class DFTargetFrameEnabled : public MetaBoolean
+{
+public:
+    DFTargetFrameEnabled(MetaTable*);
+
+    IsoString Id() const override;
+    bool DefaultValue() const override;
+};
+
+extern DFTargetFrameEnabled* TheDFTargetFrameEnabledParameter;
+
+class DFTargetFramePath : public MetaString
+{
+public:
+    DFTargetFramePath(MetaTable*);
+
+    IsoString Id() const override;
+};
+
+extern DFTargetFramePath* TheDFTargetFramePathParameter;
+
+class DFOutputDirectory : public MetaString
+{
+public:
+    DFOutputDirectory(MetaProcess*);
+
+    IsoString Id() const override;
+};
+
+extern DFOutputDirectory* TheDFOutputDirectoryParameter;
+
+class DFOutputPostfix : public MetaString
+{
+public:
+    DFOutputPostfix(MetaProcess*);
+
+    IsoString Id() const override;
+    String DefaultValue() const override;
+};
+
+extern DFOutputPostfix* TheDFOutputPostfixParameter;
+
+class DFOverwriteExistingFiles : public MetaBoolean
+{
+public:
+    DFOverwriteExistingFiles(MetaProcess*);
+
+    IsoString Id() const override;
+    bool DefaultValue() const override;
+};
+
+extern DFOverwriteExistingFiles* TheDFOverwriteExistingFilesParameter;
+
+class DFFramesInFlight : public MetaUInt32
+{
+public:
+    DFFramesInFlight(MetaProcess*);
+
+    IsoString Id() const override;
+    double DefaultValue() const override;
+    double MinimumValue() const override;
+    double MaximumValue() const override;
+};
+
+extern DFFramesInFlight* TheDFFramesInFlightParameter;
+
+class DFTraceFile : public MetaString
+{
+public:
+    DFTraceFile(MetaProcess*);
+
+    IsoString Id() const override;
+};
+
+extern DFTraceFile* TheDFTraceFileParameter;
+
+class DFDustShapes : public MetaTable
+{
+public:
+    DFDustShapes(MetaProcess*);
+
+    IsoString Id() const override;
+};
+
+extern DFDustShapes* TheDFDustShapesParameter;
+
+class DFDustShapeEnabled : public MetaBoolean
+{
+public:
+    DFDustShapeEnabled(MetaTable*);
+
+    IsoString Id() const override;
+    bool DefaultValue() const override;
+};
+
+extern DFDustShapeEnabled* TheDFDustShapeEnabledParameter;
+
+class DFDustShapeX : public MetaDouble
+{
+public:
+    DFDustShapeX(MetaTable*);
+
+    IsoString Id() const override;
+    int Precision() const override;
+    double DefaultValue() const override;
+};
+
+extern DFDustShapeX* TheDFDustShapeXParameter;
+
+class DFDustShapeY : public MetaDouble
+{
+public:
+    DFDustShapeY(MetaTable*);
+
+    IsoString Id() const override;
+    int Precision() const override;
+    double DefaultValue() const override;
+};
+
+extern DFDustShapeY* TheDFDustShapeYParameter;
+
+class DFDustShapeRadius : public MetaDouble
+{
+public:
+    DFDustShapeRadius(MetaTable*);
+
+    IsoString Id() const override;
+    int Precision() const override;
+    double MinimumValue() const override;
+    double DefaultValue() const override;
+};
+
+extern DFDustShapeRadius* TheDFDustShapeRadiusParameter;
+
+class DFDustShapeInnerRadius : public MetaDouble
+{
+public:
+    DFDustShapeInnerRadius(MetaTable*);
+
+    IsoString Id() const override;
+    int Precision() const override;
+    double MinimumValue() const override;
+    double DefaultValue() const override;
+};
+
+extern DFDustShapeInnerRadius* TheDFDustShapeInnerRadiusParameter;
+
+class DFDustShapeAxisRatio : public MetaDouble
+{
+public:
+    DFDustShapeAxisRatio(MetaTable*);
+
+    IsoString Id() const override;
+    int Precision() const override;
+    double MinimumValue() const override;
+    double MaximumValue() const override;
+    double DefaultValue() const override;
+};
+
+extern DFDustShapeAxisRatio* TheDFDustShapeAxisRatioParameter;
+
+class DFDustShapeAngle : public MetaDouble
+{
+public:
+    DFDustShapeAngle(MetaTable*);
+
+    IsoString Id() const override;
+    int Precision() const override;
+    double DefaultValue() const override;
+};
+
+extern DFDustShapeAngle* TheDFDustShapeAngleParameter;
+
+class DFDustShapeFeather : public MetaDouble
+{
+public:
+    DFDustShapeFeather(MetaTable*);
+
+    IsoString Id() const override;
+    int Precision() const override;
+    double MinimumValue() const override;
+    double DefaultValue() const override;
+};
+
+extern DFDustShapeFeather* TheDFDustShapeFeatherParameter;
+
+PCL_END_LOCAL
+
+}	// namespace pcl
+
+#endif	// __DustFreeParameters_h
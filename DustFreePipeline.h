@@ -0,0 +1,127 @@
+#ifndef __DustFreePipeline_h
+#define __DustFreePipeline_h
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "DustFreeParallel.h"
+
+namespace pcl
+{
+
+// Runs the items [0, count) through three stages that overlap: read(i) returns
+// a Frame on a reader thread, process(i, frame) runs on the calling thread and
+// write(i, frame) on a writer thread, all three in item order. While item i is
+// processed, item i+1 can be read and item i-1 written. At most inFlight frames
+// exist at once, from the start of their read to the end of their write; with
+// fewer than three, the stages overlap less. The reader and the writer are
+// started with DFStartThread, so they run as PCL threads within the module.
+//
+// Errors of single frames should be handled by the stages themselves. The
+// first exception thrown by any stage stops reading and processing at the
+// next item, but the frames already processed are still written unless the
+// writer itself failed; it is rethrown here once both threads have finished.
+template <class Frame, class Read, class Process, class Write>
+void DFRunPipeline(int count, int inFlight, const Read& read, const Process& process, const Write& write)
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::pair<int, Frame>> readFrames;
+    std::deque<std::pair<int, Frame>> processedFrames;
+    int live = 0;
+    bool processing = true;
+    bool stop = false;
+    std::exception_ptr error;
+
+    auto fail = [&](std::exception_ptr e) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error)
+            error = e;
+        stop = true;
+        changed.notify_all();
+    };
+
+    std::unique_ptr<DFWorkerThread> reader = DFStartThread([&]() {
+        for (int i = 0; i < count; i++) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&]() { return stop || (live < inFlight); });
+                if (stop)
+                    return;
+                live++;
+            }
+            try {
+                Frame frame = read(i);
+                std::lock_guard<std::mutex> lock(mutex);
+                readFrames.emplace_back(i, std::move(frame));
+                changed.notify_all();
+            } catch (...) {
+                fail(std::current_exception());
+                return;
+            }
+        }
+    });
+
+    std::unique_ptr<DFWorkerThread> writer = DFStartThread([&]() {
+        for (;;) {
+            std::pair<int, Frame> item;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&]() { return !processedFrames.empty() || !processing; });
+                if (processedFrames.empty())
+                    return;
+                item = std::move(processedFrames.front());
+                processedFrames.pop_front();
+            }
+            try {
+                write(item.first, item.second);
+            } catch (...) {
+                fail(std::current_exception());
+                return;
+            }
+            item.second = Frame();
+            std::lock_guard<std::mutex> lock(mutex);
+            live--;
+            changed.notify_all();
+        }
+    });
+
+    for (int i = 0; i < count; i++) {
+        std::pair<int, Frame> item;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&]() { return stop || !readFrames.empty(); });
+            if (stop)
+                break;
+            item = std::move(readFrames.front());
+            readFrames.pop_front();
+        }
+        try {
+            process(item.first, item.second);
+        } catch (...) {
+            fail(std::current_exception());
+            break;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        processedFrames.push_back(std::move(item));
+        changed.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        processing = false;
+        changed.notify_all();
+    }
+
+    reader->Join();
+    writer->Join();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+}	// namespace pcl
+
+#endif	// __DustFreePipeline_h
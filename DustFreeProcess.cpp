@@ -23,6 +23,33 @@ DustFreeProcess::DustFreeProcess()
     new DFSmoothness(this);
     new DFDownsample(this);
     new DFTestSkyDetection(this);
+    new DFInpaintMethod(this);
+    new DFTiledInpainting(this);
+    new DFDustRegionsOnly(this);
+    new DFStarDetectionMethod(this);
+    new DFSmoothingMethod(this);
+    new DFMemoryBudget(this);
+    new DFStreaming(this);
+    new DFFloatIntermediates(this);
+    new DFCacheSize(this);
+    new DFDustMaskFile(this);
+    new DFTargetFrames(this);
+    new DFTargetFrameEnabled(TheDFTargetFramesParameter);
+    new DFTargetFramePath(TheDFTargetFramesParameter);
+    new DFOutputDirectory(this);
+    new DFOutputPostfix(this);
+    new DFOverwriteExistingFiles(this);
+    new DFFramesInFlight(this);
+    new DFTraceFile(this);
+    new DFDustShapes(this);
+    new DFDustShapeEnabled(TheDFDustShapesParameter);
+    new DFDustShapeX(TheDFDustShapesParameter);
+    new DFDustShapeY(TheDFDustShapesParameter);
+    new DFDustShapeRadius(TheDFDustShapesParameter);
+    new DFDustShapeInnerRadius(TheDFDustShapesParameter);
+    new DFDustShapeAxisRatio(TheDFDustShapesParameter);
+    new DFDustShapeAngle(TheDFDustShapesParameter);
+    new DFDustShapeFeather(TheDFDustShapesParameter);
 }
 
 IsoString DustFreeProcess::Id() const
@@ -115,9 +142,116 @@ bool DustFreeProcess::NeedsValidation() const
 
 // ----------------------------------------------------------------------------
 
+bool DustFreeProcess::CanProcessGlobal() const
+{
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+
 bool DustFreeProcess::CanProcessCommandLines() const
 {
-    return false;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+
+static void ShowHelp()
+{
+    Console().Write(
+"<raw>"
+"Usage: DustFree [<arg_list>] [<file_list>]"
+"\n"
+"\n--mask=<view_id>"
+"\n"
+"\n      Identifier of the dust mask image."
+"\n"
+"\n--mask-file=<file>"
+"\n"
+"\n      Compiled dust mask file, used with or instead of the dust mask image."
+"\n"
+"\n-o=<dir> | --output-directory=<dir>"
+"\n"
+"\n      Directory where the processed frames are written. Required to process"
+"\n      the files of <file_list>."
+"\n"
+"\n--postfix=<postfix>"
+"\n"
+"\n      Appended to the name of each output file. The default is _df."
+"\n"
+"\n--overwrite"
+"\n"
+"\n      Replace existing output files."
+"\n"
+"\n--frames-in-flight=<n>"
+"\n"
+"\n      Maximum number of frames held in memory at once, from their read to"
+"\n      their write. The default is 3, which lets the next frame be read and"
+"\n      the previous one written while the current one is processed."
+"\n"
+"\n--trace-file=<file>"
+"\n"
+"\n      Writes the time, memory and inpainting counters of every stage of every"
+"\n      frame to <file> as JSON."
+"\n"
+"\n--interface"
+"\n"
+"\n      Launches the interface of this process."
+"\n"
+"\n--help"
+"\n"
+"\n      Displays this help and exits."
+"</raw>" );
+}
+
+int DustFreeProcess::ProcessCommandLine(const StringList& argv) const
+{
+    ArgumentList arguments = ExtractArguments(argv, ArgumentItemMode::AsFiles, ArgumentOption::AllowWildcards);
+
+    DustFreeInstance instance(this);
+    bool launchInterface = false;
+
+    for (const Argument& arg : arguments) {
+        if (arg.IsNumeric()) {
+            if (arg.Id() == "-frames-in-flight")
+                instance.framesInFlight = uint32(Range(arg.NumericValue(),
+                    TheDFFramesInFlightParameter->MinimumValue(), TheDFFramesInFlightParameter->MaximumValue()));
+            else
+                throw Error("Unknown numeric argument: " + arg.Token());
+        } else if (arg.IsString()) {
+            if (arg.Id() == "-mask")
+                instance.dustMaskViewId = arg.StringValue();
+            else if (arg.Id() == "-mask-file")
+                instance.dustMaskFile = arg.StringValue();
+            else if ((arg.Id() == "o") || (arg.Id() == "-output-directory"))
+                instance.outputDirectory = arg.StringValue();
+            else if (arg.Id() == "-postfix")
+                instance.outputPostfix = arg.StringValue();
+            else if (arg.Id() == "-trace-file")
+                instance.traceFile = arg.StringValue();
+            else
+                throw Error("Unknown string argument: " + arg.Token());
+        } else if (arg.IsLiteral()) {
+            if (arg.Id() == "-overwrite")
+                instance.overwriteExistingFiles = true;
+            else if (arg.Id() == "-interface")
+                launchInterface = true;
+            else if (arg.Id() == "-help") {
+                ShowHelp();
+                return 0;
+            } else
+                throw Error("Unknown argument: " + arg.Token());
+        } else if (arg.IsItemList())
+            for (const String& path : arg.Items())
+                instance.targetFrames << DustFreeInstance::TargetFrame(path);
+    }
+
+    if (launchInterface || instance.targetFrames.IsEmpty())
+        instance.LaunchInterface();
+    else
+        instance.LaunchGlobal();
+
+    return 0;
 }
 
 }	// namespace pcl
@@ -0,0 +1,266 @@
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+#endif
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+
+#include "DustFreeProfile.h"
+
+namespace pcl
+{
+
+void DFInpaintCounter::Add(const DFInpaintCounts& counts)
+{
+    m_holePixels += counts.holePixels;
+    m_raysCast += counts.raysCast;
+    m_raySteps += counts.raySteps;
+    m_earlyExits += counts.earlyExits;
+}
+
+DFInpaintCounts DFInpaintCounter::Totals() const
+{
+    DFInpaintCounts counts;
+    counts.holePixels = m_holePixels.load();
+    counts.raysCast = m_raysCast.load();
+    counts.raySteps = m_raySteps.load();
+    counts.earlyExits = m_earlyExits.load();
+    return counts;
+}
+
+#ifdef _WIN32
+
+double DFThreadCPUTime()
+{
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+        return 0;
+    auto seconds = [](const FILETIME& t) {
+        return ((unsigned long long)(t.dwHighDateTime) << 32 | t.dwLowDateTime) * 1.0e-7;
+    };
+    return seconds(kernel) + seconds(user);
+}
+
+size_t DFResidentMemory()
+{
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.WorkingSetSize;
+}
+
+size_t DFPeakResidentMemory()
+{
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.PeakWorkingSetSize;
+}
+
+#else
+
+double DFThreadCPUTime()
+{
+    struct timespec t;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t) != 0)
+        return 0;
+    return t.tv_sec + 1.0e-9 * t.tv_nsec;
+}
+
+size_t DFResidentMemory()
+{
+#ifdef __APPLE__
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, task_info_t(&info), &count) != KERN_SUCCESS)
+        return 0;
+    return info.resident_size;
+#else
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (f == nullptr)
+        return 0;
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    const int n = std::fscanf(f, "%lu %lu", &size, &resident);
+    std::fclose(f);
+    return (n == 2) ? size_t(resident) * size_t(sysconf(_SC_PAGESIZE)) : 0;
+#endif
+}
+
+size_t DFPeakResidentMemory()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return size_t(usage.ru_maxrss);           // bytes
+#else
+    return size_t(usage.ru_maxrss) * 1024;    // KiB
+#endif
+}
+
+#endif	// _WIN32
+
+DFStageProfile::Stage& DFStageProfile::Find(const std::string& name)
+{
+    for (Stage& s : m_stages)
+        if (s.name == name)
+            return s;
+    m_stages.emplace_back();
+    m_stages.back().name = name;
+    return m_stages.back();
+}
+
+DFStageProfile::Stage DFStageProfile::Total() const
+{
+    Stage total;
+    total.name = "Total";
+    for (const Stage& s : m_stages) {
+        total.calls += s.calls;
+        total.wall += s.wall;
+        total.cpu += s.cpu;
+        total.allocated += s.allocated;
+        total.peak = std::max(total.peak, s.peak);
+        total.resident = s.resident;
+        total.peakResident = std::max(total.peakResident, s.peakResident);
+        total.inpaint += s.inpaint;
+    }
+    return total;
+}
+
+static std::string Format(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    const int length = std::vsnprintf(nullptr, 0, format, copy);
+    va_end(copy);
+    std::string s(size_t(std::max(length, 0)) + 1, '\0');
+    std::vsnprintf(&s[0], s.size(), format, args);
+    va_end(args);
+    s.resize(s.size() - 1);
+    return s;
+}
+
+std::string DFStageProfile::Table() const
+{
+    const double MiB = 1048576.0;
+    // Threads is the average number of busy threads: CPU time over wall time.
+    auto row = [&](const Stage& s) {
+        return Format("%-20s %5d %9.3f %9.3f %7.2f %10.1f %10.1f %10.1f %10.1f\n", s.name.c_str(), s.calls, s.wall,
+            s.cpu, (s.wall > 0) ? s.cpu / s.wall : 0.0, s.allocated / MiB, s.peak / MiB, s.resident / MiB,
+            s.peakResident / MiB);
+    };
+    std::string table = Format("%-20s %5s %9s %9s %7s %10s %10s %10s %10s\n", "Stage", "Calls", "Wall (s)", "CPU (s)",
+        "Threads", "Alloc MiB", "Peak MiB", "RSS MiB", "Max RSS");
+    for (const Stage& s : m_stages)
+        table += row(s);
+    const Stage total = Total();
+    table += row(total);
+    if (total.inpaint.holePixels > 0)
+        table += Format("Inpainting: %llu hole pixels, %llu rays cast, %llu ray steps, %llu early exits\n",
+            (unsigned long long)total.inpaint.holePixels, (unsigned long long)total.inpaint.raysCast,
+            (unsigned long long)total.inpaint.raySteps, (unsigned long long)total.inpaint.earlyExits);
+    return table;
+}
+
+std::string DFStageProfile::Json(const std::string& members) const
+{
+    auto object = [](const Stage& s) {
+        return Format("{\"name\": %s, \"calls\": %d, \"wallSeconds\": %.6f, \"cpuSeconds\": %.6f, "
+            "\"allocatedBytes\": %llu, \"peakBytes\": %llu, \"residentBytes\": %llu, \"peakResidentBytes\": %llu, "
+            "\"holePixels\": %llu, \"raysCast\": %llu, \"raySteps\": %llu, \"earlyExits\": %llu}",
+            DFJsonString(s.name).c_str(), s.calls, s.wall, s.cpu, (unsigned long long)s.allocated,
+            (unsigned long long)s.peak, (unsigned long long)s.resident, (unsigned long long)s.peakResident,
+            (unsigned long long)s.inpaint.holePixels, (unsigned long long)s.inpaint.raysCast,
+            (unsigned long long)s.inpaint.raySteps, (unsigned long long)s.inpaint.earlyExits);
+    };
+    std::string json = "{" + members;
+    if (!members.empty())
+        json += ", ";
+    json += "\"stages\": [";
+    for (size_t i = 0; i < m_stages.size(); i++) {
+        if (i > 0)
+            json += ", ";
+        json += object(m_stages[i]);
+    }
+    json += "], \"total\": " + object(Total()) + "}";
+    return json;
+}
+
+std::string DFJsonString(const std::string& s)
+{
+    std::string json = "\"";
+    for (char c : s)
+        switch (c) {
+        case '"': json += "\\\""; break;
+        case '\\': json += "\\\\"; break;
+        case '\n': json += "\\n"; break;
+        case '\r': json += "\\r"; break;
+        case '\t': json += "\\t"; break;
+        default:
+            if ((unsigned char)c < 0x20)
+                json += Format("\\u%04x", unsigned(c));
+            else
+                json += c;
+        }
+    return json + "\"";
+}
+
+DFStageTimer::DFStageTimer(DFStageProfile& profile, const char* name, DFMemoryLedger& memory)
+    : m_profile(profile)
+    , m_memory(memory)
+    , m_account(DFSetCpuAccount(&profile.m_cpu))
+{
+    Start(name);
+}
+
+DFStageTimer::~DFStageTimer()
+{
+    Stop();
+    DFSetCpuAccount(m_account);
+}
+
+void DFStageTimer::Next(const char* name)
+{
+    Stop();
+    Start(name);
+}
+
+void DFStageTimer::Start(const char* name)
+{
+    m_name = name;
+    m_start = std::chrono::steady_clock::now();
+    m_cpu = DFThreadCPUTime() + m_profile.m_cpu.Seconds();
+    m_acquired = m_memory.Acquired();
+    m_inpaint = m_profile.m_inpaint.Totals();
+    m_memory.StartStage();
+}
+
+void DFStageTimer::Stop()
+{
+    DFStageProfile::Stage& s = m_profile.Find(m_name);
+    s.calls++;
+    s.wall += std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    s.cpu += DFThreadCPUTime() + m_profile.m_cpu.Seconds() - m_cpu;
+    s.allocated += m_memory.Acquired() - m_acquired;
+    s.peak = std::max(s.peak, uint64_t(m_memory.StagePeak()));
+    s.resident = DFResidentMemory();
+    s.peakResident = DFPeakResidentMemory();
+    s.inpaint += m_profile.m_inpaint.Totals() - m_inpaint;
+}
+
+}	// namespace pcl
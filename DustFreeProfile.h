@@ -0,0 +1,163 @@
+#ifndef __DustFreeProfile_h
+#define __DustFreeProfile_h
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "DustFreeMemory.h"
+#include "DustFreeParallel.h"
+
+namespace pcl
+{
+
+// Counters of the inpainting hot paths. Hole pixels are counted per channel,
+// except by the ray march, which fills all channels at once and counts a pixel
+// that is a hole in any of them once; rays, steps and early exits are only
+// counted by the ray march.
+// Steps are the probes taken by each hole pixel, all channels at once; early
+// exits are the rays of a channel abandoned by the 1% weight cutoff.
+struct DFInpaintCounts
+{
+    uint64_t holePixels = 0;
+    uint64_t raysCast = 0;
+    uint64_t raySteps = 0;
+    uint64_t earlyExits = 0;
+
+    DFInpaintCounts& operator+=(const DFInpaintCounts& x)
+    {
+        holePixels += x.holePixels;
+        raysCast += x.raysCast;
+        raySteps += x.raySteps;
+        earlyExits += x.earlyExits;
+        return *this;
+    }
+
+    DFInpaintCounts operator-(const DFInpaintCounts& x) const
+    {
+        DFInpaintCounts d;
+        d.holePixels = holePixels - x.holePixels;
+        d.raysCast = raysCast - x.raysCast;
+        d.raySteps = raySteps - x.raySteps;
+        d.earlyExits = earlyExits - x.earlyExits;
+        return d;
+    }
+};
+
+// Inpainting counters of a run. The tasks of the kernels count in locals and
+// add them here once each.
+class DFInpaintCounter
+{
+public:
+    void Add(const DFInpaintCounts& counts);
+
+    DFInpaintCounts Totals() const;
+
+private:
+    std::atomic<uint64_t> m_holePixels{ 0 };
+    std::atomic<uint64_t> m_raysCast{ 0 };
+    std::atomic<uint64_t> m_raySteps{ 0 };
+    std::atomic<uint64_t> m_earlyExits{ 0 };
+};
+
+// CPU time used so far by the calling thread, in seconds.
+double DFThreadCPUTime();
+
+// Resident set of the process, and its high water mark, in bytes; zero where
+// the system does not tell.
+size_t DFResidentMemory();
+size_t DFPeakResidentMemory();
+
+// Measurements of the stages of the pipeline over a run. Stages run one after
+// the other, never nested; those of the same name, such as the windows of a
+// tiled run, add up into one record. The CPU time and the inpainting counters
+// are those of the run alone, even while other runs, such as a real-time
+// preview, share the thread pool.
+class DFStageProfile
+{
+public:
+    struct Stage
+    {
+        std::string name;
+        int calls = 0;
+        double wall = 0;            // seconds
+        double cpu = 0;             // CPU seconds of the run, on all threads
+        uint64_t allocated = 0;     // bytes of pipeline buffers acquired
+        uint64_t peak = 0;          // pipeline buffers held at most
+        uint64_t resident = 0;      // process resident set at the end
+        uint64_t peakResident = 0;  // process high water mark at the end
+        DFInpaintCounts inpaint;
+    };
+
+    void Reset()
+    {
+        m_stages.clear();
+    }
+
+    // The counters that the inpainting kernels of the run add to.
+    DFInpaintCounter* InpaintCounter()
+    {
+        return &m_inpaint;
+    }
+
+    const std::vector<Stage>& Stages() const
+    {
+        return m_stages;
+    }
+
+    // The sum of all stages; peaks are the largest ones.
+    Stage Total() const;
+
+    // A fixed-width table of the stages and their total, one line each,
+    // followed by the inpainting counters when there are any.
+    std::string Table() const;
+
+    // A JSON object with the given members, already formatted as
+    // "name": value pairs, followed by the stages and their total.
+    std::string Json(const std::string& members) const;
+
+private:
+    std::vector<Stage> m_stages;
+    DFInpaintCounter m_inpaint;
+    DFCpuAccount m_cpu;
+
+    Stage& Find(const std::string& name);
+
+    friend class DFStageTimer;
+};
+
+// Measures a stage from its construction to its destruction, also when it is
+// left by an exception. Next ends the stage and starts the one that follows.
+class DFStageTimer
+{
+public:
+    DFStageTimer(DFStageProfile& profile, const char* name, DFMemoryLedger& memory);
+    DFStageTimer(const DFStageTimer&) = delete;
+    DFStageTimer& operator=(const DFStageTimer&) = delete;
+    ~DFStageTimer();
+
+    void Next(const char* name);
+
+private:
+    DFStageProfile& m_profile;
+    const char* m_name;
+    DFMemoryLedger& m_memory;
+    DFCpuAccount* m_account;
+    std::chrono::steady_clock::time_point m_start;
+    double m_cpu;
+    size_t m_acquired;
+    DFInpaintCounts m_inpaint;
+
+    void Start(const char* name);
+    void Stop();
+};
+
+// Quotes and escapes a string for JSON.
+std::string DFJsonString(const std::string& s);
+
+}	// namespace pcl
+
+#endif	// __DustFreeProfile_h
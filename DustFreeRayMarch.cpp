@@ -0,0 +1,684 @@
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// The batched marches are compiled for AVX2 and AVX-512 whatever the target of
+// the build, and picked at run time from what the processor supports. GCC and
+// Clang compile each one for its own instruction set; MSVC accepts the
+// intrinsics in any function.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define DF_SIMD_DISPATCH 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define DF_TARGET(isa)
+#else
+#define DF_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+#include "DustFreeInpaint.h"
+#include "DustFreeParallel.h"
+#include "DustFreeProfile.h"
+
+namespace pcl
+{
+
+namespace
+{
+
+// Step sequence of the reference ray march: unit steps up to 16, then a
+// geometric progression j = int(j*1.1f). It does not depend on the image, so
+// it is generated at compile time together with the 1/j weights.
+constexpr int RayStepLimit = 1 << 24;
+
+constexpr int NextRayStep(int j)
+{
+    return (j < 16) ? j + 1 : int(j * 1.1f);
+}
+
+constexpr int CountRaySteps()
+{
+    int n = 0;
+    for (int j = 1; j < RayStepLimit; j = NextRayStep(j))
+        n++;
+    return n;
+}
+
+constexpr int RayStepCount = CountRaySteps();
+
+struct DFRaySteps
+{
+    int j[RayStepCount];
+    float w[RayStepCount];
+};
+
+constexpr DFRaySteps MakeRaySteps()
+{
+    DFRaySteps s = {};
+    int n = 0;
+    for (int j = 1; j < RayStepLimit; j = NextRayStep(j), n++) {
+        s.j[n] = j;
+        s.w[n] = 1.0f / float(j);
+    }
+    return s;
+}
+
+constexpr DFRaySteps RaySteps = MakeRaySteps();
+
+// Per-image ray geometry: the integer displacement of every (ray, step) probe
+// and the matching flat offset in a plane of the given width; Offsets() gives
+// the same table for any other row stride.
+template <int N>
+struct DFRayTable
+{
+    int count;       // steps with j < max(width, height)
+    int start[N];    // odd rays skip the steps with j < 64
+    std::vector<int> dx;
+    std::vector<int> dy;
+    std::vector<ptrdiff_t> offset;
+
+    DFRayTable(int width, int height)
+    {
+        const int distance = std::max(width, height);
+        count = 0;
+        while ((count < RayStepCount) && (RaySteps.j[count] < distance))
+            count++;
+        int oddStart = 0;
+        while ((oddStart < count) && (RaySteps.j[oddStart] < 64))
+            oddStart++;
+
+        dx.resize(size_t(N) * count);
+        dy.resize(size_t(N) * count);
+        for (int i = 0; i < N; i++) {
+            float rad = float(3.141592653589793238462643383279502884L * 2.0f * i / N);
+            float cx = std::cos(rad);
+            float cy = std::sin(rad);
+            start[i] = (i % 2 != 0) ? oddStart : 0;
+            for (int t = 0; t < count; t++) {
+                size_t k = size_t(i) * count + t;
+                dx[k] = int(std::floor(cx * RaySteps.j[t] + 0.5f));
+                dy[k] = int(std::floor(cy * RaySteps.j[t] + 0.5f));
+            }
+        }
+        offset = Offsets(width);
+    }
+
+    std::vector<ptrdiff_t> Offsets(ptrdiff_t stride) const
+    {
+        std::vector<ptrdiff_t> o(dx.size());
+        for (size_t k = 0; k < o.size(); k++)
+            o[k] = dy[k] * stride + dx[k];
+        return o;
+    }
+};
+
+inline int ClampIndex(int i, int n)
+{
+    return (i < 0) ? 0 : ((i >= n) ? n - 1 : i);
+}
+
+inline uint64_t CountBits(unsigned mask)
+{
+    return std::bitset<32>(mask).count();
+}
+
+// Where the probes of a march are read from. The window is a rectangle
+// [wx0, wx1) x [wy0, wy1) of the C input planes stored with its own stride: the
+// whole planes for a global march, or cache-resident copies of a tile and its
+// halo for a tiled one. Probes outside the window read the input planes.
+template <int N, int C, typename T>
+struct DFMarchSource
+{
+    const DFRayTable<N>& rays;
+    const T* input[C];
+    int width;
+    int height;
+    const T* window[C];
+    const ptrdiff_t* windowOffset;
+    ptrdiff_t stride;
+    int wx0, wy0, wx1, wy1;
+
+    DFMarchSource(const DFRayTable<N>& table, const T* const* planes, int w, int h)
+        : rays(table)
+        , width(w)
+        , height(h)
+        , windowOffset(table.offset.data())
+        , stride(w)
+        , wx0(0)
+        , wy0(0)
+        , wx1(w)
+        , wy1(h)
+    {
+        for (int c = 0; c < C; c++)
+            input[c] = window[c] = planes[c];
+    }
+
+    void SetWindow(const T* planes, ptrdiff_t windowStride, const ptrdiff_t* offsets, int x0, int y0, int x1, int y1)
+    {
+        for (int c = 0; c < C; c++)
+            window[c] = planes + c * windowStride * windowStride;
+        windowOffset = offsets;
+        stride = windowStride;
+        wx0 = x0;
+        wy0 = y0;
+        wx1 = x1;
+        wy1 = y1;
+    }
+
+    // The planes holding the samples [x, x+n) of row y, and the offset of the
+    // first one in each plane.
+    const T* const* Locate(int x, int y, int n, ptrdiff_t& offset) const
+    {
+        if ((y >= wy0) && (y < wy1) && (x >= wx0) && (x + n <= wx1)) {
+            offset = (y - wy0) * stride + (x - wx0);
+            return window;
+        }
+        offset = ptrdiff_t(y) * width + x;
+        return input;
+    }
+};
+
+// Scalar kernel: one pixel, marched for the channels where it is a hole. Every
+// ray is walked once for all channels; each channel stops at its own first
+// valid sample, so channels whose holes differ get exactly their own result.
+// Probes within the distance to the nearest window border go through the flat
+// offset table; the rest are clamped. Steps and early exits are added to counts
+// once per pixel.
+template <int N, int C, typename T>
+void RayMarchPixel(const DFMarchSource<N, C, T>& src, T* const* output, int x, int y, DFInpaintCounts& counts)
+{
+    const DFRayTable<N>& rays = src.rays;
+    const int safe = std::min(std::min(x - src.wx0, src.wx1 - 1 - x), std::min(y - src.wy0, src.wy1 - 1 - y));
+    const ptrdiff_t center = (y - src.wy0) * src.stride + (x - src.wx0);
+    const size_t index = size_t(y) * src.width + x;
+
+    unsigned holes = 0;
+    for (int c = 0; c < C; c++)
+        if (!(src.window[c][center] > 0))
+            holes |= 1u << c;
+        else
+            output[c][index] = src.window[c][center];
+    if (holes == 0)
+        return;
+
+    T p[C] = {};
+    float w0[C] = {};
+    uint64_t steps = 0;
+    uint64_t exits = 0;
+    for (int i = 0; i < N; i++) {
+        const size_t k0 = size_t(i) * rays.count;
+        unsigned active = holes;
+        unsigned cut = 0;
+        for (int t = rays.start[i]; t < rays.count; t++) {
+            float w = RaySteps.w[t];
+            const unsigned marching = active;
+            for (int c = 0; c < C; c++)
+                if (w < w0[c] * 0.01f)
+                    active &= ~(1u << c);
+            cut |= marching & ~active;
+            if (active == 0)
+                break;
+            steps++;
+            const T* const* planes = src.window;
+            ptrdiff_t k = center + src.windowOffset[k0 + t];
+            if (RaySteps.j[t] > safe) {
+                planes = src.input;
+                k = ptrdiff_t(ClampIndex(y + rays.dy[k0 + t], src.height)) * src.width + ClampIndex(x + rays.dx[k0 + t], src.width);
+            }
+            for (int c = 0; c < C; c++)
+                if (active & (1u << c)) {
+                    T in = planes[c][k];
+                    if (in == 0)
+                        continue;
+                    p[c] += in * w;
+                    w0[c] += w;
+                    active &= ~(1u << c);
+                }
+        }
+        exits += CountBits(cut);
+    }
+    counts.raySteps += steps;
+    counts.earlyExits += exits;
+    for (int c = 0; c < C; c++)
+        if (holes & (1u << c))
+            output[c][index] = (w0[c] > 0.0f) ? T(p[c] / w0[c]) : T(0);
+}
+
+#if defined(DF_SIMD_DISPATCH)
+
+// Instruction sets the processor and the operating system support.
+DFSimd DetectSimd()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return DFSimd::Scalar;
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0)    // OSXSAVE
+        return DFSimd::Scalar;
+    const unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    if ((info[1] & (1 << 16)) && ((xcr0 & 0xE6) == 0xE6))
+        return DFSimd::AVX512;
+    if ((info[1] & (1 << 5)) && ((xcr0 & 0x6) == 0x6))
+        return DFSimd::AVX2;
+    return DFSimd::Scalar;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return DFSimd::AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return DFSimd::AVX2;
+    return DFSimd::Scalar;
+#endif
+}
+
+std::atomic<int> SimdLimit(int(DFSimd::AVX512));
+
+DFSimd ActiveSimd()
+{
+    static const DFSimd supported = DetectSimd();
+    return DFSimd(std::min(int(supported), SimdLimit.load(std::memory_order_relaxed)));
+}
+
+// 16 adjacent pixels of a row march in lockstep: for a given (ray, step) their
+// probes are 16 consecutive samples of one row unless the row edge clamps them,
+// in which case the samples are gathered. Channels carry their own lane masks.
+// Steps and early exits are counted per lane, and added to counts once.
+template <int N, int C>
+DF_TARGET("avx512f") void RayMarchBatch16(const DFMarchSource<N, C, float>& src, float* const* output, int x0, int y, DFInpaintCounts& counts)
+{
+    const DFRayTable<N>& rays = src.rays;
+    const __m512 zero = _mm512_setzero_ps();
+    const size_t index = size_t(y) * src.width + x0;
+    ptrdiff_t offset;
+    const float* const* planes = src.Locate(x0, y, 16, offset);
+    __m512 in[C];
+    __mmask16 hole[C];
+    __mmask16 anyHole = 0;
+    for (int c = 0; c < C; c++) {
+        in[c] = _mm512_loadu_ps(planes[c] + offset);
+        hole[c] = _mm512_cmp_ps_mask(in[c], zero, _CMP_NGT_UQ);
+        anyHole |= hole[c];
+    }
+    if (anyHole == 0) {
+        for (int c = 0; c < C; c++)
+            _mm512_storeu_ps(output[c] + index, in[c]);
+        return;
+    }
+
+    const __m512i xv = _mm512_add_epi32(_mm512_set1_epi32(x0), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    const __m512i maxX = _mm512_set1_epi32(src.width - 1);
+    const __m512 cutoff = _mm512_set1_ps(0.01f);
+    const __m512i one = _mm512_set1_epi32(1);
+    __m512i steps = _mm512_setzero_si512();
+    __m512i exits = _mm512_setzero_si512();
+    __m512 p[C];
+    __m512 w0[C];
+    for (int c = 0; c < C; c++)
+        p[c] = w0[c] = zero;
+    for (int i = 0; i < N; i++) {
+        const size_t k0 = size_t(i) * rays.count;
+        __mmask16 active[C];
+        for (int c = 0; c < C; c++)
+            active[c] = hole[c];
+        for (int t = rays.start[i]; t < rays.count; t++) {
+            const __m512 w = _mm512_set1_ps(RaySteps.w[t]);
+            __mmask16 live = 0;
+            for (int c = 0; c < C; c++) {
+                const __mmask16 cut = _mm512_mask_cmp_ps_mask(active[c], w, _mm512_mul_ps(w0[c], cutoff), _CMP_LT_OQ);
+                exits = _mm512_mask_add_epi32(exits, cut, exits, one);
+                active[c] &= ~cut;
+                live |= active[c];
+            }
+            if (live == 0)
+                break;
+            steps = _mm512_mask_add_epi32(steps, live, steps, one);
+            const int dx = rays.dx[k0 + t];
+            const int iy = ClampIndex(y + rays.dy[k0 + t], src.height);
+            const bool contiguous = (x0 + dx >= 0) && (x0 + 15 + dx < src.width);
+            const float* const* probePlanes = src.input;
+            ptrdiff_t probeOffset = 0;
+            __m512i ix = _mm512_setzero_si512();
+            if (contiguous)
+                probePlanes = src.Locate(x0 + dx, iy, 16, probeOffset);
+            else
+                ix = _mm512_min_epi32(_mm512_max_epi32(_mm512_add_epi32(xv, _mm512_set1_epi32(dx)), _mm512_setzero_si512()), maxX);
+            for (int c = 0; c < C; c++) {
+                if (active[c] == 0)
+                    continue;
+                const __m512 s = contiguous ? _mm512_loadu_ps(probePlanes[c] + probeOffset)
+                                            : _mm512_mask_i32gather_ps(zero, active[c], ix, src.input[c] + size_t(iy) * src.width, 4);
+                const __mmask16 hit = _mm512_mask_cmp_ps_mask(active[c], s, zero, _CMP_NEQ_UQ);
+                p[c] = _mm512_mask_add_ps(p[c], hit, p[c], _mm512_mul_ps(s, w));
+                w0[c] = _mm512_mask_add_ps(w0[c], hit, w0[c], w);
+                active[c] &= ~hit;
+            }
+        }
+    }
+
+    counts.raySteps += uint64_t(_mm512_reduce_add_epi32(steps));
+    counts.earlyExits += uint64_t(_mm512_reduce_add_epi32(exits));
+    for (int c = 0; c < C; c++) {
+        const __m512 result = _mm512_maskz_div_ps(_mm512_cmp_ps_mask(w0[c], zero, _CMP_GT_OQ), p[c], w0[c]);
+        _mm512_storeu_ps(output[c] + index, _mm512_mask_blend_ps(hole[c], in[c], result));
+    }
+}
+
+// AVX2 version of the lockstep batch: 8 adjacent pixels.
+template <int N, int C>
+DF_TARGET("avx2") void RayMarchBatch8(const DFMarchSource<N, C, float>& src, float* const* output, int x0, int y, DFInpaintCounts& counts)
+{
+    const DFRayTable<N>& rays = src.rays;
+    const __m256 zero = _mm256_setzero_ps();
+    const size_t index = size_t(y) * src.width + x0;
+    ptrdiff_t offset;
+    const float* const* planes = src.Locate(x0, y, 8, offset);
+    __m256 in[C];
+    __m256 hole[C];
+    int anyHole = 0;
+    for (int c = 0; c < C; c++) {
+        in[c] = _mm256_loadu_ps(planes[c] + offset);
+        hole[c] = _mm256_cmp_ps(in[c], zero, _CMP_NGT_UQ);
+        anyHole |= _mm256_movemask_ps(hole[c]);
+    }
+    if (anyHole == 0) {
+        for (int c = 0; c < C; c++)
+            _mm256_storeu_ps(output[c] + index, in[c]);
+        return;
+    }
+
+    const __m256i xv = _mm256_add_epi32(_mm256_set1_epi32(x0), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    const __m256i maxX = _mm256_set1_epi32(src.width - 1);
+    const __m256 cutoff = _mm256_set1_ps(0.01f);
+    __m256i steps = _mm256_setzero_si256();
+    __m256i exits = _mm256_setzero_si256();
+    __m256 p[C];
+    __m256 w0[C];
+    for (int c = 0; c < C; c++)
+        p[c] = w0[c] = zero;
+    for (int i = 0; i < N; i++) {
+        const size_t k0 = size_t(i) * rays.count;
+        __m256 active[C];
+        for (int c = 0; c < C; c++)
+            active[c] = hole[c];
+        for (int t = rays.start[i]; t < rays.count; t++) {
+            const __m256 w = _mm256_set1_ps(RaySteps.w[t]);
+            __m256 live = zero;
+            for (int c = 0; c < C; c++) {
+                const __m256 cut = _mm256_and_ps(_mm256_cmp_ps(w, _mm256_mul_ps(w0[c], cutoff), _CMP_LT_OQ), active[c]);
+                // Lanes of a mask are all ones, minus one as integers.
+                exits = _mm256_sub_epi32(exits, _mm256_castps_si256(cut));
+                active[c] = _mm256_andnot_ps(cut, active[c]);
+                live = _mm256_or_ps(live, active[c]);
+            }
+            if (_mm256_movemask_ps(live) == 0)
+                break;
+            steps = _mm256_sub_epi32(steps, _mm256_castps_si256(live));
+            const int dx = rays.dx[k0 + t];
+            const int iy = ClampIndex(y + rays.dy[k0 + t], src.height);
+            const bool contiguous = (x0 + dx >= 0) && (x0 + 7 + dx < src.width);
+            const float* const* probePlanes = src.input;
+            ptrdiff_t probeOffset = 0;
+            __m256i ix = _mm256_setzero_si256();
+            if (contiguous)
+                probePlanes = src.Locate(x0 + dx, iy, 8, probeOffset);
+            else
+                ix = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(xv, _mm256_set1_epi32(dx)), _mm256_setzero_si256()), maxX);
+            for (int c = 0; c < C; c++) {
+                if (_mm256_movemask_ps(active[c]) == 0)
+                    continue;
+                const __m256 s = contiguous ? _mm256_loadu_ps(probePlanes[c] + probeOffset)
+                                            : _mm256_mask_i32gather_ps(zero, src.input[c] + size_t(iy) * src.width, ix, active[c], 4);
+                const __m256 hit = _mm256_and_ps(active[c], _mm256_cmp_ps(s, zero, _CMP_NEQ_UQ));
+                p[c] = _mm256_add_ps(p[c], _mm256_and_ps(hit, _mm256_mul_ps(s, w)));
+                w0[c] = _mm256_add_ps(w0[c], _mm256_and_ps(hit, w));
+                active[c] = _mm256_andnot_ps(hit, active[c]);
+            }
+        }
+    }
+
+    alignas(32) int32_t lanes[2][8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[0]), steps);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes[1]), exits);
+    for (int i = 0; i < 8; i++) {
+        counts.raySteps += uint64_t(lanes[0][i]);
+        counts.earlyExits += uint64_t(lanes[1][i]);
+    }
+    for (int c = 0; c < C; c++) {
+        const __m256 result = _mm256_and_ps(_mm256_cmp_ps(w0[c], zero, _CMP_GT_OQ), _mm256_div_ps(p[c], w0[c]));
+        _mm256_storeu_ps(output[c] + index, _mm256_blendv_ps(in[c], result, hole[c]));
+    }
+}
+
+#else
+
+DFSimd ActiveSimd()
+{
+    return DFSimd::Scalar;
+}
+
+#endif	// DF_SIMD_DISPATCH
+
+template <int N, int C, typename T>
+int RayMarchSegmentBatched(const DFMarchSource<N, C, T>&, T* const*, int x0, int, int, DFInpaintCounts&)
+{
+    return x0;
+}
+
+template <int N, int C>
+int RayMarchSegmentBatched(const DFMarchSource<N, C, float>& src, float* const* output, int x0, int x1, int y,
+    DFInpaintCounts& counts)
+{
+    int x = x0;
+#if defined(DF_SIMD_DISPATCH)
+    const DFSimd simd = ActiveSimd();
+    if (simd == DFSimd::AVX512)
+        for (; x + 16 <= x1; x += 16)
+            RayMarchBatch16<N, C>(src, output, x, y, counts);
+    if (simd != DFSimd::Scalar)
+        for (; x + 8 <= x1; x += 8)
+            RayMarchBatch8<N, C>(src, output, x, y, counts);
+#endif
+    return x;
+}
+
+// Marches the pixels [x0, x1) of row y.
+template <int N, int C, typename T>
+void RayMarchSegment(const DFMarchSource<N, C, T>& src, T* const* output, int x0, int x1, int y, DFInpaintCounts& counts)
+{
+    for (int x = RayMarchSegmentBatched<N, C>(src, output, x0, x1, y, counts); x < x1; x++)
+        RayMarchPixel<N, C>(src, output, x, y, counts);
+}
+
+// Longest run of holes along any row or column, a cheap bound for the distance
+// most rays travel before they meet a valid sample.
+inline int LongestHoleRun(const DFHoleSpans& holes)
+{
+    std::vector<int> lastRow(holes.width, -2);
+    std::vector<int> column(holes.width, 0);
+    int longest = 0;
+    for (int y = 0; y < holes.height; y++)
+        for (const DFHoleSpans::Span* s = holes.RowBegin(y); s != holes.RowEnd(y); s++) {
+            longest = std::max(longest, int(s->x1 - s->x0));
+            for (int x = s->x0; x < s->x1; x++) {
+                column[x] = (lastRow[x] == y - 1) ? column[x] + 1 : 1;
+                lastRow[x] = y;
+                longest = std::max(longest, column[x]);
+            }
+        }
+    return longest;
+}
+
+// Rows are distributed by their number of holes: valid pixels have already
+// been copied to the output, so only the hole spans are marched.
+template <int N, int C, typename T>
+void RayMarchGlobal(const T* const* input, T* const* output, int width, int height, const DFRayTable<N>& rays, const DFHoleSpans& holes,
+    DFInpaintCounter* counter)
+{
+    const DFMarchSource<N, C, T> src(rays, input, width, height);
+    std::vector<uint64_t> cost(height);
+    for (int y = 0; y < height; y++)
+        for (const DFHoleSpans::Span* s = holes.RowBegin(y); s != holes.RowEnd(y); s++)
+            cost[y] += uint64_t(s->x1 - s->x0);
+    const std::vector<int> ranges = DFBalancedRanges(cost, 4 * DFParallelThreadCount());
+    DFParallelFor(int(ranges.size()) - 1, [&](int begin, int end) {
+        DFInpaintCounts counts;
+        for (int r = begin; r < end; r++)
+            for (int y = ranges[r]; y < ranges[r + 1]; y++)
+                for (const DFHoleSpans::Span* s = holes.RowBegin(y); s != holes.RowEnd(y); s++)
+                    RayMarchSegment<N, C>(src, output, s->x0, s->x1, y, counts);
+        if (counter != nullptr)
+            counter->Add(counts);
+    });
+}
+
+// Tiles of TileSize x TileSize pixels are marched against private copies of the
+// tile plus a halo wide enough for the first probes of every ray and the
+// longest hole run, capped to keep the copies cache-resident. Tiles are
+// distributed by their number of holes; those without holes are skipped, since
+// valid pixels have already been copied to the output.
+template <int N, int C, typename T>
+void RayMarchTiled(const T* const* input, T* const* output, int width, int height, const DFRayTable<N>& rays, const DFHoleSpans& holes,
+    DFInpaintCounter* counter)
+{
+    const int TileSize = 128;
+    const int MaxHalo = 128;
+
+    int firstOddStep = 1;
+    for (int t = 0; t < rays.count; t++)
+        if (RaySteps.j[t] >= 64) {
+            firstOddStep = RaySteps.j[t];
+            break;
+        }
+    const int halo = std::min(std::max(firstOddStep, LongestHoleRun(holes)) + 1, MaxHalo);
+    const ptrdiff_t stride = TileSize + 2 * halo;
+    const std::vector<ptrdiff_t> windowOffset = rays.Offsets(stride);
+
+    const int tilesX = (width + TileSize - 1) / TileSize;
+    const int tilesY = (height + TileSize - 1) / TileSize;
+    std::vector<uint64_t> cost(size_t(tilesX) * tilesY);
+    for (int y = 0; y < height; y++)
+        for (const DFHoleSpans::Span* s = holes.RowBegin(y); s != holes.RowEnd(y); s++)
+            for (int x = s->x0; x < s->x1;) {
+                int x1 = std::min(int(s->x1), (x / TileSize + 1) * TileSize);
+                cost[size_t(y / TileSize) * tilesX + x / TileSize] += uint64_t(x1 - x);
+                x = x1;
+            }
+
+    const std::vector<int> ranges = DFBalancedRanges(cost, 4 * DFParallelThreadCount());
+    DFParallelFor(int(ranges.size()) - 1, [&](int begin, int end) {
+        std::vector<T> window;
+        DFMarchSource<N, C, T> src(rays, input, width, height);
+        DFInpaintCounts counts;
+        for (int tile = ranges[begin]; tile < ranges[end]; tile++) {
+            if (cost[tile] == 0)
+                continue;
+            const int tx0 = (tile % tilesX) * TileSize;
+            const int ty0 = (tile / tilesX) * TileSize;
+            const int tx1 = std::min(tx0 + TileSize, width);
+            const int ty1 = std::min(ty0 + TileSize, height);
+
+            const int wx0 = std::max(tx0 - halo, 0);
+            const int wy0 = std::max(ty0 - halo, 0);
+            const int wx1 = std::min(tx1 + halo, width);
+            const int wy1 = std::min(ty1 + halo, height);
+            window.resize(size_t(C) * stride * stride);
+            for (int c = 0; c < C; c++)
+                for (int y = wy0; y < wy1; y++)
+                    std::copy(input[c] + size_t(y) * width + wx0, input[c] + size_t(y) * width + wx1,
+                        window.data() + c * stride * stride + (y - wy0) * stride);
+
+            src.SetWindow(window.data(), stride, windowOffset.data(), wx0, wy0, wx1, wy1);
+            for (int y = ty0; y < ty1; y++) {
+                const DFHoleSpans::Span* s = std::lower_bound(holes.RowBegin(y), holes.RowEnd(y), tx0,
+                    [](const DFHoleSpans::Span& a, int x) { return a.x1 <= x; });
+                for (; (s != holes.RowEnd(y)) && (s->x0 < tx1); s++)
+                    RayMarchSegment<N, C>(src, output, std::max(int(s->x0), tx0), std::min(int(s->x1), tx1), y, counts);
+            }
+        }
+        if (counter != nullptr)
+            counter->Add(counts);
+    });
+}
+
+template <int C, typename T>
+void RayMarchChannels(const T* const* input, T* const* output, int width, int height, bool tiled, DFInpaintCounter* counter)
+{
+    DFParallelFor(height, [&](int begin, int end) {
+        for (int c = 0; c < C; c++)
+            std::copy(input[c] + size_t(begin) * width, input[c] + size_t(end) * width, output[c] + size_t(begin) * width);
+    }, 16);
+
+    DFHoleSpans holes;
+    holes.Build(input, C, width, height);
+    if (holes.holes == 0)
+        return;
+
+    if (counter != nullptr) {
+        DFInpaintCounts counts;
+        counts.holePixels = holes.holes;
+        counts.raysCast = uint64_t(holes.holes) * 32;
+        counter->Add(counts);
+    }
+
+    const DFRayTable<32> rays(width, height);
+    if (tiled)
+        RayMarchTiled<32, C>(input, output, width, height, rays, holes, counter);
+    else
+        RayMarchGlobal<32, C>(input, output, width, height, rays, holes, counter);
+}
+
+}	// namespace
+
+DFSimd DFRayMarchSimd()
+{
+    return ActiveSimd();
+}
+
+void DFLimitRayMarchSimd(DFSimd limit)
+{
+    SimdLimit.store(int(limit), std::memory_order_relaxed);
+}
+
+template <typename T>
+void DFInpaintRayMarch(const T* const* input, T* const* output, int channels, int width, int height, bool tiled,
+    DFInpaintCounter* counter)
+{
+    switch (channels) {
+    case 1:
+        RayMarchChannels<1>(input, output, width, height, tiled, counter);
+        break;
+    case 2:
+        RayMarchChannels<2>(input, output, width, height, tiled, counter);
+        break;
+    case 3:
+        RayMarchChannels<3>(input, output, width, height, tiled, counter);
+        break;
+    case 4:
+        RayMarchChannels<4>(input, output, width, height, tiled, counter);
+        break;
+    default:
+        for (int c = 0; c < channels; c++)
+            RayMarchChannels<1>(input + c, output + c, width, height, tiled, counter);
+        break;
+    }
+}
+
+template <typename T>
+void DFInpaintRayMarch(const T* input, T* output, int width, int height, bool tiled, DFInpaintCounter* counter)
+{
+    DFInpaintRayMarch(&input, &output, 1, width, height, tiled, counter);
+}
+
+template void DFInpaintRayMarch<float>(const float* const*, float* const*, int, int, int, bool, DFInpaintCounter*);
+template void DFInpaintRayMarch<double>(const double* const*, double* const*, int, int, int, bool, DFInpaintCounter*);
+template void DFInpaintRayMarch<float>(const float*, float*, int, int, bool, DFInpaintCounter*);
+template void DFInpaintRayMarch<double>(const double*, double*, int, int, bool, DFInpaintCounter*);
+
+}	// namespace pcl
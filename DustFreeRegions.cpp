@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cstdint>
+
+#include "DustFreeRegions.h"
+
+namespace pcl
+{
+
+namespace
+{
+
+struct DFRun
+{
+    int x0;
+    int x1;
+    int y;
+    int32_t parent;
+};
+
+int32_t FindRoot(std::vector<DFRun>& runs, int32_t i)
+{
+    while (runs[i].parent != i) {
+        runs[i].parent = runs[runs[i].parent].parent;
+        i = runs[i].parent;
+    }
+    return i;
+}
+
+}	// namespace
+
+template <typename T>
+std::vector<DFRect> DFComponentBounds(const T* const* planes, int channels, int width, int height, T threshold)
+{
+    std::vector<DFRun> runs;
+    size_t previous = 0;    // first run of the previous row
+    for (int y = 0; y < height; y++) {
+        const size_t row = size_t(y) * width;
+        auto isSet = [&](int x) {
+            for (int c = 0; c < channels; c++)
+                if (planes[c][row + x] >= threshold)
+                    return true;
+            return false;
+        };
+
+        const size_t current = runs.size();
+        size_t p = previous;
+        for (int x = 0; x < width;) {
+            if (!isSet(x)) {
+                x++;
+                continue;
+            }
+            DFRun r;
+            r.x0 = x;
+            while ((x < width) && isSet(x))
+                x++;
+            r.x1 = x;
+            r.y = y;
+            r.parent = int32_t(runs.size());
+            runs.push_back(r);
+
+            // Runs of the previous row touching this one, diagonals included.
+            while ((p < current) && (runs[p].x1 < r.x0))
+                p++;
+            for (size_t q = p; (q < current) && (runs[q].x0 <= r.x1); q++) {
+                int32_t a = FindRoot(runs, int32_t(q));
+                int32_t b = FindRoot(runs, int32_t(runs.size() - 1));
+                if (a != b)
+                    runs[std::max(a, b)].parent = std::min(a, b);
+            }
+        }
+        previous = current;
+    }
+
+    std::vector<int32_t> box(runs.size(), -1);
+    std::vector<DFRect> bounds;
+    for (size_t i = 0; i < runs.size(); i++) {
+        int32_t root = FindRoot(runs, int32_t(i));
+        if (box[root] < 0) {
+            box[root] = int32_t(bounds.size());
+            bounds.push_back(DFRect{ runs[i].x0, runs[i].y, runs[i].x1, runs[i].y + 1 });
+        }
+        DFRect& b = bounds[box[root]];
+        b.x0 = std::min(b.x0, runs[i].x0);
+        b.x1 = std::max(b.x1, runs[i].x1);
+        b.y1 = std::max(b.y1, runs[i].y + 1);
+    }
+    return bounds;
+}
+
+std::vector<DFRect> DFGrowRegions(const std::vector<DFRect>& boxes, const std::vector<int>& margins, int width, int height)
+{
+    std::vector<DFRect> regions;
+    for (size_t i = 0; i < boxes.size(); i++) {
+        const int m = margins[i];
+        regions.push_back(DFRect{ std::max(boxes[i].x0 - m, 0), std::max(boxes[i].y0 - m, 0),
+                                  std::min(boxes[i].x1 + m, width), std::min(boxes[i].y1 + m, height) });
+    }
+
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (size_t i = 0; i < regions.size(); i++)
+            for (size_t j = i + 1; j < regions.size();)
+                if (regions[i].Intersects(regions[j])) {
+                    regions[i].x0 = std::min(regions[i].x0, regions[j].x0);
+                    regions[i].y0 = std::min(regions[i].y0, regions[j].y0);
+                    regions[i].x1 = std::max(regions[i].x1, regions[j].x1);
+                    regions[i].y1 = std::max(regions[i].y1, regions[j].y1);
+                    regions.erase(regions.begin() + j);
+                    merged = true;
+                } else
+                    j++;
+    }
+    return regions;
+}
+
+template std::vector<DFRect> DFComponentBounds<float>(const float* const*, int, int, int, float);
+template std::vector<DFRect> DFComponentBounds<double>(const double* const*, int, int, int, double);
+
+}	// namespace pcl
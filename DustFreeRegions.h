@@ -0,0 +1,45 @@
+#ifndef __DustFreeRegions_h
+#define __DustFreeRegions_h
+
+#include <vector>
+
+namespace pcl
+{
+
+// Pixel rectangle [x0, x1) x [y0, y1).
+struct DFRect
+{
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+
+    int Width() const
+    {
+        return x1 - x0;
+    }
+
+    int Height() const
+    {
+        return y1 - y0;
+    }
+
+    bool Intersects(const DFRect& r) const
+    {
+        return (x0 < r.x1) && (r.x0 < x1) && (y0 < r.y1) && (r.y0 < y1);
+    }
+};
+
+// Bounding boxes of the 8-connected components of the pixels where any of the
+// channel planes is greater than or equal to threshold. Components are found
+// with a union-find over the runs of each row, in a single pass.
+template <typename T>
+std::vector<DFRect> DFComponentBounds(const T* const* planes, int channels, int width, int height, T threshold);
+
+// Grows each box by its margin, clips it to the image and merges the boxes that
+// overlap, until no two of the returned boxes intersect.
+std::vector<DFRect> DFGrowRegions(const std::vector<DFRect>& boxes, const std::vector<int>& margins, int width, int height);
+
+}	// namespace pcl
+
+#endif	// __DustFreeRegions_h
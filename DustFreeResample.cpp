@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "DustFreeParallel.h"
+#include "DustFreeResample.h"
+
+namespace pcl
+{
+
+namespace
+{
+
+struct DFSplineTaps
+{
+    int index[4];
+    double weight[4];
+};
+
+// Taps of the cubic B-spline centered on each of the n output samples, mapped
+// onto sourceN input samples; indices are clamped at the borders.
+std::vector<DFSplineTaps> SplineTaps(int n, int sourceN)
+{
+    std::vector<DFSplineTaps> taps(n);
+    const double scale = double(sourceN) / n;
+    for (int i = 0; i < n; i++) {
+        double s = (i + 0.5) * scale - 0.5;
+        int i0 = int(std::floor(s));
+        double f = s - i0;
+        double g = 1 - f;
+        DFSplineTaps& t = taps[i];
+        t.weight[0] = g * g * g / 6;
+        t.weight[1] = (4 - 6 * f * f + 3 * f * f * f) / 6;
+        t.weight[2] = (4 - 6 * g * g + 3 * g * g * g) / 6;
+        t.weight[3] = f * f * f / 6;
+        for (int k = 0; k < 4; k++)
+            t.index[k] = std::min(std::max(i0 - 1 + k, 0), sourceN - 1);
+    }
+    return taps;
+}
+
+// Scale of the samples of a type: integers hold [0,1] over their whole range.
+template <typename T>
+constexpr double SampleScale()
+{
+    return std::is_integral<T>::value ? double(std::numeric_limits<T>::max()) : 1.0;
+}
+
+template <typename T>
+inline void AddSample(T& target, double value)
+{
+    if (std::is_integral<T>::value) {
+        const double v = std::floor(target + value * SampleScale<T>() + 0.5);
+        target = T(std::min(std::max(v, 0.0), SampleScale<T>()));
+    } else
+        target += T(value);
+}
+
+}	// namespace
+
+template <typename S, typename T>
+void DFAddUpsampled(const S* source, int sourceWidth, int sourceHeight, T* target, int width, int height)
+{
+    if ((sourceWidth == width) && (sourceHeight == height)) {
+        DFParallelFor(height, [&](int begin, int end) {
+            for (size_t i = size_t(begin) * width, n = size_t(end) * width; i < n; i++)
+                AddSample(target[i], source[i]);
+        }, 16);
+        return;
+    }
+
+    const std::vector<DFSplineTaps> columns = SplineTaps(width, sourceWidth);
+    const std::vector<DFSplineTaps> rows = SplineTaps(height, sourceHeight);
+    DFParallelFor(height, [&](int begin, int end) {
+        std::vector<double> row(sourceWidth);
+        for (int y = begin; y < end; y++) {
+            const DFSplineTaps& ty = rows[y];
+            const S* r0 = source + size_t(ty.index[0]) * sourceWidth;
+            const S* r1 = source + size_t(ty.index[1]) * sourceWidth;
+            const S* r2 = source + size_t(ty.index[2]) * sourceWidth;
+            const S* r3 = source + size_t(ty.index[3]) * sourceWidth;
+            for (int x = 0; x < sourceWidth; x++)
+                row[x] = ty.weight[0] * r0[x] + ty.weight[1] * r1[x] + ty.weight[2] * r2[x] + ty.weight[3] * r3[x];
+
+            T* out = target + size_t(y) * width;
+            for (int x = 0; x < width; x++) {
+                const DFSplineTaps& tx = columns[x];
+                AddSample(out[x], tx.weight[0] * row[tx.index[0]] + tx.weight[1] * row[tx.index[1]]
+                                + tx.weight[2] * row[tx.index[2]] + tx.weight[3] * row[tx.index[3]]);
+            }
+        }
+    }, 16);
+}
+
+template <typename S, typename T>
+void DFDownsample(const S* source, int width, int height, int factor, T* target)
+{
+    const int w = DFDownsampledSize(width, factor);
+    const int h = DFDownsampledSize(height, factor);
+    const int bw = std::min(factor, width);
+    const int bh = std::min(factor, height);
+    const double scale = 1 / (SampleScale<S>() * bw * bh);
+    DFParallelFor(h, [&](int begin, int end) {
+        std::vector<double> row(w);
+        for (int y = begin; y < end; y++) {
+            std::fill(row.begin(), row.end(), 0.0);
+            for (int i = 0; i < bh; i++) {
+                const S* in = source + size_t(y * factor + i) * width;
+                for (int x = 0; x < w; x++, in += factor)
+                    for (int j = 0; j < bw; j++)
+                        row[x] += in[j];
+            }
+            T* out = target + size_t(y) * w;
+            for (int x = 0; x < w; x++)
+                out[x] = T(row[x] * scale);
+        }
+    }, 16);
+}
+
+template void DFAddUpsampled<float, float>(const float*, int, int, float*, int, int);
+template void DFAddUpsampled<float, double>(const float*, int, int, double*, int, int);
+template void DFAddUpsampled<float, uint8_t>(const float*, int, int, uint8_t*, int, int);
+template void DFAddUpsampled<float, uint16_t>(const float*, int, int, uint16_t*, int, int);
+template void DFAddUpsampled<float, uint32_t>(const float*, int, int, uint32_t*, int, int);
+template void DFAddUpsampled<double, float>(const double*, int, int, float*, int, int);
+template void DFAddUpsampled<double, double>(const double*, int, int, double*, int, int);
+template void DFAddUpsampled<double, uint8_t>(const double*, int, int, uint8_t*, int, int);
+template void DFAddUpsampled<double, uint16_t>(const double*, int, int, uint16_t*, int, int);
+template void DFAddUpsampled<double, uint32_t>(const double*, int, int, uint32_t*, int, int);
+template void DFDownsample<double, float>(const double*, int, int, int, float*);
+template void DFDownsample<uint8_t, float>(const uint8_t*, int, int, int, float*);
+template void DFDownsample<uint16_t, float>(const uint16_t*, int, int, int, float*);
+template void DFDownsample<uint32_t, float>(const uint32_t*, int, int, int, float*);
+
+}	// namespace pcl
@@ -0,0 +1,31 @@
+#ifndef __DustFreeResample_h
+#define __DustFreeResample_h
+
+namespace pcl
+{
+
+// Adds the cubic B-spline upsampling of a sourceWidth x sourceHeight plane to a
+// width x height plane, one output row at a time, so the upsampled plane is
+// never stored. Pixel centers are aligned, matching the block averages of an
+// integer downsampling. Planes of the same size are simply added. An integer
+// target holds its range as [0,1]: the sums are rounded and clipped to it.
+template <typename S, typename T>
+void DFAddUpsampled(const S* source, int sourceWidth, int sourceHeight, T* target, int width, int height);
+
+// Averages factor x factor blocks of a width x height plane into a plane of
+// DFDownsampledSize(width, factor) x DFDownsampledSize(height, factor)
+// samples, as an integer downsampling does; samples left over at the right
+// and bottom borders are dropped. Integer samples are normalized to [0,1], so
+// an integer or a 64-bit image goes to its single precision working copy in a
+// single pass.
+template <typename S, typename T>
+void DFDownsample(const S* source, int width, int height, int factor, T* target);
+
+inline int DFDownsampledSize(int size, int factor)
+{
+    return (size / factor > 1) ? size / factor : 1;
+}
+
+}	// namespace pcl
+
+#endif	// __DustFreeResample_h
@@ -0,0 +1,105 @@
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cstdlib>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "DustFreeScratch.h"
+
+namespace pcl
+{
+
+#ifdef _WIN32
+
+bool DFScratchFile::Create(size_t bytes)
+{
+    Close();
+    if (bytes == 0)
+        return false;
+
+    char directory[MAX_PATH + 1];
+    char path[MAX_PATH + 1];
+    if ((GetTempPathA(MAX_PATH + 1, directory) == 0) || (GetTempFileNameA(directory, "dfs", 0, path) == 0))
+        return false;
+    // GetTempFileNameA has created the file; it is only deleted on close once
+    // it is open with FILE_FLAG_DELETE_ON_CLOSE.
+    HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        DeleteFileA(path);
+        return false;
+    }
+    m_file = file;
+    const unsigned long long size = bytes;
+    m_mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, DWORD(size >> 32), DWORD(size & 0xffffffff), nullptr);
+    if (m_mapping != nullptr)
+        m_data = MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (m_data == nullptr) {
+        Close();
+        return false;
+    }
+    m_size = bytes;
+    return true;
+}
+
+void DFScratchFile::Close()
+{
+    if (m_data != nullptr)
+        UnmapViewOfFile(m_data);
+    if (m_mapping != nullptr)
+        CloseHandle(m_mapping);
+    if (m_file != nullptr)
+        CloseHandle(m_file);
+    m_file = m_mapping = m_data = nullptr;
+    m_size = 0;
+}
+
+#else
+
+bool DFScratchFile::Create(size_t bytes)
+{
+    Close();
+    if (bytes == 0)
+        return false;
+
+    // The file is unlinked as soon as it is open: it goes away with the
+    // mapping even if the process dies.
+    const char* directory = std::getenv("TMPDIR");
+    std::string path = std::string((directory != nullptr && *directory != '\0') ? directory : "/tmp") + "/DustFree-XXXXXX";
+    m_fd = mkstemp(&path[0]);
+    if (m_fd < 0)
+        return false;
+    unlink(path.c_str());
+    if (ftruncate(m_fd, off_t(bytes)) != 0) {
+        Close();
+        return false;
+    }
+    void* data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED) {
+        Close();
+        return false;
+    }
+    m_data = data;
+    m_size = bytes;
+    return true;
+}
+
+void DFScratchFile::Close()
+{
+    if (m_data != nullptr)
+        munmap(m_data, m_size);
+    if (m_fd >= 0)
+        close(m_fd);
+    m_fd = -1;
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
+
+}	// namespace pcl
@@ -0,0 +1,54 @@
+#ifndef __DustFreeScratch_h
+#define __DustFreeScratch_h
+
+#include <cstddef>
+
+namespace pcl
+{
+
+// A temporary file mapped into memory, for intermediate buffers too large to
+// be held in RAM. The system pages the mapping in and out as it is accessed,
+// so only the parts in use take physical memory. The file lives in the
+// temporary directory of the system and is deleted when it is closed.
+class DFScratchFile
+{
+public:
+    DFScratchFile() = default;
+    DFScratchFile(const DFScratchFile&) = delete;
+    DFScratchFile& operator=(const DFScratchFile&) = delete;
+
+    ~DFScratchFile()
+    {
+        Close();
+    }
+
+    // Creates and maps a zero-filled file of the given size, closing any
+    // previous one. Returns false if the file cannot be created or mapped.
+    bool Create(size_t bytes);
+
+    void Close();
+
+    void* Data() const
+    {
+        return m_data;
+    }
+
+    size_t Size() const
+    {
+        return m_size;
+    }
+
+private:
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+    void* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+}	// namespace pcl
+
+#endif	// __DustFreeScratch_h
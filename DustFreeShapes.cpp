@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <cmath>
+#include <locale>
+#include <sstream>
+#include <string>
+
+#include "DustFreeShapes.h"
+
+namespace pcl
+{
+
+namespace
+{
+
+// The ellipse of a shape as the quadratic form a dx^2 + b dx dy + c dy^2 of
+// the offsets from its center, which is the square of the distance along the
+// major axis to the ellipse through the point.
+struct DFEllipse
+{
+    double a;
+    double b;
+    double c;
+    double outer;   // squared radii, feathered
+    double inner;
+    double halfWidth;
+    double halfHeight;
+};
+
+DFEllipse Ellipse(const DFDustShape& shape)
+{
+    const double theta = shape.angle * 3.14159265358979323846 / 180;
+    const double cs = std::cos(theta);
+    const double sn = std::sin(theta);
+    const double q = std::max(std::min(shape.axisRatio, 1.0), DFMinimumAxisRatio);
+    const double k = 1 / (q * q);
+    const double outer = std::max(shape.radius + shape.feather / 2, 0.0);
+    const double inner = (shape.innerRadius > 0) ? std::max(shape.innerRadius - shape.feather / 2, 0.0) : 0.0;
+    DFEllipse e;
+    e.a = cs * cs + k * sn * sn;
+    e.b = 2 * cs * sn * (1 - k);
+    e.c = sn * sn + k * cs * cs;
+    e.outer = outer * outer;
+    e.inner = inner * inner;
+    e.halfWidth = outer * std::sqrt(cs * cs + q * q * sn * sn);
+    e.halfHeight = outer * std::sqrt(sn * sn + q * q * cs * cs);
+    return e;
+}
+
+// Offsets dx from the center, at row offset dy, inside the ellipse of squared
+// radius r2; false if the row misses it.
+bool RowInterval(const DFEllipse& e, double r2, double dy, double& lo, double& hi)
+{
+    const double b = e.b * dy;
+    const double d = b * b - 4 * e.a * (e.c * dy * dy - r2);
+    if (d < 0)
+        return false;
+    const double s = std::sqrt(d);
+    lo = (-b - s) / (2 * e.a);
+    hi = (-b + s) / (2 * e.a);
+    return true;
+}
+
+void SetSpan(DFBitMask& mask, int y, int x0, int x1)
+{
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, mask.Width());
+    if (x0 >= x1)
+        return;
+    uint64_t* row = mask.Row(y);
+    const int w0 = x0 >> 6;
+    const int w1 = (x1 - 1) >> 6;
+    const uint64_t first = ~uint64_t(0) << (x0 & 63);
+    const uint64_t last = ~uint64_t(0) >> (63 - ((x1 - 1) & 63));
+    if (w0 == w1) {
+        row[w0] |= first & last;
+        return;
+    }
+    row[w0] |= first;
+    for (int k = w0 + 1; k < w1; k++)
+        row[k] = ~uint64_t(0);
+    row[w1] |= last;
+}
+
+}	// namespace
+
+void DFRasterizeShapes(const DFDustShape* shapes, size_t count, double x0, double y0, double scale, DFBitMask& mask)
+{
+    for (size_t n = 0; n < count; n++) {
+        const DFDustShape& shape = shapes[n];
+        const DFEllipse e = Ellipse(shape);
+        if (e.outer <= 0)
+            continue;
+
+        // Mask pixel i has its center at x0 + (i + 0.5)*scale: the pixels whose
+        // centers fall in [lo, hi] run from first(lo) to last(hi).
+        auto first = [&](double v, double origin) { return int(std::ceil((v - origin) / scale - 0.5)); };
+        auto last = [&](double v, double origin) { return int(std::floor((v - origin) / scale - 0.5)); };
+        const int j0 = std::max(first(shape.y - e.halfHeight, y0), 0);
+        const int j1 = std::min(last(shape.y + e.halfHeight, y0), mask.Height() - 1);
+        for (int j = j0; j <= j1; j++) {
+            const double dy = y0 + (j + 0.5) * scale - shape.y;
+            double lo, hi;
+            if (!RowInterval(e, e.outer, dy, lo, hi))
+                continue;
+            const int i0 = first(shape.x + lo, x0);
+            const int i1 = last(shape.x + hi, x0) + 1;
+            double holeLo, holeHi;
+            if ((e.inner > 0) && RowInterval(e, e.inner, dy, holeLo, holeHi)) {
+                // Pixels strictly inside the hole are left out.
+                const int h0 = int(std::floor((shape.x + holeLo - x0) / scale - 0.5)) + 1;
+                const int h1 = int(std::ceil((shape.x + holeHi - x0) / scale - 0.5));
+                SetSpan(mask, j, i0, std::min(i1, h0));
+                SetSpan(mask, j, std::max(i0, h1), i1);
+            } else
+                SetSpan(mask, j, i0, i1);
+        }
+    }
+}
+
+DFRect DFShapeBounds(const DFDustShape& shape)
+{
+    const DFEllipse e = Ellipse(shape);
+    return DFRect{ int(std::floor(shape.x - e.halfWidth)), int(std::floor(shape.y - e.halfHeight)),
+                   int(std::ceil(shape.x + e.halfWidth)) + 1, int(std::ceil(shape.y + e.halfHeight)) + 1 };
+}
+
+std::vector<DFRect> DFShapeComponents(const DFDustShape* shapes, size_t count, int x0, int y0, int width, int height)
+{
+    std::vector<DFRect> components;
+    for (size_t n = 0; n < count; n++) {
+        const DFRect b = DFShapeBounds(shapes[n]);
+        const DFRect clipped{ std::max(b.x0 - x0, 0), std::max(b.y0 - y0, 0), std::min(b.x1 - x0, width), std::min(b.y1 - y0, height) };
+        if ((clipped.Width() > 0) && (clipped.Height() > 0))
+            components.push_back(clipped);
+    }
+    return components;
+}
+
+int DFParseShapes(const char* text, size_t length, std::vector<DFDustShape>& shapes)
+{
+    std::istringstream lines(std::string(text, length));
+    std::string line;
+    for (int n = 1; std::getline(lines, line); n++) {
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream fields(line);
+        fields.imbue(std::locale::classic());
+        double v[7];
+        int count = 0;
+        std::string first;
+        if (!(fields >> first) || (first[0] == '#'))
+            continue;
+        fields.seekg(0);
+        while ((count < 7) && (fields >> v[count]))
+            count++;
+        if ((count < 3) || !(fields >> std::ws).eof())
+            return n;
+        DFDustShape shape;
+        shape.x = v[0];
+        shape.y = v[1];
+        shape.radius = v[2];
+        if (count > 3)
+            shape.innerRadius = v[3];
+        if (count > 4)
+            shape.axisRatio = v[4];
+        if (count > 5)
+            shape.angle = v[5];
+        if (count > 6)
+            shape.feather = v[6];
+        if (!(shape.radius >= 0) || !(shape.innerRadius >= 0) || ((shape.innerRadius > 0) && (shape.innerRadius >= shape.radius)) ||
+            !(shape.axisRatio >= DFMinimumAxisRatio) || !(shape.axisRatio <= 1))
+            return n;
+        shapes.push_back(shape);
+    }
+    return 0;
+}
+
+}	// namespace pcl
@@ -0,0 +1,62 @@
+#ifndef __DustFreeShapes_h
+#define __DustFreeShapes_h
+
+#include <cstddef>
+#include <vector>
+
+#include "DustFreeBitMask.h"
+#include "DustFreeRegions.h"
+
+namespace pcl
+{
+
+// Narrowest ellipse a shape can be, as the ratio of its axes.
+const double DFMinimumAxisRatio = 0.01;
+
+// A dust mote given as a shape, in image coordinates (pixel (i, j) spans
+// [i, i + 1) x [j, j + 1)): an ellipse of semi-major axis radius, at angle
+// degrees from the x axis towards the y axis, and semi-minor axis axisRatio
+// times radius. A circle has an axis ratio of one; a positive innerRadius
+// makes an annulus, whose hole is the same ellipse scaled down.
+//
+// The feather is the width of the soft edge of a drawn mask, over which it
+// falls from one to zero. The pipeline binarizes dust masks at one half, so a
+// feathered edge is rasterized at the middle of its ramp: the outer edge
+// grows, and the hole shrinks, by half the feather.
+struct DFDustShape
+{
+    double x = 0;
+    double y = 0;
+    double radius = 0;
+    double innerRadius = 0;
+    double axisRatio = 1;
+    double angle = 0;
+    double feather = 0;
+};
+
+// Sets the pixels of mask covered by any of the shapes. Pixel (i, j) of the
+// mask stands for the image point (x0 + (i + 0.5)*scale, y0 + (j + 0.5)*scale),
+// so a mask at 1:scale of a window whose corner is (x0, y0) is drawn directly,
+// a span of pixels per row and shape, without a full resolution mask.
+void DFRasterizeShapes(const DFDustShape* shapes, size_t count, double x0, double y0, double scale, DFBitMask& mask);
+
+// Image pixels a shape can cover, unclipped.
+DFRect DFShapeBounds(const DFDustShape& shape);
+
+// Boxes of the pixels of a width x height window, whose corner is the image
+// pixel (x0, y0), that the shapes can cover: their bounds in the coordinates
+// of the window, clipped to it, without those that miss it.
+std::vector<DFRect> DFShapeComponents(const DFDustShape* shapes, size_t count, int x0, int y0, int width, int height);
+
+// Reads shapes from text, one per line: x, y and radius, then optionally the
+// inner radius, the axis ratio, the angle and the feather, separated by spaces
+// or commas. Blank lines and lines starting with # are skipped. Returns the
+// number of the first malformed line, or zero when all of them are read. A
+// line is malformed if it has a negative radius or inner radius, an inner
+// radius that is not below the radius, or an axis ratio outside
+// [DFMinimumAxisRatio, 1].
+int DFParseShapes(const char* text, size_t length, std::vector<DFDustShape>& shapes);
+
+}	// namespace pcl
+
+#endif	// __DustFreeShapes_h
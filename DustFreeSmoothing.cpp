@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include "DustFreeParallel.h"
+#include "DustFreeSmoothing.h"
+
+namespace pcl
+{
+
+namespace
+{
+
+// Third order recursive Gaussian of van Vliet, Young and Verbeek: the poles
+// designed for sigma 2 are scaled by a power 1/q, with q chosen so that the
+// variance of the causal and anticausal pair is sigma^2. The shape of the
+// impulse response is then the same at every sigma, within about 1% of the
+// peak from sigma 4 on; the fitted q of Young and van Vliet drifts to 14% by
+// sigma 158.
+struct DFRecursiveCoefficients
+{
+    double B;
+    double b1;
+    double b2;
+    double b3;
+
+    explicit DFRecursiveCoefficients(double sigma)
+    {
+        static const std::complex<double> poles[] = { { 1.41650, 1.00829 }, { 1.41650, -1.00829 }, { 1.86543, 0 } };
+        auto variance = [](double q) {
+            double v = 0;
+            for (const std::complex<double>& d : poles) {
+                const std::complex<double> p = std::pow(d, 1 / q);
+                v += (2.0 * p / ((p - 1.0) * (p - 1.0))).real();
+            }
+            return v;
+        };
+        // The variance grows with q.
+        double low = 0.1;
+        double high = 1;
+        while (variance(high) < sigma * sigma)
+            high *= 2;
+        for (int i = 0; i < 60; i++) {
+            const double q = (low + high) / 2;
+            (variance(q) < sigma * sigma) ? low = q : high = q;
+        }
+        const std::complex<double> s1 = 1.0 / std::pow(poles[0], 2 / (low + high));
+        const std::complex<double> s2 = 1.0 / std::pow(poles[1], 2 / (low + high));
+        const std::complex<double> s3 = 1.0 / std::pow(poles[2], 2 / (low + high));
+        b1 = (s1 + s2 + s3).real();
+        b2 = -(s1 * s2 + s1 * s3 + s2 * s3).real();
+        b3 = (s1 * s2 * s3).real();
+        B = 1 - (b1 + b2 + b3);
+    }
+};
+
+// One row, in place, through a double precision work buffer.
+template <typename T>
+void FilterRow(T* row, int n, const DFRecursiveCoefficients& k, double* w)
+{
+    double w1 = row[0], w2 = row[0], w3 = row[0];
+    for (int i = 0; i < n; i++) {
+        const double v = k.B * row[i] + k.b1 * w1 + k.b2 * w2 + k.b3 * w3;
+        w[i] = v;
+        w3 = w2;
+        w2 = w1;
+        w1 = v;
+    }
+    w1 = w2 = w3 = w[n - 1];
+    for (int i = n - 1; i >= 0; i--) {
+        const double v = k.B * w[i] + k.b1 * w1 + k.b2 * w2 + k.b3 * w3;
+        row[i] = T(v);
+        w3 = w2;
+        w2 = w1;
+        w1 = v;
+    }
+}
+
+// A strip of columns [x0, x1), walked row by row so that every step reads and
+// writes contiguous samples. Rows before the first one repeat it, which is the
+// steady state of the causal pass. The state of both passes is kept in double
+// precision row buffers: at large sigmas the feedback coefficients nearly
+// cancel, and rounding it to T every row drifts by about 1% of the range.
+template <typename T>
+void FilterColumns(T* plane, int width, int height, int x0, int x1, const DFRecursiveCoefficients& k,
+    std::vector<double>& s1, std::vector<double>& s2, std::vector<double>& s3)
+{
+    const int n = x1 - x0;
+    auto at = [&](int y) {
+        return plane + size_t(y) * width + x0;
+    };
+
+    const T* first = at(0);
+    s1.assign(first, first + n);
+    s2 = s1;
+    s3 = s1;
+    for (int y = 0; y < height; y++) {
+        T* row = at(y);
+        for (int i = 0; i < n; i++) {
+            const double v = k.B * row[i] + k.b1 * s1[i] + k.b2 * s2[i] + k.b3 * s3[i];
+            row[i] = T(v);
+            s3[i] = s2[i];
+            s2[i] = s1[i];
+            s1[i] = v;
+        }
+    }
+
+    // The anticausal pass starts from the steady state of the last causal row.
+    s2 = s1;
+    s3 = s1;
+    for (int y = height - 1; y >= 0; y--) {
+        T* row = at(y);
+        for (int i = 0; i < n; i++) {
+            const double v = k.B * row[i] + k.b1 * s1[i] + k.b2 * s2[i] + k.b3 * s3[i];
+            row[i] = T(v);
+            s3[i] = s2[i];
+            s2[i] = s1[i];
+            s1[i] = v;
+        }
+    }
+}
+
+}	// namespace
+
+template <typename T>
+void DFRecursiveGaussian(T* plane, int width, int height, double sigma)
+{
+    if ((sigma < 0.5) || (width <= 0) || (height <= 0))
+        return;
+
+    const DFRecursiveCoefficients k(sigma);
+
+    DFParallelFor(height, [&](int y0, int y1) {
+        std::vector<double> w(width);
+        for (int y = y0; y < y1; y++)
+            FilterRow(plane + size_t(y) * width, width, k, w.data());
+    }, std::max(1, 16384 / width));
+
+    const int strip = 256;
+    DFParallelFor((width + strip - 1) / strip, [&](int s0, int s1) {
+        std::vector<double> w1, w2, w3;
+        for (int s = s0; s < s1; s++)
+            FilterColumns(plane, width, height, s * strip, std::min((s + 1) * strip, width), k, w1, w2, w3);
+    });
+}
+
+double DFEquivalentGaussianSigma(double sigma, double shape)
+{
+    return sigma * std::pow(shape, 1 / shape) * std::sqrt(std::tgamma(3 / shape) / std::tgamma(1 / shape));
+}
+
+template void DFRecursiveGaussian<float>(float*, int, int, double);
+template void DFRecursiveGaussian<double>(double*, int, int, double);
+
+}	// namespace pcl
@@ -0,0 +1,22 @@
+#ifndef __DustFreeSmoothing_h
+#define __DustFreeSmoothing_h
+
+namespace pcl
+{
+
+// Recursive Gaussian filter (van Vliet, Young & Verbeek), in place on a plane
+// of width x height samples. Each row, then each column, is run through a
+// third order causal and anticausal IIR pair, so the cost per pixel does not
+// depend on sigma and no padded buffers are needed. Edges are extended with
+// their end samples. Rows run in parallel; columns in parallel strips, row by
+// row.
+template <typename T>
+void DFRecursiveGaussian(T* plane, int width, int height, double sigma);
+
+// Standard deviation of the Gaussian with the same second moment as the
+// variable shape profile exp(-|x|^shape / (shape * sigma^shape)).
+double DFEquivalentGaussianSigma(double sigma, double shape);
+
+}	// namespace pcl
+
+#endif	// __DustFreeSmoothing_h
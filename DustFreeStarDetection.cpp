@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "DustFreeParallel.h"
+#include "DustFreeStarDetection.h"
+
+namespace pcl
+{
+
+namespace
+{
+
+int Mirror(int i, int n)
+{
+    if (n == 1)
+        return 0;
+    const int period = 2 * n - 2;
+    i = std::abs(i) % period;
+    return (i < n) ? i : period - i;
+}
+
+// Separable B3 spline kernel 1/16 (1 4 6 4 1), with holes of step - 1 pixels.
+template <typename T>
+void ConvolveB3(const T* input, T* output, T* scratch, int width, int height, int step)
+{
+    const T k0 = T(6) / 16;
+    const T k1 = T(4) / 16;
+    const T k2 = T(1) / 16;
+
+    DFParallelFor(height, [&](int y0, int y1) {
+        for (int y = y0; y < y1; y++) {
+            const T* in = input + size_t(y) * width;
+            T* out = scratch + size_t(y) * width;
+            auto at = [&](int x, int d) {
+                return in[Mirror(x + d, width)];
+            };
+            const int x0 = std::min(2 * step, width);
+            const int x1 = std::max(width - 2 * step, x0);
+            for (int x = 0; x < x0; x++)
+                out[x] = k0 * in[x] + k1 * (at(x, -step) + at(x, step)) + k2 * (at(x, -2 * step) + at(x, 2 * step));
+            for (int x = x0; x < x1; x++)
+                out[x] = k0 * in[x] + k1 * (in[x - step] + in[x + step]) + k2 * (in[x - 2 * step] + in[x + 2 * step]);
+            for (int x = x1; x < width; x++)
+                out[x] = k0 * in[x] + k1 * (at(x, -step) + at(x, step)) + k2 * (at(x, -2 * step) + at(x, 2 * step));
+        }
+    }, std::max(1, 16384 / std::max(1, width)));
+
+    DFParallelFor(height, [&](int y0, int y1) {
+        for (int y = y0; y < y1; y++) {
+            const T* r0 = scratch + size_t(Mirror(y - 2 * step, height)) * width;
+            const T* r1 = scratch + size_t(Mirror(y - step, height)) * width;
+            const T* r2 = scratch + size_t(y) * width;
+            const T* r3 = scratch + size_t(Mirror(y + step, height)) * width;
+            const T* r4 = scratch + size_t(Mirror(y + 2 * step, height)) * width;
+            T* out = output + size_t(y) * width;
+            for (int x = 0; x < width; x++)
+                out[x] = k0 * r2[x] + k1 * (r1[x] + r3[x]) + k2 * (r0[x] + r4[x]);
+        }
+    }, std::max(1, 16384 / std::max(1, width)));
+}
+
+// Band-pass response of one channel, clipped to [0,1], into band; low and
+// high are extended with its range over the core.
+template <typename T>
+void BandPass(const T* plane, T* band, T* smooth, T* scratch, int width, int height, const DFRect& core, T& low, T& high)
+{
+    ConvolveB3(plane, band, scratch, width, height, 1);
+    ConvolveB3(band, smooth, scratch, width, height, 2);
+    ConvolveB3(smooth, smooth, scratch, width, height, 4);
+    ConvolveB3(smooth, smooth, scratch, width, height, 8);
+
+    std::vector<T> rowLow(height, T(1)), rowHigh(height, T(0));
+    DFParallelFor(height, [&](int y0, int y1) {
+        for (int y = y0; y < y1; y++) {
+            T* b = band + size_t(y) * width;
+            const T* s = smooth + size_t(y) * width;
+            for (int x = 0; x < width; x++)
+                b[x] = std::min(std::max(b[x] - s[x], T(0)), T(1));
+            if ((y >= core.y0) && (y < core.y1) && (core.x1 > core.x0)) {
+                rowLow[y] = *std::min_element(b + core.x0, b + core.x1);
+                rowHigh[y] = *std::max_element(b + core.x0, b + core.x1);
+            }
+        }
+    }, std::max(1, 16384 / width));
+    low = std::min(low, *std::min_element(rowLow.begin(), rowLow.end()));
+    high = std::max(high, *std::max_element(rowHigh.begin(), rowHigh.end()));
+}
+
+}	// namespace
+
+template <typename T>
+void DFDetectStars(const T* const* planes, int channels, int width, int height, double threshold, DFBitMask* masks,
+    const double* range)
+{
+    const size_t size = size_t(width) * height;
+    if (size == 0)
+        return;
+
+    // Band-pass responses, kept until the range of all channels is known.
+    std::vector<std::vector<T>> band(channels);
+    std::vector<T> smooth(size);
+    std::vector<T> scratch(size);
+    T low = T(1);
+    T high = T(0);
+    for (int c = 0; c < channels; c++) {
+        band[c].resize(size);
+        BandPass(planes[c], band[c].data(), smooth.data(), scratch.data(), width, height, DFRect{ 0, 0, width, height }, low, high);
+    }
+    if (range != nullptr) {
+        low = T(range[0]);
+        high = T(range[1]);
+    }
+
+    // Normalizing to [0,1] and thresholding is thresholding at the level that
+    // normalizes to the threshold. A flat response is left unscaled.
+    const T level = (high > low) ? T(low + threshold * (high - low)) : T(threshold);
+    for (int c = 0; c < channels; c++) {
+        masks[c].Binarize(band[c].data(), width, height, level);
+        std::vector<T>().swap(band[c]);
+        masks[c].Median3x3();
+    }
+}
+
+template <typename T>
+void DFStarResponseRange(const T* const* planes, int channels, int width, int height, const DFRect& core,
+    double& low, double& high)
+{
+    const size_t size = size_t(width) * height;
+    if (size == 0)
+        return;
+
+    std::vector<T> band(size);
+    std::vector<T> smooth(size);
+    std::vector<T> scratch(size);
+    T l = T(low);
+    T h = T(high);
+    for (int c = 0; c < channels; c++)
+        BandPass(planes[c], band.data(), smooth.data(), scratch.data(), width, height, core, l, h);
+    low = l;
+    high = h;
+}
+
+template void DFDetectStars<float>(const float* const*, int, int, int, double, DFBitMask*, const double*);
+template void DFDetectStars<double>(const double* const*, int, int, int, double, DFBitMask*, const double*);
+template void DFStarResponseRange<float>(const float* const*, int, int, int, const DFRect&, double&, double&);
+template void DFStarResponseRange<double>(const double* const*, int, int, int, const DFRect&, double&, double&);
+
+}	// namespace pcl
@@ -0,0 +1,31 @@
+#ifndef __DustFreeStarDetection_h
+#define __DustFreeStarDetection_h
+
+#include "DustFreeBitMask.h"
+#include "DustFreeRegions.h"
+
+namespace pcl
+{
+
+// Star detection by band-pass filtering, in a few streaming passes. The
+// response is the difference between the first and the fourth smoothing scales
+// of a B3 spline a trous transform, which is the sum of its wavelet layers 1 to
+// 3; it is computed directly with separable kernels. The response is clipped to
+// [0,1], scaled to the range of all channels, and thresholded; a 3x3 median
+// filter then runs on the resulting bits. masks[c] receives the stars of
+// channel c. Borders are mirrored. If range is given, its two values replace
+// the range of the response measured on the planes.
+template <typename T>
+void DFDetectStars(const T* const* planes, int channels, int width, int height, double threshold, DFBitMask* masks,
+    const double* range = nullptr);
+
+// Extends [low, high] with the range of the clipped band-pass response of all
+// channels over the core rectangle, as DFDetectStars measures it. Measured on
+// overlapping tiles, it gives the range of the whole image.
+template <typename T>
+void DFStarResponseRange(const T* const* planes, int channels, int width, int height, const DFRect& core,
+    double& low, double& high);
+
+}	// namespace pcl
+
+#endif	// __DustFreeStarDetection_h
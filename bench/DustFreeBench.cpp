@@ -0,0 +1,300 @@
+// Headless benchmark of the pipeline kernels on synthetic frames. Every stage
+// runs on the same inputs at each frame size and thread count; the best of a
+// few runs is reported, in megapixels of the frame per second.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DustFreeBitMask.h"
+#include "DustFreeInpaint.h"
+#include "DustFreeParallel.h"
+#include "DustFreeProfile.h"
+#include "DustFreeRegions.h"
+#include "DustFreeResample.h"
+#include "DustFreeSmoothing.h"
+#include "DustFreeStarDetection.h"
+#include "DustFreeSynthetic.h"
+
+using namespace pcl;
+
+namespace
+{
+
+typedef std::vector<std::vector<float>> Planes;
+
+struct Stage
+{
+    const char* name;
+    std::function<void()> setup;    // not timed
+    std::function<void()> run;
+};
+
+struct Result
+{
+    std::string stage;
+    int width;
+    int height;
+    int threads;
+    double seconds;
+};
+
+std::vector<int> ParseList(const char* s)
+{
+    std::vector<int> list;
+    for (const char* p = s; *p != '\0';) {
+        char* end;
+        const long v = std::strtol(p, &end, 10);
+        if ((end == p) || (v <= 0)) {
+            std::fprintf(stderr, "Invalid list: %s\n", s);
+            std::exit(2);
+        }
+        list.push_back(int(v));
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return list;
+}
+
+std::vector<const float*> Inputs(const Planes& planes)
+{
+    std::vector<const float*> p;
+    for (const std::vector<float>& plane : planes)
+        p.push_back(plane.data());
+    return p;
+}
+
+std::vector<float*> Outputs(Planes& planes)
+{
+    std::vector<float*> p;
+    for (std::vector<float>& plane : planes)
+        p.push_back(plane.data());
+    return p;
+}
+
+double Seconds(const std::function<void()>& f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ShowHelp()
+{
+    std::printf(
+        "Usage: dustfree_bench [<options>]\n"
+        "\n"
+        "--sizes=<n,...>      Frame sizes, square, in pixels. The default is 1024,2048,4096.\n"
+        "--threads=<n,...>    Thread counts. The default is 1, 2, 4... up to all hardware threads.\n"
+        "--repeat=<n>         Runs of each stage; the fastest one counts. The default is 3.\n"
+        "--sensitivity=<s>    Star detection sensitivity. The default is 2.\n"
+        "--channels=<n>       Channels of the frames. The default is 3.\n"
+        "--seed=<n>           Seed of the synthetic frames. The default is 1.\n"
+        "--json=<file>        Also writes the results to <file> as JSON.\n"
+        "--help               Displays this help and exits.\n");
+}
+
+}	// namespace
+
+int main(int argc, char** argv)
+{
+    std::vector<int> sizes = { 1024, 2048, 4096 };
+    std::vector<int> threads;
+    int repeat = 3;
+    double sensitivity = 2;
+    DFSyntheticOptions options;
+    std::string jsonFile;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        auto value = [&](const char* name) -> const char* {
+            const size_t n = std::strlen(name);
+            return ((std::strncmp(arg, name, n) == 0) && (arg[n] == '=')) ? arg + n + 1 : nullptr;
+        };
+        if (const char* v = value("--sizes"))
+            sizes = ParseList(v);
+        else if (const char* v = value("--threads"))
+            threads = ParseList(v);
+        else if (const char* v = value("--repeat"))
+            repeat = std::max(1, std::atoi(v));
+        else if (const char* v = value("--sensitivity"))
+            sensitivity = std::atof(v);
+        else if (const char* v = value("--channels"))
+            options.channels = std::max(1, std::atoi(v));
+        else if (const char* v = value("--seed"))
+            options.seed = uint32_t(std::strtoul(v, nullptr, 10));
+        else if (const char* v = value("--json"))
+            jsonFile = v;
+        else if (std::strcmp(arg, "--help") == 0) {
+            ShowHelp();
+            return 0;
+        } else {
+            std::fprintf(stderr, "Unknown argument: %s\n", arg);
+            ShowHelp();
+            return 2;
+        }
+    }
+    if (threads.empty()) {
+        const int hardware = std::max(1, int(std::thread::hardware_concurrency()));
+        for (int t = 1; t < hardware; t *= 2)
+            threads.push_back(t);
+        threads.push_back(hardware);
+    }
+
+    // Default parameters of the process, a diffusion distance of 5 and a
+    // smoothness of 2, applied to a 2x downsampled frame. The sensitivity is
+    // set so that the star masks hold the stars and not the noise.
+    const double threshold = std::pow(10.0, -sensitivity);
+    const int dilation = 2 * 5 + 3;
+    const double sigma = DFEquivalentGaussianSigma(std::pow(1.7, 2.0), 5.0);
+
+    std::vector<Result> results;
+    for (const int size : sizes) {
+        options.width = options.height = size;
+        DFSetParallelThreadCount(threads.back());
+        DFSyntheticFrame frame;
+        const double generation = Seconds([&]() { frame = DFMakeSyntheticFrame(options); });
+        const int w = frame.width;
+        const int h = frame.height;
+        const int channels = frame.channels;
+        const std::vector<const float*> planes = frame.Planes();
+
+        // Inputs of the later stages, as the pipeline would produce them: the
+        // star mask, dilated and inverted; the dust-free mask; and the
+        // background with both masks applied, whose holes are inpainted.
+        std::vector<DFBitMask> detected(channels);
+        DFDetectStars(planes.data(), channels, w, h, threshold, detected.data());
+        std::vector<DFBitMask> sky = detected;
+        for (DFBitMask& m : sky) {
+            m.Dilate(dilation);
+            m.Invert();
+        }
+        DFBitMask dustFree;
+        dustFree.Binarize(frame.dustMask.data(), w, h, 0.5f);
+        dustFree.Invert();
+        Planes background = frame.planes;
+        for (int c = 0; c < channels; c++) {
+            sky[c].Select(background[c].data());
+            dustFree.Select(background[c].data());
+        }
+        DFHoleSpans holes;
+        holes.Build(Inputs(background).data(), channels, w, h);
+        const int hw = (w + 1) / 2;
+        const int hh = (h + 1) / 2;
+        Planes correction(channels, std::vector<float>(size_t(hw) * hh));
+        for (int c = 0; c < channels; c++)
+            for (int y = 0; y < hh; y++)
+                for (int x = 0; x < hw; x++)
+                    correction[c][size_t(y) * hw + x] = 0.001f * std::sin(0.01f * x) * std::cos(0.013f * y);
+
+        std::printf("\nFrame %dx%dx%d: %d stars, %d motes, %.2f%% holes, generated in %.2f s\n", w, h, channels,
+            frame.stars, frame.motes, 100.0 * holes.holes / (double(w) * h), generation);
+
+        std::vector<DFBitMask> masks(channels);
+        const float* dustPlane = frame.dustMask.data();
+        Planes work;
+        Planes output(channels, std::vector<float>(size_t(w) * h));
+        const std::vector<const float*> in = Inputs(background);
+        const std::vector<float*> out = Outputs(output);
+        const std::vector<Stage> stages = {
+            { "Star detection", nullptr, [&]() {
+                DFDetectStars(planes.data(), channels, w, h, threshold, masks.data());
+            } },
+            { "Star mask dilation", [&]() { masks = detected; }, [&]() {
+                for (DFBitMask& m : masks) {
+                    m.Dilate(dilation);
+                    m.Invert();
+                }
+            } },
+            { "Dust mask binarization", nullptr, [&]() {
+                masks[0].Binarize(dustPlane, w, h, 0.5f);
+                masks[0].Invert();
+            } },
+            { "Dust regions", nullptr, [&]() {
+                DFComponentBounds(&dustPlane, 1, w, h, 0.5f);
+            } },
+            { "Mask selection", [&]() { work = frame.planes; }, [&]() {
+                for (int c = 0; c < channels; c++) {
+                    sky[c].Select(work[c].data());
+                    dustFree.Select(work[c].data());
+                }
+            } },
+            { "Ray march, tiled", nullptr, [&]() {
+                DFInpaintRayMarch(in.data(), out.data(), channels, w, h, true);
+            } },
+            { "Ray march", nullptr, [&]() {
+                DFInpaintRayMarch(in.data(), out.data(), channels, w, h, false);
+            } },
+            { "Nearest sample", nullptr, [&]() {
+                for (int c = 0; c < channels; c++)
+                    DFInpaintNearestSample(in[c], out[c], w, h);
+            } },
+            { "Push-pull", nullptr, [&]() {
+                for (int c = 0; c < channels; c++)
+                    DFInpaintPushPull(in[c], out[c], w, h);
+            } },
+            { "Recursive Gaussian", [&]() { work = correction; }, [&]() {
+                for (int c = 0; c < channels; c++)
+                    DFRecursiveGaussian(work[c].data(), hw, hh, sigma);
+            } },
+            { "Upsample and apply", [&]() { work = frame.planes; }, [&]() {
+                for (int c = 0; c < channels; c++)
+                    DFAddUpsampled(correction[c].data(), hw, hh, work[c].data(), w, h);
+            } },
+        };
+
+        std::printf("%-24s", "Stage");
+        for (const int t : threads)
+            std::printf(" %7d thr MP/s", t);
+        std::printf(" %9s\n", "Scaling");
+        const double megapixels = double(w) * h * 1.0e-6;
+        for (const Stage& stage : stages) {
+            std::printf("%-24s", stage.name);
+            std::fflush(stdout);
+            double first = 0;
+            double last = 0;
+            for (const int t : threads) {
+                DFSetParallelThreadCount(t);
+                double best = 0;
+                for (int r = 0; r < repeat; r++) {
+                    if (stage.setup)
+                        stage.setup();
+                    const double s = Seconds(stage.run);
+                    best = (r == 0) ? s : std::min(best, s);
+                }
+                results.push_back(Result{ stage.name, w, h, t, best });
+                std::printf(" %16.1f", megapixels / best);
+                std::fflush(stdout);
+                if (t == threads.front())
+                    first = best;
+                last = best;
+            }
+            std::printf(" %8.2fx\n", first / last);
+        }
+    }
+
+    if (!jsonFile.empty()) {
+        FILE* f = std::fopen(jsonFile.c_str(), "w");
+        if (f == nullptr) {
+            std::fprintf(stderr, "Unable to create file: %s\n", jsonFile.c_str());
+            return 1;
+        }
+        std::fprintf(f, "{\"benchmark\": \"DustFree\", \"channels\": %d, \"seed\": %u, \"repeat\": %d, \"results\": [",
+            options.channels, unsigned(options.seed), repeat);
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            std::fprintf(f, "%s\n  {\"stage\": %s, \"width\": %d, \"height\": %d, \"threads\": %d, \"seconds\": %.6f, "
+                "\"megapixelsPerSecond\": %.3f}", (i > 0) ? "," : "", DFJsonString(r.stage).c_str(), r.width, r.height,
+                r.threads, r.seconds, r.width * 1.0e-6 * r.height / r.seconds);
+        }
+        std::fprintf(f, "\n]}\n");
+        std::fclose(f);
+    }
+    return 0;
+}
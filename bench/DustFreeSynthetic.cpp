@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "DustFreeSynthetic.h"
+
+namespace pcl
+{
+
+namespace
+{
+
+// The raw output of std::mt19937 is fixed by the standard, unlike the
+// distributions built on it.
+class DFRandom
+{
+public:
+    DFRandom(uint32_t seed)
+        : m_engine(seed)
+    {
+    }
+
+    // Uniform in [0, 1).
+    double Uniform()
+    {
+        return (m_engine() >> 5) * (1.0 / 134217728.0);
+    }
+
+    double Uniform(double a, double b)
+    {
+        return a + (b - a) * Uniform();
+    }
+
+    // Standard normal, by the Box-Muller transform.
+    double Normal()
+    {
+        if (m_hasSpare) {
+            m_hasSpare = false;
+            return m_spare;
+        }
+        const double u = 1.0 - Uniform();
+        const double v = Uniform();
+        const double r = std::sqrt(-2 * std::log(u));
+        m_spare = r * std::sin(6.283185307179586 * v);
+        m_hasSpare = true;
+        return r * std::cos(6.283185307179586 * v);
+    }
+
+private:
+    std::mt19937 m_engine;
+    double m_spare = 0;
+    bool m_hasSpare = false;
+};
+
+inline double SmoothStep(double x)
+{
+    x = std::min(std::max(x, 0.0), 1.0);
+    return x * x * (3 - 2 * x);
+}
+
+}	// namespace
+
+DFSyntheticFrame DFMakeSyntheticFrame(const DFSyntheticOptions& options)
+{
+    const int w = options.width;
+    const int h = options.height;
+    const size_t n = size_t(w) * h;
+    const double megapixels = n * 1.0e-6;
+    DFRandom random(options.seed);
+
+    DFSyntheticFrame frame;
+    frame.width = w;
+    frame.height = h;
+    frame.channels = options.channels;
+    frame.planes.assign(options.channels, std::vector<float>(n));
+    frame.dustMask.assign(n, 0.0f);
+
+    // Sky: a tilted plane plus a faint radial glow, a little different in
+    // every channel, and the noise.
+    for (int c = 0; c < options.channels; c++) {
+        const double base = random.Uniform(0.08, 0.12);
+        const double gx = random.Uniform(-0.02, 0.02);
+        const double gy = random.Uniform(-0.02, 0.02);
+        const double glow = random.Uniform(0.0, 0.03);
+        float* s = frame.planes[c].data();
+        for (int y = 0; y < h; y++) {
+            const double fy = double(y) / h - 0.5;
+            for (int x = 0; x < w; x++) {
+                const double fx = double(x) / w - 0.5;
+                s[size_t(y) * w + x] = float(base + gx * fx + gy * fy + glow * (1 - 2 * (fx * fx + fy * fy)) +
+                    options.noise * random.Normal());
+            }
+        }
+    }
+
+    // Stars: Moffat profiles A (1 + (r/alpha)^2)^-beta with a power law of
+    // amplitudes, drawn out to where they fall below a hundredth of the noise.
+    const int stars = int(options.starDensity * megapixels);
+    for (int i = 0; i < stars; i++) {
+        const double cx = random.Uniform(0, w);
+        const double cy = random.Uniform(0, h);
+        const double fwhm = random.Uniform(1.8, 5.0);
+        const double beta = random.Uniform(2.5, 4.5);
+        const double alpha = fwhm / (2 * std::sqrt(std::pow(2.0, 1 / beta) - 1));
+        const double amplitude = 0.9 * std::pow(random.Uniform(0.001, 1.0), 2.5);
+        const double floor = 0.01 * std::max(options.noise, 1.0e-4);
+        if (amplitude <= floor)
+            continue;
+        frame.stars++;
+        const double radius = std::min(alpha * std::sqrt(std::pow(amplitude / floor, 1 / beta) - 1), 0.05 * std::max(w, h));
+        std::vector<double> color(options.channels);
+        for (double& k : color)
+            k = random.Uniform(0.8, 1.2);
+        const int x0 = std::max(0, int(cx - radius));
+        const int x1 = std::min(w - 1, int(cx + radius));
+        const int y0 = std::max(0, int(cy - radius));
+        const int y1 = std::min(h - 1, int(cy + radius));
+        for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++) {
+                const double dx = x + 0.5 - cx;
+                const double dy = y + 0.5 - cy;
+                const double f = amplitude * std::pow(1 + (dx * dx + dy * dy) / (alpha * alpha), -beta);
+                for (int c = 0; c < options.channels; c++)
+                    frame.planes[c][size_t(y) * w + x] += float(f * color[c]);
+            }
+    }
+
+    // Dust motes: out-of-focus shadows, a disc dimmed by a few percent with a
+    // soft rim and the brighter hole of the central obstruction. The mask
+    // covers each disc with a margin of two pixels.
+    frame.motes = std::max(1, int(options.moteDensity * megapixels));
+    for (int i = 0; i < frame.motes; i++) {
+        const double cx = random.Uniform(0, w);
+        const double cy = random.Uniform(0, h);
+        const double outer = random.Uniform(8, 48);
+        const double inner = outer * random.Uniform(0.25, 0.45);
+        const double depth = random.Uniform(0.03, 0.12);
+        const double rim = random.Uniform(1.0, 3.0);
+        std::vector<double> tint(options.channels);
+        for (double& k : tint)
+            k = random.Uniform(0.9, 1.1);
+        const int x0 = std::max(0, int(cx - outer - 3));
+        const int x1 = std::min(w - 1, int(cx + outer + 3));
+        const int y0 = std::max(0, int(cy - outer - 3));
+        const int y1 = std::min(h - 1, int(cy + outer + 3));
+        for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++) {
+                const double dx = x + 0.5 - cx;
+                const double dy = y + 0.5 - cy;
+                const double r = std::sqrt(dx * dx + dy * dy);
+                const size_t k = size_t(y) * w + x;
+                if (r <= outer + 2)
+                    frame.dustMask[k] = 1.0f;
+                const double shadow = depth * SmoothStep((outer - r) / rim + 0.5) *
+                    (1 - 0.6 * SmoothStep((inner - r) / rim + 0.5));
+                for (int c = 0; c < options.channels; c++)
+                    frame.planes[c][k] *= float(1 - shadow * tint[c]);
+            }
+    }
+
+    // Zero and below are holes to the inpainting; the frame has none.
+    for (std::vector<float>& plane : frame.planes)
+        for (float& v : plane)
+            v = std::min(std::max(v, 1.0e-4f), 1.0f);
+    return frame;
+}
+
+}	// namespace pcl
@@ -0,0 +1,49 @@
+#ifndef __DustFreeSynthetic_h
+#define __DustFreeSynthetic_h
+
+#include <cstdint>
+#include <vector>
+
+namespace pcl
+{
+
+// Parameters of a synthetic frame. Densities are per megapixel.
+struct DFSyntheticOptions
+{
+    int width = 2048;
+    int height = 2048;
+    int channels = 3;
+    uint32_t seed = 1;
+    double starDensity = 400;
+    double moteDensity = 4;
+    double noise = 0.002;       // standard deviation of the sky noise
+};
+
+// A synthetic frame: a gradient sky with Gaussian noise, a field of Moffat
+// stars, and the annular shadows of out-of-focus dust motes. The dust mask
+// covers every shadow. The frame depends on the options alone; it is the same
+// on every platform, since no distribution of the standard library is used.
+struct DFSyntheticFrame
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    int stars = 0;
+    int motes = 0;
+    std::vector<std::vector<float>> planes;     // samples in (0,1]
+    std::vector<float> dustMask;                // 1 over the motes, 0 elsewhere
+
+    std::vector<const float*> Planes() const
+    {
+        std::vector<const float*> p;
+        for (const std::vector<float>& plane : planes)
+            p.push_back(plane.data());
+        return p;
+    }
+};
+
+DFSyntheticFrame DFMakeSyntheticFrame(const DFSyntheticOptions& options);
+
+}	// namespace pcl
+
+#endif	// __DustFreeSynthetic_h
@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "DustFreeReference.h"
+
+namespace pcl
+{
+
+namespace
+{
+
+int Mirror(int i, int n)
+{
+    if (n == 1)
+        return 0;
+    const int period = 2 * n - 2;
+    i = std::abs(i) % period;
+    return (i < n) ? i : period - i;
+}
+
+int Clamp(int i, int n)
+{
+    return (i < 0) ? 0 : ((i >= n) ? n - 1 : i);
+}
+
+// One B3 spline smoothing with holes of step - 1 pixels.
+std::vector<double> ConvolveB3(const std::vector<double>& a, int w, int h, int step)
+{
+    static const double k[5] = { 1 / 16.0, 4 / 16.0, 6 / 16.0, 4 / 16.0, 1 / 16.0 };
+    std::vector<double> t(a.size());
+    std::vector<double> o(a.size());
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++) {
+            double v = 0;
+            for (int i = -2; i <= 2; i++)
+                v += k[i + 2] * a[size_t(y) * w + Mirror(x + i * step, w)];
+            t[size_t(y) * w + x] = v;
+        }
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++) {
+            double v = 0;
+            for (int i = -2; i <= 2; i++)
+                v += k[i + 2] * t[size_t(Mirror(y + i * step, h)) * w + x];
+            o[size_t(y) * w + x] = v;
+        }
+    return o;
+}
+
+std::vector<double> BandPass(const float* plane, int w, int h)
+{
+    const std::vector<double> a(plane, plane + size_t(w) * h);
+    const std::vector<double> c1 = ConvolveB3(a, w, h, 1);
+    const std::vector<double> c4 = ConvolveB3(ConvolveB3(ConvolveB3(c1, w, h, 2), w, h, 4), w, h, 8);
+    std::vector<double> band(a.size());
+    for (size_t i = 0; i < band.size(); i++)
+        band[i] = std::min(std::max(c1[i] - c4[i], 0.0), 1.0);
+    return band;
+}
+
+std::vector<double> GaussianKernel(double sigma)
+{
+    const int r = std::max(1, int(std::ceil(5 * sigma)));
+    std::vector<double> k(2 * r + 1);
+    double sum = 0;
+    for (int i = -r; i <= r; i++)
+        sum += k[i + r] = std::exp(-0.5 * i * i / (sigma * sigma));
+    for (double& v : k)
+        v /= sum;
+    return k;
+}
+
+std::vector<double> VariableShapeKernel(double sigma, double shape)
+{
+    const int r = std::max(1, int(sigma * std::pow(shape * std::log(100.0), 1 / shape)));
+    std::vector<double> k(2 * r + 1);
+    double sum = 0;
+    for (int i = -r; i <= r; i++)
+        sum += k[i + r] = std::exp(-std::pow(std::abs(i) / sigma, shape) / shape);
+    for (double& v : k)
+        v /= sum;
+    return k;
+}
+
+// Convolution with k along rows, then along columns.
+std::vector<double> Separable(const std::vector<double>& plane, int width, int height, const std::vector<double>& k)
+{
+    const int r = int(k.size() / 2);
+    std::vector<double> t(plane.size());
+    std::vector<double> o(plane.size());
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++) {
+            double v = 0;
+            for (int i = -r; i <= r; i++)
+                v += k[i + r] * plane[size_t(y) * width + Clamp(x + i, width)];
+            t[size_t(y) * width + x] = v;
+        }
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++) {
+            double v = 0;
+            for (int i = -r; i <= r; i++)
+                v += k[i + r] * t[size_t(Clamp(y + i, height)) * width + x];
+            o[size_t(y) * width + x] = v;
+        }
+    return o;
+}
+
+}	// namespace
+
+template <typename T>
+void DFReferenceRayMarch(const T* input, T* output, int width, int height)
+{
+    const int n = 32;
+    const int distance = std::max(width, height);
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++) {
+            const T in = input[size_t(y) * width + x];
+            if (in > 0.0) {
+                output[size_t(y) * width + x] = in;
+                continue;
+            }
+            T p = 0.0;
+            float w0 = 0.0f;
+            for (int i = 0; i < n; i++) {
+                const float rad = float(3.141592653589793238462643383279502884L * 2.0f * i / n);
+                const float step_x = std::cos(rad);
+                const float step_y = std::sin(rad);
+                for (int j = 1; j < distance; j = (j < 16) ? j + 1 : int(j * 1.1f)) {
+                    if ((j < 64) && (i % 2 != 0))
+                        continue;
+                    const float w = 1.0f / float(j);
+                    if (w < w0 * 0.01f)
+                        continue;
+                    const int ix = Clamp(int(x + step_x * j + 0.5f), width);
+                    const int iy = Clamp(int(y + step_y * j + 0.5f), height);
+                    const T v = input[size_t(iy) * width + ix];
+                    if (v == 0.0)
+                        continue;
+                    p += v * w;
+                    w0 += w;
+                    break;
+                }
+            }
+            output[size_t(y) * width + x] = (w0 > 0.0f) ? T(p / w0) : T(0.0);
+        }
+}
+
+template void DFReferenceRayMarch<float>(const float*, float*, int, int);
+template void DFReferenceRayMarch<double>(const double*, double*, int, int);
+
+void DFReferenceThresholdStars(const std::vector<std::vector<double>>& responses, int width, int height, double threshold,
+    std::vector<std::vector<uint8_t>>& masks)
+{
+    double low = 1;
+    double high = 0;
+    for (const std::vector<double>& response : responses) {
+        low = std::min(low, *std::min_element(response.begin(), response.end()));
+        high = std::max(high, *std::max_element(response.begin(), response.end()));
+    }
+    masks.assign(responses.size(), std::vector<uint8_t>(size_t(width) * height));
+    for (size_t c = 0; c < responses.size(); c++)
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++) {
+                double v[9];
+                int k = 0;
+                for (int dy = -1; dy <= 1; dy++)
+                    for (int dx = -1; dx <= 1; dx++) {
+                        const double b = responses[c][size_t(Mirror(y + dy, height)) * width + Mirror(x + dx, width)];
+                        v[k++] = (high > low) ? (b - low) / (high - low) : b;
+                    }
+                std::nth_element(v, v + 4, v + 9);
+                masks[c][size_t(y) * width + x] = v[4] >= threshold;
+            }
+}
+
+void DFReferenceDetectStars(const float* const* planes, int channels, int width, int height, double threshold,
+    std::vector<std::vector<uint8_t>>& masks)
+{
+    std::vector<std::vector<double>> band(channels);
+    for (int c = 0; c < channels; c++)
+        band[c] = BandPass(planes[c], width, height);
+    DFReferenceThresholdStars(band, width, height, threshold, masks);
+}
+
+std::vector<double> DFReferenceMultiscaleResponse(const float* plane, int width, int height)
+{
+    const std::vector<double> a(plane, plane + size_t(width) * height);
+    const std::vector<double> fine = DFReferenceGaussian(a, width, height, 1);
+    const std::vector<double> coarse = DFReferenceGaussian(a, width, height, 8);
+    std::vector<double> response(a.size());
+    for (size_t i = 0; i < response.size(); i++)
+        response[i] = std::min(std::max(fine[i] - coarse[i], 0.0), 1.0);
+    return response;
+}
+
+void DFReferenceStarResponseRange(const float* const* planes, int channels, int width, int height,
+    double& low, double& high)
+{
+    low = 1;
+    high = 0;
+    for (int c = 0; c < channels; c++) {
+        const std::vector<double> band = BandPass(planes[c], width, height);
+        low = std::min(low, *std::min_element(band.begin(), band.end()));
+        high = std::max(high, *std::max_element(band.begin(), band.end()));
+    }
+}
+
+std::vector<uint8_t> DFReferenceDilate(const std::vector<uint8_t>& mask, int width, int height, int diameter)
+{
+    const int r = diameter / 2;
+    std::vector<uint8_t> out(mask.size());
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++) {
+            bool set = false;
+            for (int dy = -r; (dy <= r) && !set; dy++)
+                for (int dx = -r; (dx <= r) && !set; dx++) {
+                    const int X = x + dx;
+                    const int Y = y + dy;
+                    set = (X >= 0) && (X < width) && (Y >= 0) && (Y < height) && (dx * dx + dy * dy <= r * (r + 1)) &&
+                        mask[size_t(Y) * width + X];
+                }
+            out[size_t(y) * width + x] = set;
+        }
+    return out;
+}
+
+std::vector<uint8_t> DFReferenceMedian3x3(const std::vector<uint8_t>& mask, int width, int height)
+{
+    std::vector<uint8_t> out(mask.size());
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++) {
+            int count = 0;
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++)
+                    count += mask[size_t(Mirror(y + dy, height)) * width + Mirror(x + dx, width)];
+            out[size_t(y) * width + x] = count >= 5;
+        }
+    return out;
+}
+
+std::vector<double> DFReferenceMedian3x3(const std::vector<double>& plane, int width, int height)
+{
+    std::vector<double> out(plane.size());
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++) {
+            double v[9];
+            int k = 0;
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++)
+                    v[k++] = plane[size_t(Mirror(y + dy, height)) * width + Mirror(x + dx, width)];
+            std::nth_element(v, v + 4, v + 9);
+            out[size_t(y) * width + x] = v[4];
+        }
+    return out;
+}
+
+std::vector<double> DFReferenceGaussian(const std::vector<double>& plane, int width, int height, double sigma)
+{
+    return Separable(plane, width, height, GaussianKernel(sigma));
+}
+
+std::vector<double> DFReferenceVariableShape(const std::vector<double>& plane, int width, int height, double sigma,
+    double shape)
+{
+    return Separable(plane, width, height, VariableShapeKernel(sigma, shape));
+}
+
+}	// namespace pcl
@@ -0,0 +1,66 @@
+#ifndef __DustFreeReference_h
+#define __DustFreeReference_h
+
+#include <cstdint>
+#include <vector>
+
+namespace pcl
+{
+
+// Straightforward implementations of what the kernels compute, kept as the
+// definition their optimized versions are checked against. They favour
+// obviousness over speed and work in double precision where it matters.
+
+// The ray march of the original inpaint<P>, unchanged but for the plane
+// access: 32 rays from each hole, odd rays starting at 64 pixels, unit steps
+// up to 16 and a 1.1 progression beyond, clamped to the borders; the first
+// valid sample of each ray is averaged with a 1/distance weight, and steps
+// below 1% of the weight gathered so far are skipped.
+template <typename T>
+void DFReferenceRayMarch(const T* input, T* output, int width, int height);
+
+// Star masks as DFDetectStars defines them: the B3 spline scale 1 minus scale
+// 4 of each channel, clipped to [0,1] and normalized to the range of all
+// channels, 3x3 median filtered and thresholded; borders mirrored. masks[c]
+// holds one byte per pixel, 1 for a star.
+void DFReferenceDetectStars(const float* const* planes, int channels, int width, int height, double threshold,
+    std::vector<std::vector<uint8_t>>& masks);
+
+// Star masks of the default detector from its clipped response: normalized to
+// the range of all channels, 3x3 median filtered and thresholded; borders
+// mirrored. DFReferenceDetectStars is this on the band-pass response.
+void DFReferenceThresholdStars(const std::vector<std::vector<double>>& responses, int width, int height, double threshold,
+    std::vector<std::vector<uint8_t>>& masks);
+
+// Stand-in for the wavelet layers 1 to 3 of the multiscale linear transform,
+// which is PCL's: the Gaussian of sigma 1 minus that of sigma 8, clipped to
+// [0,1].
+std::vector<double> DFReferenceMultiscaleResponse(const float* plane, int width, int height);
+
+// Range of the clipped band-pass response of all channels.
+void DFReferenceStarResponseRange(const float* const* planes, int channels, int width, int height,
+    double& low, double& high);
+
+// Dilation by the disc dx^2 + dy^2 <= r*(r + 1), r = diameter/2, by brute force.
+std::vector<uint8_t> DFReferenceDilate(const std::vector<uint8_t>& mask, int width, int height, int diameter);
+
+// Majority of the 3x3 neighbourhood, borders mirrored.
+std::vector<uint8_t> DFReferenceMedian3x3(const std::vector<uint8_t>& mask, int width, int height);
+
+// Median of the 3x3 neighbourhood, borders mirrored.
+std::vector<double> DFReferenceMedian3x3(const std::vector<double>& plane, int width, int height);
+
+// Direct convolution with a sampled, normalized Gaussian truncated at five
+// standard deviations; edges extended with their end samples.
+std::vector<double> DFReferenceGaussian(const std::vector<double>& plane, int width, int height, double sigma);
+
+// Direct convolution with the variable shape kernel exp(-|x|^shape/(shape
+// sigma^shape)) of the FFT smoothing, applied along rows and columns and
+// truncated where it falls below 1% of its peak; edges extended with their end
+// samples.
+std::vector<double> DFReferenceVariableShape(const std::vector<double>& plane, int width, int height, double sigma,
+    double shape);
+
+}	// namespace pcl
+
+#endif	// __DustFreeReference_h
@@ -0,0 +1,1028 @@
+// Equivalence and performance tests of the pipeline kernels.
+//
+// The equivalence tests run every inpainting engine, the star detection and
+// its mask operations, and the smoothing against the reference code of
+// DustFreeReference on a fixed synthetic corpus, within stated error bounds.
+// The performance tests time the kernels on one thread and fail when one is
+// slower than its stored baseline by more than the tolerance.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DustFreeBitMask.h"
+#include "DustFreeDistanceTransform.h"
+#include "DustFreeInpaint.h"
+#include "DustFreeParallel.h"
+#include "DustFreePipeline.h"
+#include "DustFreeProfile.h"
+#include "DustFreeReference.h"
+#include "DustFreeRegions.h"
+#include "DustFreeResample.h"
+#include "DustFreeShapes.h"
+#include "DustFreeSmoothing.h"
+#include "DustFreeStarDetection.h"
+#include "DustFreeSynthetic.h"
+
+using namespace pcl;
+
+namespace
+{
+
+int failures = 0;
+bool verbose = false;
+
+void Fail(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    std::printf("  FAIL: ");
+    std::vprintf(format, args);
+    std::printf("\n");
+    va_end(args);
+    failures++;
+}
+
+// Checks a measured error against its bound.
+void ExpectBelow(const std::string& what, double error, double bound)
+{
+    if (!(error <= bound))
+        Fail("%s: error %.3g exceeds %.3g", what.c_str(), error, bound);
+    else if (verbose)
+        std::printf("  %-56s %.3g (bound %.3g)\n", what.c_str(), error, bound);
+}
+
+template <typename T>
+using Planes = std::vector<std::vector<T>>;
+
+template <typename T>
+std::vector<const T*> Inputs(const Planes<T>& planes)
+{
+    std::vector<const T*> p;
+    for (const std::vector<T>& plane : planes)
+        p.push_back(plane.data());
+    return p;
+}
+
+template <typename T>
+std::vector<T*> Outputs(Planes<T>& planes)
+{
+    std::vector<T*> p;
+    for (std::vector<T>& plane : planes)
+        p.push_back(plane.data());
+    return p;
+}
+
+std::vector<uint8_t> Bytes(const DFBitMask& mask)
+{
+    std::vector<uint8_t> b(size_t(mask.Width()) * mask.Height());
+    for (int y = 0; y < mask.Height(); y++)
+        for (int x = 0; x < mask.Width(); x++)
+            b[size_t(y) * mask.Width() + x] = mask.Get(x, y);
+    return b;
+}
+
+// ----------------------------------------------------------------------------
+// Corpus
+
+// A synthetic frame and the background the pipeline would inpaint from it:
+// stars, dilated by the default diffusion distance, and dust motes are holes.
+struct CorpusFrame
+{
+    std::string name;
+    DFSyntheticFrame frame;
+    Planes<float> holed;
+};
+
+const double StarThreshold = 1.0e-2;
+const int StarDilation = 2 * 5 + 3;
+
+CorpusFrame MakeCorpusFrame(const char* name, int width, int height, int channels, uint32_t seed)
+{
+    DFSyntheticOptions options;
+    options.width = width;
+    options.height = height;
+    options.channels = channels;
+    options.seed = seed;
+    CorpusFrame f;
+    f.name = name;
+    f.frame = DFMakeSyntheticFrame(options);
+    f.holed = f.frame.planes;
+    std::vector<DFBitMask> stars(channels);
+    DFDetectStars(f.frame.Planes().data(), channels, width, height, StarThreshold, stars.data());
+    DFBitMask dust;
+    dust.Binarize(f.frame.dustMask.data(), width, height, 0.5f);
+    dust.Invert();
+    for (int c = 0; c < channels; c++) {
+        stars[c].Dilate(StarDilation);
+        stars[c].Invert();
+        stars[c].Select(f.holed[c].data());
+        dust.Select(f.holed[c].data());
+    }
+    return f;
+}
+
+const std::vector<CorpusFrame>& Corpus()
+{
+    static std::vector<CorpusFrame> corpus;
+    if (corpus.empty()) {
+        corpus.push_back(MakeCorpusFrame("rgb 256x192", 256, 192, 3, 1));
+        corpus.push_back(MakeCorpusFrame("gray 301x257", 301, 257, 1, 2));
+        corpus.push_back(MakeCorpusFrame("rgb 97x61", 97, 61, 3, 3));
+        corpus.push_back(MakeCorpusFrame("gray 7x5", 7, 5, 1, 4));
+        corpus.push_back(MakeCorpusFrame("rgb 1x83", 1, 83, 3, 5));
+
+        // Holes along a border, and a frame without valid samples.
+        CorpusFrame border = MakeCorpusFrame("gray 130x70, left column dark", 130, 70, 1, 6);
+        for (int y = 0; y < 70; y++)
+            border.holed[0][size_t(y) * 130] = 0;
+        corpus.push_back(border);
+        CorpusFrame empty = MakeCorpusFrame("rgb 33x17, all holes", 33, 17, 3, 7);
+        for (std::vector<float>& plane : empty.holed)
+            std::fill(plane.begin(), plane.end(), 0.0f);
+        corpus.push_back(empty);
+    }
+    return corpus;
+}
+
+// ----------------------------------------------------------------------------
+// Inpainting
+
+struct InpaintError
+{
+    double max = 0;         // largest absolute difference over the holes
+    double mean = 0;        // mean absolute difference over the holes
+    size_t holes = 0;
+    size_t changedValid = 0;
+};
+
+template <typename T>
+InpaintError CompareFill(const std::vector<T>& input, const std::vector<T>& reference, const std::vector<T>& output)
+{
+    InpaintError e;
+    double sum = 0;
+    for (size_t i = 0; i < input.size(); i++)
+        if (input[i] > 0) {
+            if (output[i] != input[i])
+                e.changedValid++;
+        } else {
+            const double d = std::fabs(double(output[i]) - double(reference[i]));
+            e.max = std::max(e.max, d);
+            sum += d;
+            e.holes++;
+        }
+    e.mean = (e.holes > 0) ? sum / e.holes : 0;
+    return e;
+}
+
+template <typename T>
+Planes<T> Convert(const Planes<float>& planes)
+{
+    Planes<T> p;
+    for (const std::vector<float>& plane : planes)
+        p.emplace_back(plane.begin(), plane.end());
+    return p;
+}
+
+template <typename T>
+void CheckRayMarch(const CorpusFrame& f, const char* type, double bound)
+{
+    const int w = f.frame.width;
+    const int h = f.frame.height;
+    const int channels = f.frame.channels;
+    const Planes<T> input = Convert<T>(f.holed);
+    Planes<T> reference(channels, std::vector<T>(input[0].size()));
+    for (int c = 0; c < channels; c++)
+        DFReferenceRayMarch(input[c].data(), reference[c].data(), w, h);
+
+    // Every instruction set the processor supports is checked, down to the
+    // scalar march. All of them take the same steps, so their counts match.
+    static const char* const simdNames[] = { "", " AVX2", " AVX-512" };
+    const DFSimd supported = DFRayMarchSimd();
+    DFInpaintCounts first[2];
+    for (int simd = int(supported); simd >= int(DFSimd::Scalar); simd--) {
+        DFLimitRayMarchSimd(DFSimd(simd));
+        for (const bool tiled : { false, true })
+            for (const bool fused : { false, true }) {
+                Planes<T> output(channels, std::vector<T>(input[0].size()));
+                DFInpaintCounter counter;
+                if (fused)
+                    DFInpaintRayMarch(Inputs(input).data(), Outputs(output).data(), channels, w, h, tiled, &counter);
+                else
+                    for (int c = 0; c < channels; c++)
+                        DFInpaintRayMarch(input[c].data(), output[c].data(), w, h, tiled, &counter);
+                const std::string run = f.name + ", ray march " + type + simdNames[simd] + (fused ? " fused" : "") +
+                    (tiled ? " tiled" : "");
+                for (int c = 0; c < channels; c++) {
+                    const InpaintError e = CompareFill(input[c], reference[c], output[c]);
+                    const std::string what = run + ", channel " + std::to_string(c);
+                    if (e.changedValid > 0)
+                        Fail("%s: %zu valid samples changed", what.c_str(), e.changedValid);
+                    ExpectBelow(what, e.max, bound);
+                }
+                const DFInpaintCounts counts = counter.Totals();
+                if ((simd == int(supported)) && !tiled)
+                    first[fused] = counts;
+                else if ((counts.holePixels != first[fused].holePixels) || (counts.raySteps != first[fused].raySteps) ||
+                         (counts.earlyExits != first[fused].earlyExits))
+                    Fail("%s: counted %llu hole pixels, %llu steps, %llu early exits instead of %llu, %llu, %llu",
+                        run.c_str(), (unsigned long long)counts.holePixels, (unsigned long long)counts.raySteps,
+                        (unsigned long long)counts.earlyExits, (unsigned long long)first[fused].holePixels,
+                        (unsigned long long)first[fused].raySteps, (unsigned long long)first[fused].earlyExits);
+            }
+    }
+    DFLimitRayMarchSimd(DFSimd::AVX512);
+}
+
+// The other engines are approximations of the ray march, not replacements
+// for it: on the smooth sky of the corpus their fills must stay close to the
+// reference on average and nowhere far from it.
+template <typename T>
+void CheckApproximation(const CorpusFrame& f, const char* engine, void (*inpaint)(const T*, T*, int, int, DFInpaintCounter*),
+    double meanBound, double maxBound)
+{
+    const int w = f.frame.width;
+    const int h = f.frame.height;
+    const Planes<T> input = Convert<T>(f.holed);
+    for (int c = 0; c < f.frame.channels; c++) {
+        std::vector<T> reference(input[c].size());
+        std::vector<T> output(input[c].size());
+        DFReferenceRayMarch(input[c].data(), reference.data(), w, h);
+        DFInpaintCounter counter;
+        inpaint(input[c].data(), output.data(), w, h, &counter);
+        const InpaintError e = CompareFill(input[c], reference, output);
+        const std::string what = f.name + ", " + engine + ", channel " + std::to_string(c);
+        if (e.changedValid > 0)
+            Fail("%s: %zu valid samples changed", what.c_str(), e.changedValid);
+        const uint64_t holes = uint64_t(std::count_if(input[c].begin(), input[c].end(), [](T v) { return !(v > 0); }));
+        if (counter.Totals().holePixels != holes)
+            Fail("%s: counted %llu hole pixels instead of %llu", what.c_str(),
+                (unsigned long long)counter.Totals().holePixels, (unsigned long long)holes);
+        ExpectBelow(what + ", mean", e.mean, meanBound);
+        ExpectBelow(what + ", max", e.max, maxBound);
+    }
+}
+
+void TestInpainting()
+{
+    for (const CorpusFrame& f : Corpus()) {
+        CheckRayMarch<float>(f, "float", 1.0e-6);
+        CheckRayMarch<double>(f, "double", 1.0e-6);
+        CheckApproximation<float>(f, "nearest sample", DFInpaintNearestSample<float>, 0.01, 0.15);
+        CheckApproximation<float>(f, "push-pull", DFInpaintPushPull<float>, 0.01, 0.15);
+
+        // Frames past 2^31 pixels take 64-bit sites, which must find the same
+        // nearest samples as the 32-bit ones.
+        const int w = f.frame.width;
+        const int h = f.frame.height;
+        const float* plane = f.frame.Planes()[0];
+        auto valid = [plane, w](int x, int y) { return plane[size_t(y) * w + x] > 0; };
+        std::vector<int32_t> sites32(size_t(w) * h);
+        std::vector<int64_t> sites64(size_t(w) * h);
+        DFFeatureTransform(w, h, valid, sites32.data());
+        DFFeatureTransform(w, h, valid, sites64.data());
+        if (!std::equal(sites32.begin(), sites32.end(), sites64.begin(), [](int32_t a, int64_t b) { return a == b; }))
+            Fail("%s: 64-bit feature transform differs from the 32-bit one", f.name.c_str());
+    }
+    // Past 8192 columns the reference rounds x plus the ray offset in single
+    // precision, the kernel the offset alone, and a long ray can probe the
+    // next pixel: across a hole 400 columns wide, some rays reach step 179,
+    // and the fill moves by the difference of neighbouring sky samples.
+    CorpusFrame wide = MakeCorpusFrame("gray 16500x48, wide hole", 16500, 48, 1, 8);
+    for (int y = 0; y < 48; y++)
+        std::fill_n(wide.holed[0].begin() + size_t(y) * 16500 + 12000, 400, 0.0f);
+    CheckRayMarch<float>(wide, "float", 1.0e-3);
+    CheckRayMarch<double>(wide, "double", 1.0e-3);
+    if (DFSiteIndexFits<int32_t>(65536, 32768) || !DFSiteIndexFits<int64_t>(65536, 32768))
+        Fail("site index width misjudged for a 2^31 pixel frame");
+}
+
+// ----------------------------------------------------------------------------
+// Star detection
+
+void TestStarDetection()
+{
+    for (const CorpusFrame& f : Corpus()) {
+        const int w = f.frame.width;
+        const int h = f.frame.height;
+        const int channels = f.frame.channels;
+        const std::vector<const float*> planes = f.frame.Planes();
+
+        // Samples within rounding of the threshold may go either way: the
+        // kernel works in the precision of the image, the reference in double.
+        std::vector<std::vector<uint8_t>> reference;
+        DFReferenceDetectStars(planes.data(), channels, w, h, StarThreshold, reference);
+        std::vector<DFBitMask> masks(channels);
+        DFDetectStars(planes.data(), channels, w, h, StarThreshold, masks.data());
+        size_t mismatches = 0;
+        for (int c = 0; c < channels; c++) {
+            const std::vector<uint8_t> bytes = Bytes(masks[c]);
+            for (size_t i = 0; i < bytes.size(); i++)
+                mismatches += bytes[i] != reference[c][i];
+        }
+        ExpectBelow(f.name + ", star detection, mismatched pixels", double(mismatches) / (size_t(w) * h * channels), 1.0e-3);
+
+        // The default detector median filters the multiscale response and
+        // binarizes it at the level that normalizes to the threshold, rather
+        // than normalizing first. The transform is PCL's and a stand-in
+        // response takes its place.
+        std::vector<std::vector<double>> responses(channels);
+        double responseLow = 1;
+        double responseHigh = 0;
+        for (int c = 0; c < channels; c++) {
+            responses[c] = DFReferenceMultiscaleResponse(planes[c], w, h);
+            responseLow = std::min(responseLow, *std::min_element(responses[c].begin(), responses[c].end()));
+            responseHigh = std::max(responseHigh, *std::max_element(responses[c].begin(), responses[c].end()));
+        }
+        DFReferenceThresholdStars(responses, w, h, StarThreshold, reference);
+        const double level = (responseHigh > responseLow) ? responseLow + StarThreshold * (responseHigh - responseLow) : StarThreshold;
+        mismatches = 0;
+        for (int c = 0; c < channels; c++) {
+            const std::vector<double> median = DFReferenceMedian3x3(responses[c], w, h);
+            const std::vector<float> samples(median.begin(), median.end());
+            DFBitMask mask;
+            mask.Binarize(samples.data(), w, h, float(level));
+            const std::vector<uint8_t> bytes = Bytes(mask);
+            for (size_t i = 0; i < bytes.size(); i++)
+                mismatches += bytes[i] != reference[c][i];
+        }
+        ExpectBelow(f.name + ", multiscale star detection, mismatched pixels", double(mismatches) / (size_t(w) * h * channels), 1.0e-3);
+
+        // The range measured over the cores of overlapping windows is the
+        // range of the whole image.
+        double low, high;
+        DFReferenceStarResponseRange(planes.data(), channels, w, h, low, high);
+        const int margin = 32;
+        const int tw = std::max(1, (w + 1) / 2);
+        const int th = std::max(1, (h + 1) / 2);
+        double tiledLow = 1;
+        double tiledHigh = 0;
+        for (int y = 0; y < h; y += th)
+            for (int x = 0; x < w; x += tw) {
+                const DFRect window{ std::max(0, x - margin), std::max(0, y - margin),
+                    std::min(w, x + tw + margin), std::min(h, y + th + margin) };
+                Planes<float> crop(channels);
+                for (int c = 0; c < channels; c++)
+                    for (int yy = window.y0; yy < window.y1; yy++)
+                        crop[c].insert(crop[c].end(), planes[c] + size_t(yy) * w + window.x0, planes[c] + size_t(yy) * w + window.x1);
+                const DFRect core{ x - window.x0, y - window.y0, std::min(w, x + tw) - window.x0, std::min(h, y + th) - window.y0 };
+                DFStarResponseRange(Inputs(crop).data(), channels, window.Width(), window.Height(), core, tiledLow, tiledHigh);
+            }
+        ExpectBelow(f.name + ", star response range, tiled", std::max(std::fabs(tiledLow - low), std::fabs(tiledHigh - high)), 1.0e-6);
+
+        // Dust regions detect stars on windows around the dust, thresholded
+        // at the range of the whole image: inside the core of each window the
+        // stars are those of the whole image, whatever the window holds.
+        double imageLow = 1;
+        double imageHigh = 0;
+        DFStarResponseRange(planes.data(), channels, w, h, DFRect{ 0, 0, w, h }, imageLow, imageHigh);
+        const double range[2] = { imageLow, imageHigh };
+        size_t regionMismatches = 0;
+        size_t regionPixels = 0;
+        for (int r = 0; r < 4; r++) {
+            const DFRect core{ (r * w) / 5, (r * h) / 7, std::min(w, (r * w) / 5 + std::max(1, w / 6)), std::min(h, (r * h) / 7 + std::max(1, h / 5)) };
+            const DFRect window{ std::max(0, core.x0 - margin), std::max(0, core.y0 - margin),
+                std::min(w, core.x1 + margin), std::min(h, core.y1 + margin) };
+            Planes<float> crop(channels);
+            for (int c = 0; c < channels; c++)
+                for (int yy = window.y0; yy < window.y1; yy++)
+                    crop[c].insert(crop[c].end(), planes[c] + size_t(yy) * w + window.x0, planes[c] + size_t(yy) * w + window.x1);
+            std::vector<DFBitMask> regionMasks(channels);
+            DFDetectStars(Inputs(crop).data(), channels, window.Width(), window.Height(), StarThreshold, regionMasks.data(), range);
+            for (int c = 0; c < channels; c++)
+                for (int y = core.y0; y < core.y1; y++)
+                    for (int x = core.x0; x < core.x1; x++) {
+                        regionMismatches += masks[c].Get(x, y) != regionMasks[c].Get(x - window.x0, y - window.y0);
+                        regionPixels++;
+                    }
+        }
+        ExpectBelow(f.name + ", star detection, dust regions against the whole image",
+            double(regionMismatches) / std::max<size_t>(1, regionPixels), 1.0e-4);
+    }
+}
+
+// Random masks of all widths around the word size, and sparse ones for the
+// large discs that go through the distance transform.
+void TestMaskOperations()
+{
+    uint32_t state = 12345;
+    auto next = [&]() {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    };
+    for (int trial = 0; trial < 60; trial++) {
+        const int w = 1 + int(next() % 200);
+        const int h = 1 + int(next() % 40);
+        const int diameter = (trial < 45) ? int(next() % 23) : 65 + int(next() % 100);
+        const unsigned density = (trial < 45) ? 7 : 300;
+        std::vector<float> plane(size_t(w) * h);
+        for (float& v : plane)
+            v = (next() % density == 0) ? 1.0f : 0.0f;
+        DFBitMask mask;
+        mask.Binarize(plane.data(), w, h, 0.5f);
+        const std::vector<uint8_t> bytes = Bytes(mask);
+
+        DFBitMask dilated = mask;
+        dilated.Dilate(diameter);
+        if (Bytes(dilated) != DFReferenceDilate(bytes, w, h, diameter))
+            Fail("dilation of a %dx%d mask by %d differs from the reference", w, h, diameter);
+
+        for (float& v : plane)
+            v = (next() % 2 == 0) ? 1.0f : 0.0f;
+        mask.Binarize(plane.data(), w, h, 0.5f);
+        DFBitMask median = mask;
+        median.Median3x3();
+        if (Bytes(median) != DFReferenceMedian3x3(Bytes(mask), w, h))
+            Fail("3x3 median of a %dx%d mask differs from the reference", w, h);
+    }
+    if (verbose)
+        std::printf("  60 dilations and medians compared\n");
+}
+
+// ----------------------------------------------------------------------------
+// Smoothing
+
+// The recursive filter approximates the Gaussian to a few percent of the
+// peak of its impulse response, less as sigma grows. On smooth data, as the
+// corrections are, it is much closer away from the edges; near them its
+// initialization assumes a constant extension and departs from the clamped
+// convolution where the data has a slope, but a constant stays constant.
+// Sigma 158 is the equivalent of smoothness 10: the large sigmas get frames
+// with five sigmas around the impulse, whose reference is the product of the
+// row and column references, and their sky is checked only against the
+// double precision filter, which is where single precision state drifts.
+void TestSmoothing()
+{
+    const struct
+    {
+        double sigma;
+        double impulseBound;
+        int w;
+        int h;
+    } cases[] = { { 1.5, 0.15, 181, 127 }, { 4.0, 0.07, 181, 127 }, { 12.0, 0.04, 181, 127 },
+                  { 80.0, 0.04, 881, 827 }, { 158.0, 0.04, 1721, 1613 } };
+    for (const auto& test : cases) {
+        const double sigma = test.sigma;
+        const int w = test.w;
+        const int h = test.h;
+        const std::string name = "recursive Gaussian, sigma " + std::to_string(sigma).substr(0, 4);
+
+        std::vector<double> impulse(size_t(w) * h, 0.0);
+        impulse[size_t(h / 2) * w + w / 2] = 1;
+        std::vector<double> recursive = impulse;
+        DFRecursiveGaussian(recursive.data(), w, h, sigma);
+        std::vector<double> row(w, 0.0);
+        std::vector<double> column(h, 0.0);
+        row[w / 2] = 1;
+        column[h / 2] = 1;
+        row = DFReferenceGaussian(row, w, 1, sigma);
+        column = DFReferenceGaussian(column, 1, h, sigma);
+        const double peak = row[w / 2] * column[h / 2];
+        double error = 0;
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++)
+                error = std::max(error, std::fabs(recursive[size_t(y) * w + x] - row[x] * column[y]));
+        ExpectBelow(name + ", impulse", error / peak, test.impulseBound);
+
+        DFSyntheticOptions options;
+        options.width = w;
+        options.height = h;
+        options.channels = 1;
+        options.starDensity = 0;
+        const std::vector<float> field = DFMakeSyntheticFrame(options).planes[0];
+        recursive.assign(field.begin(), field.end());
+        DFRecursiveGaussian(recursive.data(), w, h, sigma);
+        std::vector<float> single(field);
+        DFRecursiveGaussian(single.data(), w, h, sigma);
+        const double range = *std::max_element(recursive.begin(), recursive.end()) -
+            *std::min_element(recursive.begin(), recursive.end());
+        double precision = 0;
+        for (size_t i = 0; i < single.size(); i++)
+            precision = std::max(precision, std::fabs(double(single[i]) - recursive[i]));
+        ExpectBelow(name + ", sky, float against double", precision / range, 1.0e-4);
+
+        if (sigma <= 12) {
+            const std::vector<double> filtered = DFReferenceGaussian(std::vector<double>(field.begin(), field.end()), w, h, sigma);
+            const int margin = int(3 * sigma);
+            double interior = 0;
+            double edges = 0;
+            for (int y = 0; y < h; y++)
+                for (int x = 0; x < w; x++) {
+                    const size_t i = size_t(y) * w + x;
+                    const double d = std::fabs(recursive[i] - filtered[i]);
+                    if ((x >= margin) && (x < w - margin) && (y >= margin) && (y < h - margin))
+                        interior = std::max(interior, d);
+                    else
+                        edges = std::max(edges, d);
+                }
+            ExpectBelow(name + ", sky, interior", interior / range, 0.01);
+            ExpectBelow(name + ", sky, edges", edges / range, 0.2);
+        }
+
+        std::vector<float> constant(size_t(w) * h, 0.37f);
+        DFRecursiveGaussian(constant.data(), w, h, sigma);
+        error = 0;
+        for (float v : constant)
+            error = std::max(error, std::fabs(double(v) - 0.37));
+        ExpectBelow(name + ", constant", error, 1.0e-6);
+    }
+
+    // The recursive method stands in for the variable shape kernel of the FFT
+    // smoothing with the Gaussian of the same variance: away from the edges,
+    // within 1% of the range of the sky. Smoothness 9 smooths with the
+    // equivalent of sigma 93.
+    for (int smoothness : { 3, 5, 9 }) {
+        const double sigma = std::pow(1.7, smoothness);
+        const double equivalent = DFEquivalentGaussianSigma(sigma, 5.0);
+        const int support = int(sigma * std::pow(5 * std::log(100.0), 0.2));
+        const int margin = support + int(3 * equivalent);
+        const std::string name = "recursive Gaussian against the variable shape kernel, smoothness " + std::to_string(smoothness);
+
+        DFSyntheticOptions options;
+        options.width = 2 * margin + 141;
+        options.height = 2 * margin + 87;
+        options.channels = 1;
+        options.starDensity = 0;
+        const int w = options.width;
+        const int h = options.height;
+        const std::vector<float> field = DFMakeSyntheticFrame(options).planes[0];
+        std::vector<double> recursive(field.begin(), field.end());
+        DFRecursiveGaussian(recursive.data(), w, h, equivalent);
+        const std::vector<double> filtered = DFReferenceVariableShape(std::vector<double>(field.begin(), field.end()), w, h, sigma, 5.0);
+        const double range = *std::max_element(field.begin(), field.end()) - *std::min_element(field.begin(), field.end());
+        double error = 0;
+        for (int y = margin; y < h - margin; y++)
+            for (int x = margin; x < w - margin; x++) {
+                const size_t i = size_t(y) * w + x;
+                error = std::max(error, std::fabs(recursive[i] - filtered[i]));
+            }
+        ExpectBelow(name + ", interior", error / range, 0.01);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Resampling
+
+// Integer and 64-bit images go to the pipeline as single precision block
+// averages, integers normalized to [0,1]; integers take the correction back
+// rounded to the nearest sample and clipped.
+void TestResampling()
+{
+    uint32_t state = 777;
+    auto next = [&]() {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    };
+    for (int trial = 0; trial < 30; trial++) {
+        const int w = 1 + int(next() % 90);
+        const int h = 1 + int(next() % 70);
+        const int factor = 1 + int(next() % 5);
+        std::vector<uint16_t> image(size_t(w) * h);
+        for (uint16_t& v : image)
+            v = uint16_t(next() % 65536);
+
+        const int dw = DFDownsampledSize(w, factor);
+        const int dh = DFDownsampledSize(h, factor);
+        std::vector<float> working(size_t(dw) * dh);
+        DFDownsample(image.data(), w, h, factor, working.data());
+        std::vector<double> wide(image.begin(), image.end());
+        for (double& v : wide)
+            v /= 65535;
+        std::vector<float> narrowed(working.size());
+        DFDownsample(wide.data(), w, h, factor, narrowed.data());
+        double error = 0;
+        double narrowing = 0;
+        for (int y = 0; y < dh; y++)
+            for (int x = 0; x < dw; x++) {
+                double sum = 0;
+                int n = 0;
+                for (int i = y * factor; i < std::min(h, (y + 1) * factor); i++)
+                    for (int j = x * factor; j < std::min(w, (x + 1) * factor); j++, n++)
+                        sum += image[size_t(i) * w + j];
+                error = std::max(error, std::fabs(working[size_t(y) * dw + x] - sum / n / 65535));
+                narrowing = std::max(narrowing, std::fabs(narrowed[size_t(y) * dw + x] - sum / n / 65535));
+            }
+        const std::string size = std::to_string(w) + "x" + std::to_string(h);
+        ExpectBelow("block average of a " + size + " UInt16 plane by " + std::to_string(factor), error, 1.0e-6);
+        ExpectBelow("block average of a " + size + " 64-bit plane by " + std::to_string(factor), narrowing, 1.0e-6);
+
+        // The correction is applied as to a float copy of the image, within a
+        // unit of the last place for the rounding of the float copy.
+        std::vector<float> correction(working.size());
+        for (float& v : correction)
+            v = (int(next() % 2001) - 1000) * 1.0e-4f;
+        std::vector<uint16_t> corrected(image);
+        DFAddUpsampled(correction.data(), dw, dh, corrected.data(), w, h);
+        std::vector<float> reference(image.begin(), image.end());
+        for (float& v : reference)
+            v /= 65535;
+        DFAddUpsampled(correction.data(), dw, dh, reference.data(), w, h);
+        double units = 0;
+        for (size_t i = 0; i < image.size(); i++) {
+            const double expected = std::min(std::max(std::floor(double(reference[i]) * 65535 + 0.5), 0.0), 65535.0);
+            units = std::max(units, std::fabs(corrected[i] - expected));
+        }
+        ExpectBelow("correction of a " + size + " UInt16 plane, units", units, 1);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Dust shapes
+
+// Rasterized shapes against the point sampling of their definition, at
+// several scales and window offsets; pixels within rounding of an edge may go
+// either way. Every pixel set lies within the bounds of its shape.
+void TestDustShapes()
+{
+    uint32_t state = 4242;
+    auto next = [&]() {
+        state = state * 1664525u + 1013904223u;
+        return (state >> 8) / double(1 << 24);
+    };
+    for (int trial = 0; trial < 40; trial++) {
+        DFDustShape shape;
+        shape.x = 20 + 160 * next();
+        shape.y = 20 + 100 * next();
+        shape.radius = 2 + 40 * next();
+        shape.innerRadius = (trial % 3 == 0) ? 0.0 : shape.radius * next();
+        shape.axisRatio = (trial % 2 == 0) ? 1.0 : 0.2 + 0.8 * next();
+        shape.angle = 360 * next();
+        shape.feather = (trial % 4 == 0) ? 0.0 : 6 * next();
+        const int scale = 1 + trial % 4;
+        const int x0 = (trial % 5) * 7;
+        const int y0 = (trial % 3) * 11;
+        const int w = (200 - x0) / scale;
+        const int h = (150 - y0) / scale;
+        DFBitMask mask(w, h);
+        DFRasterizeShapes(&shape, 1, x0, y0, scale, mask);
+
+        const double theta = shape.angle * 3.14159265358979323846 / 180;
+        const double outer = shape.radius + shape.feather / 2;
+        const double inner = (shape.innerRadius > 0) ? std::max(shape.innerRadius - shape.feather / 2, 0.0) : 0.0;
+        const DFRect bounds = DFShapeBounds(shape);
+        size_t mismatches = 0;
+        size_t outside = 0;
+        for (int j = 0; j < h; j++)
+            for (int i = 0; i < w; i++) {
+                const double dx = x0 + (i + 0.5) * scale - shape.x;
+                const double dy = y0 + (j + 0.5) * scale - shape.y;
+                const double u = dx * std::cos(theta) + dy * std::sin(theta);
+                const double v = (-dx * std::sin(theta) + dy * std::cos(theta)) / shape.axisRatio;
+                const double rho = std::sqrt(u * u + v * v);
+                const bool set = mask.Get(i, j);
+                if ((std::fabs(rho - outer) > 1.0e-6) && ((inner == 0) || (std::fabs(rho - inner) > 1.0e-6)))
+                    mismatches += set != ((rho <= outer) && ((inner == 0) || (rho >= inner)));
+                if (set) {
+                    const double px = x0 + (i + 0.5) * scale;
+                    const double py = y0 + (j + 0.5) * scale;
+                    outside += (px < bounds.x0) || (px > bounds.x1) || (py < bounds.y0) || (py > bounds.y1);
+                }
+            }
+        if (mismatches > 0)
+            Fail("shape %d at 1:%d: %zu pixels differ from the point sampling", trial, scale, mismatches);
+        if (outside > 0)
+            Fail("shape %d at 1:%d: %zu pixels out of its bounds", trial, scale, outside);
+    }
+    if (verbose)
+        std::printf("  40 shapes compared\n");
+
+    // A preview starts at its corner in the main image, where the shapes are
+    // given. The dust regions of the preview hold all the pixels the shapes
+    // set in it, and drawn from the corner of each region, as the pipeline
+    // draws them, they are the pixels of the whole preview.
+    const int px = 123;
+    const int py = 77;
+    const int pw = 180;
+    const int ph = 130;
+    std::vector<DFDustShape> shapes;
+    for (int n = 0; n < 12; n++) {
+        DFDustShape shape;
+        shape.x = 400 * next();
+        shape.y = 300 * next();
+        shape.radius = 3 + 25 * next();
+        shape.axisRatio = 0.3 + 0.7 * next();
+        shape.angle = 180 * next();
+        shapes.push_back(shape);
+    }
+    DFBitMask preview(pw, ph);
+    DFRasterizeShapes(shapes.data(), shapes.size(), px, py, 1, preview);
+    const std::vector<DFRect> regions = DFShapeComponents(shapes.data(), shapes.size(), px, py, pw, ph);
+    std::vector<uint8_t> covered(size_t(pw) * ph, 0);
+    size_t misplaced = 0;
+    for (const DFRect& r : regions) {
+        DFBitMask region(r.Width(), r.Height());
+        DFRasterizeShapes(shapes.data(), shapes.size(), px + r.x0, py + r.y0, 1, region);
+        for (int y = 0; y < r.Height(); y++)
+            for (int x = 0; x < r.Width(); x++) {
+                misplaced += region.Get(x, y) != preview.Get(r.x0 + x, r.y0 + y);
+                covered[size_t(r.y0 + y) * pw + r.x0 + x] |= region.Get(x, y);
+            }
+    }
+    if (misplaced > 0)
+        Fail("dust regions of a preview: %zu pixels drawn out of place", misplaced);
+    if (covered != Bytes(preview))
+        Fail("dust regions of a preview miss pixels of its shapes");
+
+    const std::string text = "# x, y, radius, inner, ratio, angle, feather\n"
+                             "10, 20, 5\n"
+                             "\n"
+                             "1.5 2.5 8 3 0.5 30 2\n";
+    std::vector<DFDustShape> parsed;
+    if ((DFParseShapes(text.data(), text.size(), parsed) != 0) || (parsed.size() != 2) ||
+        (parsed[0].x != 10) || (parsed[0].radius != 5) || (parsed[0].axisRatio != 1) ||
+        (parsed[1].innerRadius != 3) || (parsed[1].angle != 30) || (parsed[1].feather != 2))
+        Fail("shape list not parsed as written");
+    const std::string bad = "10 20 5\n10 20\n";
+    parsed.clear();
+    if (DFParseShapes(bad.data(), bad.size(), parsed) != 2)
+        Fail("short shape line not reported");
+    for (const char* line : { "10 20 -5", "10 20 5 -1", "10 20 5 5", "10 20 5 6", "10 20 5 0 1.5", "10 20 5 0 0.005" }) {
+        const std::string outOfRange = std::string("# header\n10 20 5 2 0.5\n") + line + "\n";
+        parsed.clear();
+        if (DFParseShapes(outOfRange.data(), outOfRange.size(), parsed) != 3)
+            Fail("out of range shape not reported: %s", line);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Thread pool
+
+// Resizing the pool, as every execution does, while another thread has loops
+// in flight, as a real-time preview does: the resize waits for them, and no
+// task is lost or run twice.
+void TestThreadPool()
+{
+    const int restore = DFParallelThreadCount();
+    std::atomic<bool> done(false);
+    std::atomic<int> wrong(0);
+    std::thread preview([&]() {
+        while (!done.load()) {
+            std::vector<int> hits(4096, 0);
+            DFParallelFor(int(hits.size()), [&](int begin, int end) {
+                for (int i = begin; i < end; i++)
+                    hits[i]++;
+            });
+            wrong += int(std::count_if(hits.begin(), hits.end(), [](int h) { return h != 1; }));
+        }
+    });
+    for (int i = 0; i < 50; i++)
+        DFSetParallelThreadCount(1 + i % 4);
+    done = true;
+    preview.join();
+    DFSetParallelThreadCount(restore);
+    if (wrong.load() > 0)
+        Fail("%d loop items lost or repeated across pool resizes", wrong.load());
+}
+
+// ----------------------------------------------------------------------------
+// Batch pipeline
+
+// A stage that throws stops reading and processing, but the frames processed
+// before it are still written, in order, and the exception reaches the caller.
+void TestPipeline()
+{
+    for (int failing : { 0, 3, 9 }) {
+        std::vector<int> written;
+        bool thrown = false;
+        try {
+            DFRunPipeline<std::vector<int>>(10, 3,
+                [](int i) { return std::vector<int>(1000, i); },
+                [&](int i, std::vector<int>& frame) {
+                    if (i == failing)
+                        throw std::runtime_error("frame failed");
+                    for (int& v : frame)
+                        v++;
+                },
+                [&](int i, std::vector<int>& frame) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                    if (frame[0] == i + 1)
+                        written.push_back(i);
+                });
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        if (!thrown)
+            Fail("pipeline: the failure of frame %d was not rethrown", failing);
+        bool ordered = int(written.size()) == failing;
+        for (size_t i = 0; ordered && (i < written.size()); i++)
+            ordered = written[i] == int(i);
+        if (!ordered)
+            Fail("pipeline: %d frame(s) written before the failure of frame %d, expected %d in order",
+                int(written.size()), failing, failing);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Performance
+
+struct Timing
+{
+    const char* name;
+    std::function<void()> setup;    // not timed
+    std::function<void()> run;
+};
+
+std::map<std::string, double> ReadBaselines(const std::string& path)
+{
+    std::map<std::string, double> baselines;
+    FILE* f = std::fopen(path.c_str(), "r");
+    if (f == nullptr)
+        return baselines;
+    char line[256];
+    while (std::fgets(line, sizeof(line), f) != nullptr) {
+        if ((line[0] == '#') || (line[0] == '\n'))
+            continue;
+        // <seconds> <name>, the name running to the end of the line.
+        char* end;
+        const double seconds = std::strtod(line, &end);
+        if (end == line)
+            continue;
+        std::string name(end);
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t\r\n") + 1);
+        baselines[name] = seconds;
+    }
+    std::fclose(f);
+    return baselines;
+}
+
+bool WriteBaselines(const std::string& path, const std::vector<std::pair<std::string, double>>& timings)
+{
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (f == nullptr)
+        return false;
+    std::fprintf(f, "# Best single-threaded timings, in seconds, on the frame of\n"
+                    "# dustfree_tests --performance. Regenerate with --update-baselines.\n");
+    for (const auto& t : timings)
+        std::fprintf(f, "%.6f %s\n", t.second, t.first.c_str());
+    std::fclose(f);
+    return true;
+}
+
+void TestPerformance(const std::string& baselinePath, double tolerance, bool update)
+{
+    // One thread, so the timings do not depend on the machine load as much.
+    DFSetParallelThreadCount(1);
+    const int size = 1024;
+    const CorpusFrame f = MakeCorpusFrame("rgb 1024x1024", size, size, 3, 11);
+    const int channels = f.frame.channels;
+    const std::vector<const float*> planes = f.frame.Planes();
+    const std::vector<const float*> in = Inputs(f.holed);
+    Planes<float> output(channels, std::vector<float>(size_t(size) * size));
+    const std::vector<float*> out = Outputs(output);
+    std::vector<DFBitMask> masks(channels);
+    std::vector<DFBitMask> detected(channels);
+    DFDetectStars(planes.data(), channels, size, size, StarThreshold, detected.data());
+    Planes<float> work;
+    const double sigma = DFEquivalentGaussianSigma(std::pow(1.7, 2.0), 5.0);
+
+    const std::vector<Timing> timings = {
+        { "star detection", nullptr, [&]() { DFDetectStars(planes.data(), channels, size, size, StarThreshold, masks.data()); } },
+        { "star mask dilation", [&]() { masks = detected; }, [&]() {
+            for (DFBitMask& m : masks)
+                m.Dilate(StarDilation);
+        } },
+        { "ray march", nullptr, [&]() { DFInpaintRayMarch(in.data(), out.data(), channels, size, size, false); } },
+        { "ray march, tiled", nullptr, [&]() { DFInpaintRayMarch(in.data(), out.data(), channels, size, size, true); } },
+        { "nearest sample", nullptr, [&]() {
+            for (int c = 0; c < channels; c++)
+                DFInpaintNearestSample(in[c], out[c], size, size);
+        } },
+        { "push-pull", nullptr, [&]() {
+            for (int c = 0; c < channels; c++)
+                DFInpaintPushPull(in[c], out[c], size, size);
+        } },
+        { "recursive Gaussian", [&]() { work = f.frame.planes; }, [&]() {
+            for (int c = 0; c < channels; c++)
+                DFRecursiveGaussian(work[c].data(), size, size, sigma);
+        } },
+    };
+
+    const std::map<std::string, double> baselines = ReadBaselines(baselinePath);
+    std::vector<std::pair<std::string, double>> measured;
+    for (const Timing& t : timings) {
+        // The best of at least five runs spread over a second, so that a
+        // burst of load on the machine does not decide the outcome.
+        double best = 0;
+        double total = 0;
+        for (int r = 0; (r < 5) || ((total < 1) && (r < 100)); r++) {
+            if (t.setup)
+                t.setup();
+            const auto start = std::chrono::steady_clock::now();
+            t.run();
+            const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best = (r == 0) ? s : std::min(best, s);
+            total += s;
+        }
+        measured.emplace_back(t.name, best);
+        const auto b = baselines.find(t.name);
+        if (b == baselines.end())
+            std::printf("  %-24s %9.4f s, no baseline\n", t.name, best);
+        else {
+            std::printf("  %-24s %9.4f s, baseline %9.4f s, %+6.1f%%\n", t.name, best, b->second,
+                100 * (best / b->second - 1));
+            // The millisecond of slack keeps the shortest kernels clear of
+            // the scheduler.
+            if (!update && (best > b->second * (1 + tolerance) + 0.001))
+                Fail("%s is %.1f%% slower than its baseline, beyond the tolerance of %.0f%%", t.name,
+                    100 * (best / b->second - 1), 100 * tolerance);
+        }
+    }
+    if (update) {
+        if (WriteBaselines(baselinePath, measured))
+            std::printf("  baselines written to %s\n", baselinePath.c_str());
+        else
+            Fail("unable to write %s", baselinePath.c_str());
+    }
+}
+
+void ShowHelp()
+{
+    std::printf(
+        "Usage: dustfree_tests [<options>]\n"
+        "\n"
+        "--equivalence        Runs the kernels against the reference code (the default).\n"
+        "--performance        Times the kernels against their stored baselines.\n"
+        "--baselines=<file>   File of the performance baselines.\n"
+        "--tolerance=<x>      Slowdown allowed over a baseline, as a fraction. The default is 0.25.\n"
+        "--update-baselines   Stores the timings measured as the new baselines.\n"
+        "--verbose            Lists every error measured, not only the failures.\n"
+        "--help               Displays this help and exits.\n");
+}
+
+}	// namespace
+
+int main(int argc, char** argv)
+{
+    bool equivalence = false;
+    bool performance = false;
+    bool update = false;
+    std::string baselinePath = "DustFreePerfBaselines.txt";
+    double tolerance = 0.25;
+    if (const char* env = std::getenv("DUSTFREE_PERF_TOLERANCE"))
+        tolerance = std::atof(env);
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--equivalence")
+            equivalence = true;
+        else if (arg == "--performance")
+            performance = true;
+        else if (arg.compare(0, 12, "--baselines=") == 0)
+            baselinePath = arg.substr(12);
+        else if (arg.compare(0, 12, "--tolerance=") == 0)
+            tolerance = std::atof(arg.c_str() + 12);
+        else if (arg == "--update-baselines")
+            performance = update = true;
+        else if (arg == "--verbose")
+            verbose = true;
+        else if (arg == "--help") {
+            ShowHelp();
+            return 0;
+        } else {
+            std::fprintf(stderr, "Unknown argument: %s\n", arg.c_str());
+            ShowHelp();
+            return 2;
+        }
+    }
+    if (!performance)
+        equivalence = true;
+
+    const std::vector<std::pair<const char*, std::function<void()>>> tests = {
+        { "inpainting", TestInpainting },
+        { "star detection", TestStarDetection },
+        { "mask operations", TestMaskOperations },
+        { "smoothing", TestSmoothing },
+        { "resampling", TestResampling },
+        { "dust shapes", TestDustShapes },
+        { "thread pool", TestThreadPool },
+        { "pipeline", TestPipeline },
+    };
+    if (equivalence)
+        for (const auto& test : tests) {
+            const int before = failures;
+            std::printf("%s\n", test.first);
+            test.second();
+            std::printf("  %s\n", (failures == before) ? "passed" : "FAILED");
+        }
+    if (performance) {
+        std::printf("performance\n");
+        const int before = failures;
+        TestPerformance(baselinePath, tolerance, update);
+        std::printf("  %s\n", (failures == before) ? "passed" : "FAILED");
+    }
+
+    std::printf("%d failure(s)\n", failures);
+    return (failures == 0) ? 0 : 1;
+}